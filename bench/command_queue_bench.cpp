@@ -0,0 +1,186 @@
+// Pushes move commands from several producer threads while a simulation thread drains the
+// queue on a fixed tick, and checks each producer's commands come out in the order pushed.
+// Usage: command-queue-bench [--producers N] [--commands N] [--capacity N] [--tick-us N] [--mutex]
+//   --mutex uses a std::mutex guarded vector with the same interface, for comparison
+
+#include "server/command_queue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    // Baseline: the same push/drain contract behind one lock
+    class MutexCommandQueue
+    {
+    public:
+        explicit MutexCommandQueue(size_t capacity) : capacity_(capacity) {}
+
+        template <typename Fill>
+        bool push(PlayerCommand::Kind kind, PlayerID player_id, Fill &&fill)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.size() >= capacity_)
+            {
+                ++rejected_full_;
+                return false;
+            }
+            PlayerCommand &command = pending_.emplace_back();
+            command.kind = kind;
+            command.player_id = player_id;
+            command.sequence = next_sequence_++;
+            command.received_at = std::chrono::steady_clock::now();
+            fill(command);
+            return true;
+        }
+
+        template <typename Apply>
+        size_t drain(Apply &&apply)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                draining_.swap(pending_);
+            }
+            for (const auto &command : draining_)
+            {
+                apply(command);
+            }
+            size_t count = draining_.size();
+            draining_.clear();
+            return count;
+        }
+
+        std::uint64_t rejected_full() const { return rejected_full_; }
+
+    private:
+        size_t capacity_;
+        std::mutex mutex_;
+        std::vector<PlayerCommand> pending_;
+        std::vector<PlayerCommand> draining_;
+        std::uint64_t next_sequence_{0};
+        std::uint64_t rejected_full_{0};
+    };
+
+    struct Result
+    {
+        std::uint64_t applied{0};
+        std::uint64_t out_of_order{0};
+        std::uint64_t ticks{0};
+        std::uint64_t max_drain{0};
+        double seconds{0};
+        double mean_wait_us{0};
+    };
+
+    template <typename Queue>
+    Result run(Queue &queue, size_t producers, size_t commands_per_producer, std::chrono::microseconds tick)
+    {
+        std::vector<UnitID> unit_ids(8, 1);
+        std::vector<int> last_x(producers + 1, 0);
+        Result result;
+        double total_wait_us = 0;
+
+        auto start_time = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]()
+                                 {
+                                     PlayerID player_id = static_cast<PlayerID>(p + 1);
+                                     for (size_t i = 1; i <= commands_per_producer;)
+                                     {
+                                         bool pushed = queue.push(PlayerCommand::Kind::Move, player_id, [&](PlayerCommand &command)
+                                                                  {
+                                                                      command.x = static_cast<int>(i);
+                                                                      command.unit_ids.assign(unit_ids.begin(), unit_ids.end());
+                                                                  });
+                                         if (pushed)
+                                         {
+                                             ++i;
+                                         }
+                                         else
+                                         {
+                                             std::this_thread::yield();
+                                         }
+                                     } });
+        }
+
+        auto apply = [&](const PlayerCommand &command)
+        {
+            if (command.x <= last_x[command.player_id])
+            {
+                ++result.out_of_order;
+            }
+            last_x[command.player_id] = command.x;
+            total_wait_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - command.received_at).count();
+            ++result.applied;
+        };
+
+        auto next_tick = std::chrono::steady_clock::now();
+        while (result.applied < producers * commands_per_producer)
+        {
+            next_tick += tick;
+            std::this_thread::sleep_until(next_tick);
+            size_t drained = queue.drain(apply);
+            result.max_drain = std::max<std::uint64_t>(result.max_drain, drained);
+            ++result.ticks;
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        result.mean_wait_us = total_wait_us / result.applied;
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        return result;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t producers = 4;
+    size_t commands_per_producer = 250000;
+    size_t capacity = 4096;
+    std::chrono::microseconds tick(1000);
+    bool use_mutex = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--producers") == 0 && i + 1 < argc)
+            producers = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--commands") == 0 && i + 1 < argc)
+            commands_per_producer = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--capacity") == 0 && i + 1 < argc)
+            capacity = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--tick-us") == 0 && i + 1 < argc)
+            tick = std::chrono::microseconds(std::stoul(argv[++i]));
+        else if (std::strcmp(argv[i], "--mutex") == 0)
+            use_mutex = true;
+    }
+
+    Result result;
+    std::uint64_t rejected = 0;
+    if (use_mutex)
+    {
+        MutexCommandQueue queue(capacity);
+        result = run(queue, producers, commands_per_producer, tick);
+        rejected = queue.rejected_full();
+    }
+    else
+    {
+        CommandQueue queue(capacity);
+        result = run(queue, producers, commands_per_producer, tick);
+        rejected = queue.get_stats().rejected_full;
+    }
+
+    std::cout << "queue:                " << (use_mutex ? "mutex" : "lock-free ring") << "\n"
+              << "commands applied:     " << result.applied << "\n"
+              << "commands/sec:         " << static_cast<size_t>(result.applied / result.seconds) << "\n"
+              << "out of order:         " << result.out_of_order << "\n"
+              << "pushes refused full:  " << rejected << "\n"
+              << "ticks:                " << result.ticks << "\n"
+              << "largest drain:        " << result.max_drain << "\n"
+              << "mean queue wait (us): " << result.mean_wait_us << "\n";
+    return result.out_of_order != 0;
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+// Compares the standard and compact wire encodings: bytes per frame and encode/decode cost.
+// Usage: compact-codec-bench [--map N] [--iterations N]
+//   --map is the map width and height in tiles (the server default is 100)
+
+#include "networking/compact_codec.hpp"
+#include "networking/message_utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    // Frames on the wire also carry the 4-byte length prefix
+    constexpr size_t frame_prefix = 4;
+
+    // A selection of count units out of a player's army, in the order a client would list them
+    Message make_move(std::mt19937 &rng, size_t count, const CompactLayout &layout)
+    {
+        std::vector<uint32_t> army(400);
+        for (size_t i = 0; i < army.size(); ++i)
+        {
+            army[i] = 1000 + static_cast<uint32_t>(i) * 3;
+        }
+        std::shuffle(army.begin(), army.end(), rng);
+        army.resize(std::min(count, army.size()));
+        return Message::create_move(rng() % layout.width, rng() % layout.height, army);
+    }
+
+    size_t compact_size(const Message &message, const CompactLayout &layout)
+    {
+        std::vector<uint8_t> out;
+        compact_codec::serialize(message, layout, out);
+        return out.size();
+    }
+
+    bool round_trips(const Message &message, const CompactLayout &layout)
+    {
+        std::vector<uint8_t> out;
+        compact_codec::serialize(message, layout, out);
+        MessageView view;
+        if (!Message::parse(out.data(), out.size(), view))
+        {
+            return false;
+        }
+        std::vector<uint8_t> expanded(view.data, view.data + view.size);
+        if (view.compact && compact_codec::has_compact_payload(view.type) &&
+            !compact_codec::expand(view, layout, expanded))
+        {
+            return false;
+        }
+
+        // Move orders come back with their unit ids sorted
+        std::vector<uint8_t> expected = message.data;
+        if (message.type == MessageType::PlayerMove)
+        {
+            uint32_t *ids = reinterpret_cast<uint32_t *>(expected.data() + 3 * sizeof(uint32_t));
+            std::sort(ids, ids + (expected.size() / sizeof(uint32_t) - 3));
+        }
+        return view.type == message.type && expanded == expected;
+    }
+
+    template <typename Fn>
+    double nanoseconds_per_call(size_t iterations, Fn fn)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            fn();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count() / iterations;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint16_t map_size = 100;
+    size_t iterations = 200000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--map") == 0 && i + 1 < argc)
+            map_size = static_cast<uint16_t>(std::stoul(argv[++i]));
+        else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = std::stoul(argv[++i]);
+    }
+
+    const CompactLayout layout(map_size, map_size);
+    std::mt19937 rng(7);
+    std::vector<std::pair<std::string, Message>> samples;
+    for (size_t count : {1, 10, 50, 100, 200})
+    {
+        samples.emplace_back("move, " + std::to_string(count) + " units", make_move(rng, count, layout));
+    }
+    samples.emplace_back("build", Message::create_build(42, 17, 3));
+    samples.emplace_back("attack", Message::create_attack(1204, 2210));
+    samples.emplace_back("harvest", Message::create_harvest(1003, 12));
+    samples.emplace_back("chat \"gg\"", Message::create_chat("gg", false));
+    samples.emplace_back("snapshot ack", Message::create_snapshot_ack(4812));
+
+    std::cout << "map " << map_size << "x" << map_size << ", bytes per frame including the length prefix\n"
+              << std::left << std::setw(22) << "message" << std::right << std::setw(10) << "standard"
+              << std::setw(10) << "compact" << std::setw(8) << "ratio" << "\n";
+    bool all_round_trip = true;
+    for (const auto &[name, message] : samples)
+    {
+        size_t standard = frame_prefix + message.serialize().size();
+        size_t compact = frame_prefix + compact_size(message, layout);
+        all_round_trip = all_round_trip && round_trips(message, layout);
+        std::cout << std::left << std::setw(22) << name << std::right << std::setw(10) << standard
+                  << std::setw(10) << compact << std::setw(8) << std::fixed << std::setprecision(2)
+                  << static_cast<double>(compact) / standard << "\n";
+    }
+    std::cout << "round trip:           " << (all_round_trip ? "ok" : "MISMATCH") << "\n\n";
+
+    // Microbenchmarks on a 50-unit move order
+    const Message move = make_move(rng, 50, layout);
+    const std::vector<uint8_t> standard_frame = move.serialize();
+    std::vector<uint8_t> compact_frame;
+    compact_codec::serialize(move, layout, compact_frame);
+    std::vector<uint8_t> out;
+    size_t sink = 0;
+
+    double standard_encode = nanoseconds_per_call(iterations, [&]()
+                                                  { sink += move.serialize().size(); });
+    double compact_encode = nanoseconds_per_call(iterations, [&]()
+                                                 {
+        out.clear();
+        compact_codec::serialize(move, layout, out);
+        sink += out.size(); });
+    Message sorted_move = move;
+    uint32_t *sorted_ids = reinterpret_cast<uint32_t *>(sorted_move.data.data() + 3 * sizeof(uint32_t));
+    std::sort(sorted_ids, sorted_ids + 50);
+    double sorted_encode = nanoseconds_per_call(iterations, [&]()
+                                                {
+        out.clear();
+        compact_codec::serialize(sorted_move, layout, out);
+        sink += out.size(); });
+    double standard_decode = nanoseconds_per_call(iterations, [&]()
+                                                  {
+        MessageView view;
+        Message::parse(standard_frame.data(), standard_frame.size(), view);
+        size_t offset = 2 * sizeof(int);
+        uint32_t count = 0;
+        message_utils::read_from_view(view, offset, count);
+        sink += count; });
+    double compact_decode = nanoseconds_per_call(iterations, [&]()
+                                                 {
+        MessageView view;
+        Message::parse(compact_frame.data(), compact_frame.size(), view);
+        compact_codec::expand(view, layout, out);
+        sink += out.size(); });
+
+    std::cout << "50-unit move, ns/message\n"
+              << "encode standard:      " << standard_encode << "\n"
+              << "encode compact:       " << compact_encode << "\n"
+              << "encode compact:       " << sorted_encode << " (ids already sorted)\n"
+              << "decode standard:      " << standard_decode << " (parse only, payload read in place)\n"
+              << "decode compact:       " << compact_decode << " (parse + expand to standard layout)\n";
+    return sink == 0;
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+// Measures payload compression on server traffic: snapshots, upgrade lists and chat relays.
+// Usage: compression-bench [--ticks N] [--units N] [--level N] [--threshold N]
+//   --units is per player (8 players); one client is followed, acknowledging 3 ticks late
+//   --level is the zlib level (1 fastest, 9 smallest)
+//   --threshold is the smallest payload compressed, as ClientConnection applies it
+
+#include "networking/payload_compressor.hpp"
+#include "server/snapshot.hpp"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+
+namespace
+{
+    struct Totals
+    {
+        size_t messages{0};
+        size_t raw_bytes{0};
+        size_t bytes{0};
+        double compress_seconds{0};
+        double decompress_seconds{0};
+        size_t mismatches{0};
+    };
+
+    // Compresses every frame above the threshold, either on one stream or on a fresh stream each
+    void run(const std::vector<std::vector<uint8_t>> &frames, int level, size_t threshold, bool streaming,
+             Totals &totals)
+    {
+        auto compressor = std::make_unique<PayloadCompressor>(level);
+        auto decompressor = std::make_unique<PayloadDecompressor>();
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> payload;
+        for (const auto &frame : frames)
+        {
+            MessageView message;
+            Message::parse(frame.data(), frame.size(), message);
+            totals.messages++;
+            totals.raw_bytes += frame.size();
+            if (message.size < threshold)
+            {
+                totals.bytes += frame.size();
+                continue;
+            }
+            if (!streaming)
+            {
+                compressor = std::make_unique<PayloadCompressor>(level);
+                decompressor = std::make_unique<PayloadDecompressor>();
+            }
+
+            auto start_time = std::chrono::steady_clock::now();
+            compressed.clear();
+            compressor->compress(message, compressed);
+            auto compressed_time = std::chrono::steady_clock::now();
+
+            MessageView received;
+            bool ok = Message::parse(compressed.data(), compressed.size(), received) && received.compressed &&
+                      decompressor->decompress(received.data, received.size, 1024 * 1024, payload);
+            auto decompressed_time = std::chrono::steady_clock::now();
+
+            totals.bytes += compressed.size();
+            totals.compress_seconds += std::chrono::duration<double>(compressed_time - start_time).count();
+            totals.decompress_seconds += std::chrono::duration<double>(decompressed_time - compressed_time).count();
+            if (!ok || received.type != message.type || payload.size() != message.size ||
+                std::memcmp(payload.data(), message.data, message.size) != 0)
+            {
+                ++totals.mismatches;
+            }
+        }
+    }
+
+    void print(const std::string &name, const Totals &totals)
+    {
+        std::cout << std::left << std::setw(30) << name << std::right << std::setw(12) << totals.bytes
+                  << std::setw(8) << std::fixed << std::setprecision(3)
+                  << static_cast<double>(totals.bytes) / totals.raw_bytes << std::setw(12) << std::setprecision(1)
+                  << totals.compress_seconds * 1e9 / totals.raw_bytes << std::setw(12)
+                  << totals.decompress_seconds * 1e9 / totals.raw_bytes << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t tick_count = 300;
+    size_t units_per_player = 250;
+    int level = Z_BEST_SPEED;
+    size_t threshold = 256;
+    for (int i = 1; i < argc; ++i)
+    {
+        auto next = [&]()
+        { return i + 1 < argc ? std::stoul(argv[++i]) : 0; };
+        if (std::strcmp(argv[i], "--ticks") == 0)
+            tick_count = next();
+        else if (std::strcmp(argv[i], "--units") == 0)
+            units_per_player = next();
+        else if (std::strcmp(argv[i], "--level") == 0)
+            level = static_cast<int>(next());
+        else if (std::strcmp(argv[i], "--threshold") == 0)
+            threshold = next();
+    }
+
+    // The traffic one client sees: a snapshot per tick, now and then an upgrade list or a chat line
+    std::mt19937 rng(42);
+    GameState game_state;
+    ResourceManager resource_manager;
+    for (PlayerID player_id = 1; player_id <= 8; ++player_id)
+    {
+        for (size_t i = 0; i < units_per_player; ++i)
+        {
+            game_state.spawn_unit(player_id, UnitType::Soldier, rng() % 100, rng() % 100, 100);
+        }
+        resource_manager.add_resource(player_id, "Gold", 1000);
+        resource_manager.add_resource(player_id, "Wood", 500);
+        game_state.update_player_score(player_id, 0);
+    }
+
+    SnapshotEncoder encoder;
+    SnapshotDecoder decoder(1);
+    std::vector<uint32_t> acks(tick_count + 4, 0);
+    std::vector<std::vector<uint8_t>> frames;
+    const std::vector<std::string> upgrades = {"weapon", "armor", "training", "resource", "defense"};
+    const std::vector<std::string> technologies = {"Basic Smithing", "Basic Armory", "Military Tactics"};
+    const std::vector<std::string> chat_lines = {"attack the north gate at dawn", "need wood", "gg",
+                                                 "bring the catapults to the east wall", "retreat to the keep"};
+    for (size_t tick = 0; tick < tick_count; ++tick)
+    {
+        std::vector<UnitID> ids;
+        for (const auto &[id, handle] : game_state.get_unit_handles())
+        {
+            ids.push_back(id);
+        }
+        for (size_t i = 0; i < ids.size() / 10; ++i)
+        {
+            UnitRef unit = game_state.get_unit(ids[rng() % ids.size()]);
+            int x;
+            int y;
+            unit.get_position(x, y);
+            unit.set_position(x + static_cast<int>(rng() % 3) - 1, y + static_cast<int>(rng() % 3) - 1);
+        }
+        resource_manager.add_resource(1, "Gold", 1);
+
+        encoder.capture(game_state, resource_manager);
+        Message snapshot = encoder.encode(1);
+        frames.push_back(snapshot.serialize());
+        decoder.apply(snapshot.view());
+        acks[tick + 3] = decoder.latest()->sequence;
+        if (acks[tick])
+        {
+            encoder.acknowledge(1, acks[tick]);
+        }
+
+        if (tick % 20 == 0)
+        {
+            frames.push_back(Message::create_upgrade_list_response(upgrades, technologies).serialize());
+        }
+        if (tick % 7 == 0)
+        {
+            const std::string &text = chat_lines[rng() % chat_lines.size()];
+            frames.push_back(Message::create_chat_broadcast(rng() % 8 + 1, text, false).serialize());
+        }
+    }
+
+    std::cout << frames.size() << " messages, zlib level " << level << ", threshold " << threshold << " bytes\n"
+              << std::left << std::setw(30) << "" << std::right << std::setw(12) << "bytes" << std::setw(8)
+              << "ratio" << std::setw(12) << "deflate" << std::setw(12) << "inflate" << "\n"
+              << std::left << std::setw(30) << "" << std::right << std::setw(12) << "" << std::setw(8) << ""
+              << std::setw(12) << "ns/byte" << std::setw(12) << "ns/byte" << "\n";
+
+    Totals raw;
+    run(frames, level, std::numeric_limits<size_t>::max(), true, raw);
+    std::cout << std::left << std::setw(30) << "uncompressed" << std::right << std::setw(12) << raw.bytes << "\n";
+
+    Totals independent;
+    run(frames, level, threshold, false, independent);
+    print("fresh stream per message", independent);
+
+    Totals streaming;
+    run(frames, level, threshold, true, streaming);
+    print("one stream per connection", streaming);
+
+    std::cout << "round trip mismatches:        " << independent.mismatches + streaming.mismatches << "\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+// Compares the slot-map connection registry with the vector plus std::map pair it replaced.
+// Usage: connection-registry-bench [--sessions N] [--rounds N]
+//   lookup: targeted sends to random live sessions; fan-out: one pass over every session;
+//   churn: one session leaves and another joins. The old vector was never pruned, so its
+//   churn figure excludes the removal it never did.
+
+#include "utils/slot_map.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+
+namespace
+{
+    struct Session
+    {
+        std::uint64_t sends{0};
+        bool connected{true};
+    };
+
+    template <typename Fn>
+    double nanoseconds_per_call(size_t iterations, Fn fn)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            fn(i);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count() / iterations;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t session_count = 10000;
+    size_t rounds = 200;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--sessions") == 0 && i + 1 < argc)
+            session_count = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--rounds") == 0 && i + 1 < argc)
+            rounds = std::stoul(argv[++i]);
+    }
+
+    std::mt19937 random(42);
+    SlotMap<std::shared_ptr<Session>> registry;
+    std::vector<std::shared_ptr<Session>> clients;
+    std::map<std::uint32_t, std::shared_ptr<Session>> connections;
+    std::vector<std::uint32_t> handles;
+    for (size_t i = 0; i < session_count; ++i)
+    {
+        auto session = std::make_shared<Session>();
+        handles.push_back(registry.insert(session));
+        clients.push_back(session);
+        connections.emplace(static_cast<std::uint32_t>(i + 1), session);
+    }
+
+    const size_t lookups = session_count * rounds;
+    std::vector<std::uint32_t> picks(lookups);
+    for (auto &pick : picks)
+    {
+        pick = static_cast<std::uint32_t>(random() % session_count);
+    }
+
+    double slot_lookup = nanoseconds_per_call(lookups, [&](size_t i)
+                                              {
+        if (auto *session = registry.get(handles[picks[i]]))
+        {
+            ++(*session)->sends;
+        } });
+    double map_lookup = nanoseconds_per_call(lookups, [&](size_t i)
+                                             {
+        auto it = connections.find(picks[i] + 1);
+        if (it != connections.end())
+        {
+            ++it->second->sends;
+        } });
+
+    double slot_fanout = nanoseconds_per_call(rounds, [&](size_t)
+                                              {
+        for (auto &session : registry)
+        {
+            if (session->connected)
+            {
+                ++session->sends;
+            }
+        } });
+    double vector_fanout = nanoseconds_per_call(rounds, [&](size_t)
+                                                {
+        for (auto &session : clients)
+        {
+            if (session && session->connected)
+            {
+                ++session->sends;
+            }
+        } });
+
+    // Churn: the oldest session leaves and a new one joins
+    size_t oldest = 0;
+    double slot_churn = nanoseconds_per_call(lookups, [&](size_t)
+                                             {
+        registry.remove(handles[oldest]);
+        handles[oldest] = registry.insert(std::make_shared<Session>());
+        oldest = (oldest + 1) % session_count; });
+    std::uint32_t next_id = static_cast<std::uint32_t>(session_count + 1);
+    double map_churn = nanoseconds_per_call(lookups, [&](size_t)
+                                            {
+        connections.erase(connections.begin());
+        auto session = std::make_shared<Session>();
+        connections.emplace(next_id++, session);
+        clients.push_back(std::move(session)); });
+
+    // Stale handles must not resolve after their slot is reused
+    size_t stale_hits = 0;
+    SlotMap<int> probe;
+    SlotMap<int>::Handle stale = probe.insert(1);
+    probe.remove(stale);
+    probe.insert(2);
+    stale_hits += probe.get(stale) != nullptr;
+
+    std::cout << "sessions:                  " << session_count << "\n"
+              << "ns per operation           slot map\tvector + std::map\n"
+              << "targeted lookup            " << slot_lookup << "\t" << map_lookup << "\n"
+              << "fan-out, all sessions      " << slot_fanout << "\t" << vector_fanout << "\n"
+              << "leave + join               " << slot_churn << "\t" << map_churn << "\n"
+              << "old vector after churn:    " << clients.size() << " entries for " << connections.size() << " sessions\n"
+              << "stale handle resolved:     " << (stale_hits ? "YES" : "no") << "\n";
+    return stale_hits != 0;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+// Counts heap allocations per inbound message on the ClientConnection read path.
+// Usage: inbound-alloc-bench [message_count] [--copy] [--chunk N]
+//   --copy copies each move's unit ids into an owning vector, as the pre-MessageView path did
+//   --chunk writes the stream N bytes at a time, so frames arrive split across reads
+
+#include "networking/client_connection.hpp"
+#include "networking/buffer_pool.hpp"
+#include "networking/message_utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+namespace
+{
+    std::atomic<size_t> allocation_count{0};
+
+    // Dispatch target; counts moves and checks each is delivered exactly once
+    struct MoveCounter
+    {
+        bool copy_messages{false};
+        size_t warmup_count{0};
+        size_t messages_received{0};
+        size_t duplicates{0};
+        size_t copied_bytes{0};
+        int last_sequence{0};
+        size_t allocations_at_warmup{0};
+        std::chrono::steady_clock::time_point start_time;
+
+        void on_move(ClientConnection &, const payload::Move &move)
+        {
+            if (copy_messages)
+            {
+                std::vector<uint32_t> owned = move.unit_ids.to_vector();
+                copied_bytes += owned.size() * sizeof(uint32_t);
+            }
+            if (move.x == last_sequence)
+            {
+                ++duplicates;
+            }
+            last_sequence = move.x;
+
+            if (++messages_received == warmup_count)
+            {
+                allocations_at_warmup = allocation_count.load();
+                start_time = std::chrono::steady_clock::now();
+            }
+        }
+    };
+}
+
+void *operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t message_count = 200000;
+    bool copy_messages = false;
+    size_t chunk_size = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--copy") == 0)
+        {
+            copy_messages = true;
+        }
+        else if (std::strcmp(argv[i], "--chunk") == 0 && i + 1 < argc)
+        {
+            chunk_size = std::stoul(argv[++i]);
+        }
+        else
+        {
+            message_count = std::stoul(argv[i]);
+        }
+    }
+    const size_t warmup_count = std::min<size_t>(1000, message_count / 10);
+
+    boost::asio::io_context io_context;
+    tcp::acceptor acceptor(io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    tcp::socket client(io_context);
+    client.connect(acceptor.local_endpoint());
+    tcp::socket server_side = acceptor.accept();
+
+    // Each move carries its sequence number in x, so a duplicate handler call shows up
+    std::vector<uint8_t> stream;
+    std::vector<uint32_t> unit_ids(20);
+    for (size_t i = 0; i < unit_ids.size(); ++i)
+    {
+        unit_ids[i] = static_cast<uint32_t>(i + 1);
+    }
+    for (size_t i = 0; i < message_count; ++i)
+    {
+        message_utils::write_frame(stream, Message::create_move(static_cast<int>(i + 1), 0, unit_ids));
+    }
+
+    MoveCounter counter;
+    counter.copy_messages = copy_messages;
+    counter.warmup_count = warmup_count;
+    auto dispatcher = std::make_shared<MessageDispatcher>();
+    dispatcher->on<payload::Move, &MoveCounter::on_move>(&counter);
+
+    auto pool = std::make_shared<BufferPool>(16 * 1024, 4);
+    auto connection = std::make_shared<ClientConnection>(std::move(server_side), 1, pool);
+    connection->set_authenticated(true);
+    connection->set_dispatcher(dispatcher);
+    connection->start();
+
+    std::thread writer([&client, &stream, chunk_size]()
+                       {
+                           size_t step = chunk_size ? chunk_size : stream.size();
+                           for (size_t offset = 0; offset < stream.size(); offset += step)
+                           {
+                               size_t length = std::min(step, stream.size() - offset);
+                               boost::asio::write(client, boost::asio::buffer(stream.data() + offset, length));
+                           }
+                       });
+
+    while (counter.messages_received < message_count && io_context.run_one())
+    {
+    }
+    auto elapsed = std::chrono::steady_clock::now() - counter.start_time;
+    size_t allocations = allocation_count.load() - counter.allocations_at_warmup;
+    writer.join();
+    const auto &stats = connection->get_stats();
+
+    size_t measured = counter.messages_received - warmup_count;
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << "path:                 " << (copy_messages ? "owning copy" : "pooled view") << "\n"
+              << "messages measured:    " << measured << "\n"
+              << "allocations:          " << allocations << "\n"
+              << "allocations/message:  " << static_cast<double>(allocations) / measured << "\n"
+              << "messages/sec:         " << static_cast<size_t>(measured / seconds) << "\n"
+              << "reads/message:        " << static_cast<double>(stats.reads) / stats.messages_received << "\n"
+              << "duplicate deliveries: " << counter.duplicates << "\n"
+              << "bytes copied:         " << counter.copied_bytes << "\n";
+
+    connection->stop();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+// Compares lockstep turns with delta snapshots, and checks that peers stay in step.
+// Usage: lockstep-bench [--players N] [--units N] [--ticks N] [--desync-turn N]
+//   --units is per player; the orders are SyntheticMatch's (synthetic_match.hpp). The server
+//   applies each tick's commands and builds the turn; one peer per player loads a keyframe,
+//   applies every turn and reports its checksum.
+//   --desync-turn corrupts the first peer's world just before that turn's checksum, 0 for none;
+//   the run fails unless the verifier reports exactly that turn and no other peer diverges.
+
+#include "server/lockstep.hpp"
+#include "server/simulation.hpp"
+#include "server/snapshot.hpp"
+#include "networking/message_payloads.hpp"
+#include "synthetic_match.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    double elapsed_ns(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t player_count = 8;
+    size_t units_per_player = 250;
+    size_t tick_count = 600;
+    uint32_t desync_turn = 300;
+    for (int i = 1; i < argc; ++i)
+    {
+        auto next = [&]()
+        { return i + 1 < argc ? std::stoul(argv[++i]) : 0; };
+        if (std::strcmp(argv[i], "--players") == 0)
+            player_count = std::max<size_t>(2, next());
+        else if (std::strcmp(argv[i], "--units") == 0)
+            units_per_player = next();
+        else if (std::strcmp(argv[i], "--ticks") == 0)
+            tick_count = next();
+        else if (std::strcmp(argv[i], "--desync-turn") == 0)
+            desync_turn = static_cast<uint32_t>(next());
+    }
+
+    SyntheticMatch match(player_count, units_per_player, 7);
+    GameState game_state;
+    ResourceManager resource_manager;
+    match.populate(game_state);
+
+    // Peers start from the keyframe every new member gets
+    SnapshotEncoder encoder;
+    encoder.capture(game_state, resource_manager);
+    std::vector<LockstepPeer> peers(player_count);
+    for (PlayerID player = 1; player <= player_count; ++player)
+    {
+        Message keyframe = encoder.encode(player);
+        if (!peers[player - 1].load(player, keyframe.view()))
+        {
+            std::cerr << "peer " << player << " could not load the keyframe" << std::endl;
+            return 1;
+        }
+        encoder.acknowledge(player, 1);
+    }
+
+    LockstepTurnBuilder builder;
+    LockstepVerifier verifier;
+    std::vector<PlayerCommand> commands;
+    uint64_t turn_bytes = 0;
+    uint64_t snapshot_bytes = 0;
+    uint64_t command_count = 0;
+    double build_time = 0;
+    double apply_time = 0;
+    double checksum_time = 0;
+    bool failed = false;
+
+    for (size_t tick = 0; tick < tick_count; ++tick)
+    {
+        match.next_tick(game_state, commands);
+        command_count += commands.size();
+
+        // Server: apply and build the turn, as Room::run_turn does
+        auto start_time = std::chrono::steady_clock::now();
+        builder.begin(game_state.get_turn() + 1);
+        for (const auto &command : commands)
+        {
+            simulation::apply_command(game_state, resource_manager, command);
+            builder.add(command);
+        }
+        game_state.advance_turn();
+        Message turn = builder.finish();
+        build_time += elapsed_ns(start_time);
+        start_time = std::chrono::steady_clock::now();
+        uint64_t checksum = game_state.checksum();
+        checksum_time += elapsed_ns(start_time);
+        verifier.record(game_state.get_turn(), checksum);
+        std::vector<uint8_t> turn_wire = turn.serialize();
+        turn_bytes += turn_wire.size() * player_count;
+
+        // The same tick as delta snapshots, every client acknowledging at once
+        const WorldSnapshot &snapshot = encoder.capture(game_state, resource_manager);
+        for (PlayerID player = 1; player <= player_count; ++player)
+        {
+            snapshot_bytes += encoder.encode(player).serialize().size();
+            encoder.acknowledge(player, snapshot.sequence);
+        }
+
+        for (PlayerID player = 1; player <= player_count; ++player)
+        {
+            LockstepPeer &peer = peers[player - 1];
+            start_time = std::chrono::steady_clock::now();
+            if (!peer.apply(turn.view()))
+            {
+                std::cerr << "peer " << player << " rejected turn " << game_state.get_turn() << std::endl;
+                return 1;
+            }
+            apply_time += elapsed_ns(start_time);
+            if (player == 1 && peer.get_turn() == desync_turn && peer.get_game_state().get_unit_count() > 0)
+            {
+                UnitID first = peer.get_game_state().get_unit_handles().begin()->first;
+                UnitRef unit = peer.get_game_state().get_unit(first);
+                unit.set_health(unit.get_health() + 1);
+            }
+
+            Message hash = peer.create_state_hash();
+            payload::StateHash report{};
+            if (!message_schema::decode(hash.view(), report))
+            {
+                std::cerr << "peer " << player << " sent an unreadable state hash" << std::endl;
+                return 1;
+            }
+            uint64_t expected = 0;
+            LockstepCheck check = verifier.report(player, report.turn, report.checksum, expected);
+            if (check == LockstepCheck::Diverged && (player != 1 || report.turn != desync_turn))
+            {
+                std::cerr << "peer " << player << " diverged at turn " << report.turn << std::endl;
+                failed = true;
+            }
+        }
+    }
+
+    LockstepStats stats = verifier.get_stats();
+    LockstepVerifier::Peer first_peer;
+    verifier.get_peer(1, first_peer);
+    bool detected = desync_turn == 0 || desync_turn > tick_count
+                        ? stats.desyncs == 0
+                        : stats.desyncs == 1 && first_peer.first_bad_turn == desync_turn &&
+                              first_peer.last_good_turn == desync_turn - 1;
+    double per_tick = static_cast<double>(tick_count) * player_count;
+
+    std::cout << "players:                   " << player_count << ", " << units_per_player << " units each, "
+              << game_state.get_unit_count() << " left after " << tick_count << " turns\n"
+              << "commands per turn:         " << static_cast<double>(command_count) / tick_count << "\n"
+              << "bytes per client per tick: " << turn_bytes / per_tick << " lockstep turn, "
+              << snapshot_bytes / per_tick << " delta snapshot\n"
+              << "server turn, us:           " << build_time / tick_count / 1000 << " apply and build, "
+              << checksum_time / tick_count / 1000 << " checksum\n"
+              << "peer turn, us:             " << apply_time / per_tick / 1000 << " apply\n"
+              << "hashes checked:            " << stats.hashes_checked << ", " << stats.desyncs << " desynced";
+    if (stats.desyncs)
+    {
+        std::cout << ", first at turn " << stats.first_divergent_turn << " (peer 1 last matched turn "
+                  << first_peer.last_good_turn << ")";
+    }
+    std::cout << "\n";
+    if (!detected)
+    {
+        std::cerr << "expected a desync at turn " << desync_turn << " only" << std::endl;
+    }
+    return failed || !detected;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+// Compares schema-generated encoders and decoders with the hand-written style they replaced.
+// Usage: message-schema-bench [--iterations N]
+//   hand-written encoders append field by field; hand-written decoders check each field with
+//   message_utils' readers
+
+#include "networking/message_payloads.hpp"
+#include "networking/message_utils.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+using namespace message_utils;
+
+namespace
+{
+    Message hand_move(int x, int y, const std::vector<uint32_t> &unit_ids)
+    {
+        Message msg;
+        msg.type = MessageType::PlayerMove;
+        write_to_vector(msg.data, x);
+        write_to_vector(msg.data, y);
+        write_to_vector(msg.data, static_cast<uint32_t>(unit_ids.size()));
+        for (const auto &id : unit_ids)
+        {
+            write_to_vector(msg.data, id);
+        }
+        return msg;
+    }
+
+    Message hand_upgrade_response(bool success, const std::string &upgrade_name, int new_level)
+    {
+        Message msg;
+        msg.type = MessageType::UpgradeResponse;
+        write_to_vector(msg.data, success);
+        write_string(msg.data, upgrade_name);
+        write_to_vector(msg.data, new_level);
+        return msg;
+    }
+
+    template <typename Fn>
+    double nanoseconds_per_call(size_t iterations, Fn fn)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            fn();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count() / iterations;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t iterations = 1000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = std::stoul(argv[++i]);
+    }
+
+    std::vector<uint32_t> unit_ids(50);
+    for (size_t i = 0; i < unit_ids.size(); ++i)
+    {
+        unit_ids[i] = 1000 + static_cast<uint32_t>(i) * 3;
+    }
+    const std::string upgrade_name = "weapon";
+    size_t sink = 0;
+
+    const Message move = message_schema::encode(payload::Move{12, 34, unit_ids});
+    const Message response = message_schema::encode(payload::UpgradeResponse{true, upgrade_name, 3});
+    bool same_bytes = move.data == hand_move(12, 34, unit_ids).data &&
+                      response.data == hand_upgrade_response(true, upgrade_name, 3).data;
+
+    double hand_move_encode = nanoseconds_per_call(iterations, [&]()
+                                                   { sink += hand_move(12, 34, unit_ids).data.size(); });
+    double schema_move_encode = nanoseconds_per_call(iterations, [&]()
+                                                     { sink += message_schema::encode(payload::Move{12, 34, unit_ids}).data.size(); });
+    double hand_response_encode = nanoseconds_per_call(iterations, [&]()
+                                                       { sink += hand_upgrade_response(true, upgrade_name, 3).data.size(); });
+    double schema_response_encode = nanoseconds_per_call(iterations, [&]()
+                                                         { sink += message_schema::encode(payload::UpgradeResponse{true, upgrade_name, 3}).data.size(); });
+
+    const MessageView move_view = move.view();
+    const MessageView response_view = response.view();
+    double hand_move_decode = nanoseconds_per_call(iterations, [&]()
+                                                   {
+        size_t offset = 0;
+        int x = 0, y = 0;
+        uint32_t count = 0;
+        if (!read_from_view(move_view, offset, x) || !read_from_view(move_view, offset, y) ||
+            !read_from_view(move_view, offset, count))
+        {
+            return;
+        }
+        uint32_t total = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t id = 0;
+            if (!read_from_view(move_view, offset, id))
+            {
+                return;
+            }
+            total += id;
+        }
+        sink += x + y + total; });
+    double schema_move_decode = nanoseconds_per_call(iterations, [&]()
+                                                     {
+        payload::Move decoded;
+        if (message_schema::decode(move_view, decoded))
+        {
+            uint32_t total = 0;
+            for (uint32_t id : decoded.unit_ids)
+            {
+                total += id;
+            }
+            sink += decoded.x + decoded.y + total;
+        } });
+    double hand_response_decode = nanoseconds_per_call(iterations, [&]()
+                                                       {
+        size_t offset = 0;
+        bool success = false;
+        std::string name;
+        int level = 0;
+        if (read_from_view(response_view, offset, success) && read_string(response_view, offset, name) &&
+            read_from_view(response_view, offset, level))
+        {
+            sink += success + name.size() + level;
+        } });
+    double schema_response_decode = nanoseconds_per_call(iterations, [&]()
+                                                         {
+        payload::UpgradeResponse decoded;
+        if (message_schema::decode(response_view, decoded))
+        {
+            sink += decoded.success + decoded.upgrade_name.size() + decoded.new_level;
+        } });
+
+    std::cout << "wire bytes identical:  " << (same_bytes ? "yes" : "NO") << "\n"
+              << "ns/message                hand-written   schema\n"
+              << "encode move, 50 units     " << hand_move_encode << "\t" << schema_move_encode << "\n"
+              << "encode upgrade response   " << hand_response_encode << "\t" << schema_response_encode << "\n"
+              << "decode move, 50 units     " << hand_move_decode << "\t" << schema_move_decode << "\n"
+              << "decode upgrade response   " << hand_response_decode << "\t" << schema_response_decode << " (no copy)\n";
+    return sink == 0;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+// Records a synthetic match to a replay file, then measures playback and seeking.
+// Usage: replay-bench [--players N] [--units N] [--ticks N] [--keyframe-interval N] [--file PATH]
+//   --units is per player; the orders are SyntheticMatch's (synthetic_match.hpp), as in
+//   lockstep-bench. Ticks run at 20 a second, so the default 12000 is a ten-minute match.
+//   Seeks go to random ticks, from the end of the match, and are compared with playing from the
+//   first keyframe; both must reach the world the match had at that tick.
+
+#include "server/lockstep.hpp"
+#include "server/replay.hpp"
+#include "server/simulation.hpp"
+#include "synthetic_match.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    double elapsed_us(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t player_count = 8;
+    size_t units_per_player = 250;
+    size_t tick_count = 12000;
+    uint32_t keyframe_interval = ReplayRecorder::default_keyframe_interval;
+    std::string path = "replay-bench.replay";
+    for (int i = 1; i < argc; ++i)
+    {
+        auto next = [&]()
+        { return i + 1 < argc ? std::stoul(argv[++i]) : 0; };
+        if (std::strcmp(argv[i], "--players") == 0)
+            player_count = std::max<size_t>(2, next());
+        else if (std::strcmp(argv[i], "--units") == 0)
+            units_per_player = next();
+        else if (std::strcmp(argv[i], "--ticks") == 0)
+            tick_count = std::max<size_t>(1, next());
+        else if (std::strcmp(argv[i], "--keyframe-interval") == 0)
+            keyframe_interval = static_cast<uint32_t>(next());
+        else if (std::strcmp(argv[i], "--file") == 0 && i + 1 < argc)
+            path = argv[++i];
+    }
+    const unsigned tick_rate = 20;
+
+    SyntheticMatch match(player_count, units_per_player, 11);
+    GameState game_state;
+    ResourceManager resource_manager;
+    match.populate(game_state);
+
+    ReplayRecorder recorder(keyframe_interval);
+    if (!recorder.open(path, ReplayHeader{100, 100, tick_rate}, game_state, resource_manager))
+    {
+        return 1;
+    }
+
+    // The match, as a room would run it; the world's checksum after every tick is kept to check
+    // seeks against
+    std::vector<uint64_t> checksums{game_state.checksum()};
+    std::vector<PlayerCommand> commands;
+    LockstepTurnBuilder builder;
+    uint64_t turn_bytes = 0;
+    double record_time = 0;
+    for (size_t tick = 0; tick < tick_count; ++tick)
+    {
+        match.next_tick(game_state, commands);
+
+        builder.begin(game_state.get_turn() + 1);
+        auto start_time = std::chrono::steady_clock::now();
+        for (const auto &command : commands)
+        {
+            simulation::apply_command(game_state, resource_manager, command);
+            recorder.add(command);
+        }
+        game_state.advance_turn();
+        recorder.end_tick(game_state, resource_manager);
+        record_time += elapsed_us(start_time);
+        for (const auto &command : commands)
+        {
+            builder.add(command);
+        }
+        turn_bytes += builder.finish().serialize().size();
+        checksums.push_back(game_state.checksum());
+    }
+    recorder.close(game_state);
+    const ReplayRecorderStats &recorded = recorder.get_stats();
+
+    bool failed = false;
+    ReplayPlayer player;
+    if (!player.open(path))
+    {
+        return 1;
+    }
+    auto start_time = std::chrono::steady_clock::now();
+    failed |= !player.play_to(static_cast<uint32_t>(tick_count));
+    double play_time = elapsed_us(start_time);
+    const ReplayStats &played = player.get_stats();
+    failed |= played.mismatches != 0 || !player.is_complete() || player.get_game_state().checksum() != checksums.back();
+
+    // Random seeks, against opening the file and playing from the start each time
+    std::mt19937 random(11);
+    const size_t seek_count = 50;
+    double seek_time = 0;
+    double from_start_time = 0;
+    for (size_t i = 0; i < seek_count; ++i)
+    {
+        uint32_t target = static_cast<uint32_t>(random() % (tick_count + 1));
+        start_time = std::chrono::steady_clock::now();
+        failed |= !player.seek(target);
+        seek_time += elapsed_us(start_time);
+        failed |= player.get_tick() != target || player.get_game_state().checksum() != checksums[target];
+
+        ReplayPlayer from_start;
+        start_time = std::chrono::steady_clock::now();
+        failed |= !from_start.open(path) || !from_start.play_to(target);
+        from_start_time += elapsed_us(start_time);
+        failed |= from_start.get_game_state().checksum() != checksums[target];
+    }
+    std::remove(path.c_str());
+
+    double match_seconds = static_cast<double>(tick_count) / tick_rate;
+    std::cout << "match:                     " << player_count << " players, " << units_per_player << " units each, "
+              << tick_count << " ticks (" << match_seconds / 60 << " min at " << tick_rate << " ticks/s), "
+              << recorded.commands << " commands\n"
+              << "file:                      " << recorded.bytes / 1024 << " KB, " << recorded.keyframes
+              << " keyframes every " << keyframe_interval << " ticks\n"
+              << "bytes per tick:            " << static_cast<double>(recorded.bytes) / tick_count << " replay, "
+              << static_cast<double>(turn_bytes) / tick_count << " as lockstep turns\n"
+              << "record, us per tick:       " << record_time / tick_count << " (applying included)\n"
+              << "playback:                  " << play_time / 1000 << " ms, " << match_seconds / (play_time / 1e6)
+              << "x real time, " << played.checksums_checked << " checksums checked, " << played.mismatches
+              << " mismatched\n"
+              << "seek, ms:                  " << seek_time / seek_count / 1000 << " from the nearest keyframe, "
+              << from_start_time / seek_count / 1000 << " from the start\n";
+    if (failed)
+    {
+        std::cerr << "playback did not reproduce the match" << std::endl;
+    }
+    return failed;
+}
\ No newline at end of file
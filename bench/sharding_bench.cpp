@@ -0,0 +1,135 @@
+// Compares the shared and sharded networking modes over loopback.
+// Usage: sharding-bench [--sharded] [--threads N] [--clients N] [--connections N] [--messages N] [--port N]
+//   Connections/sec: each client thread repeatedly connects, handshakes and disconnects.
+//   Messages/sec: each client thread pipelines Connect requests and reads the responses.
+
+#include "server/server_runtime.hpp"
+#include "networking/message_utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    constexpr size_t response_size = sizeof(MessageType) + sizeof(uint32_t); // Empty ConnectResponse
+    constexpr size_t pipeline_window = 128;
+
+    template <typename Fn>
+    double run_clients(size_t client_count, Fn fn)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        std::vector<std::thread> clients;
+        for (size_t i = 0; i < client_count; ++i)
+        {
+            clients.emplace_back(fn);
+        }
+        for (auto &client : clients)
+        {
+            client.join();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    NetworkMode mode = NetworkMode::Shared;
+    size_t server_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t client_threads = 4;
+    size_t connections_per_client = 2000;
+    size_t messages_per_client = 200000;
+    unsigned short port = 23457;
+    for (int i = 1; i < argc; ++i)
+    {
+        auto next = [&]()
+        { return i + 1 < argc ? std::stoul(argv[++i]) : 0; };
+        if (std::strcmp(argv[i], "--sharded") == 0)
+            mode = NetworkMode::Sharded;
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            server_threads = next();
+        else if (std::strcmp(argv[i], "--clients") == 0)
+            client_threads = next();
+        else if (std::strcmp(argv[i], "--connections") == 0)
+            connections_per_client = next();
+        else if (std::strcmp(argv[i], "--messages") == 0)
+            messages_per_client = next();
+        else if (std::strcmp(argv[i], "--port") == 0)
+            port = static_cast<unsigned short>(next());
+    }
+
+    ServerRuntime runtime(mode, port, server_threads);
+    // The message phase pipelines Connects, far past what a real client is allowed
+    runtime.get_server().set_rate_limits(RateLimits{});
+    std::thread server_thread([&runtime]()
+                              { runtime.run(); });
+
+    std::vector<uint8_t> request;
+    message_utils::write_frame(request, Message::create_connect("bench"));
+    std::vector<uint8_t> window;
+    for (size_t i = 0; i < pipeline_window; ++i)
+    {
+        window.insert(window.end(), request.begin(), request.end());
+    }
+
+    const tcp::endpoint endpoint(boost::asio::ip::address_v4::loopback(), port);
+    std::atomic<size_t> failures{0};
+
+    double connect_seconds = run_clients(client_threads, [&]()
+                                         {
+        boost::asio::io_context io_context;
+        std::vector<uint8_t> response(response_size);
+        for (size_t i = 0; i < connections_per_client; ++i)
+        {
+            boost::system::error_code ec;
+            tcp::socket socket(io_context);
+            socket.connect(endpoint, ec);
+            if (!ec)
+            {
+                boost::asio::write(socket, boost::asio::buffer(request), ec);
+            }
+            if (!ec)
+            {
+                boost::asio::read(socket, boost::asio::buffer(response), ec);
+            }
+            if (ec)
+            {
+                ++failures;
+            }
+        } });
+
+    double message_seconds = run_clients(client_threads, [&]()
+                                         {
+        boost::asio::io_context io_context;
+        tcp::socket socket(io_context);
+        boost::system::error_code ec;
+        socket.connect(endpoint, ec);
+        std::vector<uint8_t> responses(response_size * pipeline_window);
+        for (size_t sent = 0; !ec && sent < messages_per_client; sent += pipeline_window)
+        {
+            boost::asio::write(socket, boost::asio::buffer(window), ec);
+            if (!ec)
+            {
+                boost::asio::read(socket, boost::asio::buffer(responses), ec);
+            }
+        }
+        if (ec)
+        {
+            ++failures;
+        } });
+
+    runtime.stop();
+    server_thread.join();
+
+    size_t total_connections = client_threads * connections_per_client;
+    size_t total_messages = client_threads * ((messages_per_client + pipeline_window - 1) / pipeline_window) * pipeline_window;
+    std::cout << "mode:                 " << (mode == NetworkMode::Sharded ? "sharded" : "shared") << "\n"
+              << "backend:              " << ServerRuntime::get_backend_name() << "\n"
+              << "server threads:       " << runtime.get_thread_count() << "\n"
+              << "client threads:       " << client_threads << "\n"
+              << "connections/sec:      " << static_cast<size_t>(total_connections / connect_seconds) << "\n"
+              << "messages/sec:         " << static_cast<size_t>(total_messages / message_seconds) << "\n"
+              << "failures:             " << failures.load() << "\n";
+    return 0;
+}
\ No newline at end of file
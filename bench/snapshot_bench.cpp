@@ -0,0 +1,277 @@
+// Measures ResourceUpdate snapshot size per client per tick, delta against keyframe.
+// Usage: snapshot-bench [--players N] [--units N] [--ticks N] [--ack-lag N] [--keyframes] [--interned]
+//                       [--map N] [--spread N] [--interest] [--budget BYTES]
+//   --units is per player; each tick ~10% of units move, ~2% take damage and a few spawn or die
+//   --map is the side of the square map in tiles; --spread keeps each player's units within that
+//   many tiles of a random base, 0 for anywhere
+//   --interest sends each client only the units near its own or inside its camera, a 40x25 tile
+//   view of its base
+//   --budget caps each snapshot; clients then lag the world, so instead of exact matches the run
+//   reports how far behind they fall, and how many quiet ticks they need to catch up at the end
+//   --ack-lag is how many ticks a client's acknowledgment takes to reach the server
+//   --keyframes never acknowledges, so every snapshot is sent whole
+//   --interned sends resources by NameID, as for clients that negotiated interned names
+
+#include "server/snapshot.hpp"
+#include "server/interest_grid.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+int main(int argc, char *argv[])
+{
+    size_t player_count = 8;
+    size_t units_per_player = 250;
+    size_t tick_count = 600;
+    size_t ack_lag = 3;
+    bool keyframes_only = false;
+    bool interned_names = false;
+    int map_size = 100;
+    int spread = 0;
+    bool interest = false;
+    size_t byte_budget = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        auto next = [&]()
+        { return i + 1 < argc ? std::stoul(argv[++i]) : 0; };
+        if (std::strcmp(argv[i], "--players") == 0)
+            player_count = next();
+        else if (std::strcmp(argv[i], "--units") == 0)
+            units_per_player = next();
+        else if (std::strcmp(argv[i], "--ticks") == 0)
+            tick_count = next();
+        else if (std::strcmp(argv[i], "--ack-lag") == 0)
+            ack_lag = next();
+        else if (std::strcmp(argv[i], "--keyframes") == 0)
+            keyframes_only = true;
+        else if (std::strcmp(argv[i], "--interned") == 0)
+            interned_names = true;
+        else if (std::strcmp(argv[i], "--map") == 0)
+            map_size = std::max(1, static_cast<int>(next()));
+        else if (std::strcmp(argv[i], "--spread") == 0)
+            spread = static_cast<int>(next());
+        else if (std::strcmp(argv[i], "--interest") == 0)
+            interest = true;
+        else if (std::strcmp(argv[i], "--budget") == 0)
+            byte_budget = next();
+    }
+
+    std::mt19937 rng(42);
+    Map map(map_size, map_size, 32);
+    InterestGrid interest_grid(map);
+    GameState game_state;
+    ResourceManager resource_manager;
+    std::vector<PlayerID> players;
+    std::vector<std::pair<int, int>> bases;
+    auto random_position = [&](int base)
+    {
+        if (spread <= 0)
+        {
+            return static_cast<int>(rng() % map_size);
+        }
+        return std::clamp(base + static_cast<int>(rng() % (2 * spread + 1)) - spread, 0, map_size - 1);
+    };
+    for (PlayerID player_id = 1; player_id <= player_count; ++player_id)
+    {
+        players.push_back(player_id);
+        bases.emplace_back(rng() % map_size, rng() % map_size);
+        for (size_t i = 0; i < units_per_player; ++i)
+        {
+            game_state.spawn_unit(player_id, UnitType::Soldier, random_position(bases.back().first),
+                                  random_position(bases.back().second), 100);
+        }
+        interest_grid.set_camera(player_id, CameraRect{bases.back().first - 20, bases.back().second - 12, 40, 25});
+        resource_manager.add_resource(player_id, "Gold", 1000);
+        resource_manager.add_resource(player_id, "Wood", 500);
+        resource_manager.add_resource(player_id, "Stone", 300);
+        resource_manager.add_resource(player_id, "Food", 200);
+        game_state.update_player_score(player_id, 0);
+    }
+
+    SnapshotEncoder encoder;
+    if (interest)
+    {
+        encoder.set_interest(&interest_grid);
+    }
+    const NameTable *resource_names = interned_names ? &resource_manager.get_resource_names() : nullptr;
+    std::vector<SnapshotDecoder> decoders;
+    for (PlayerID player_id : players)
+    {
+        decoders.emplace_back(player_id, resource_names);
+    }
+
+    // In-flight acknowledgments per tick, delivered ack_lag ticks after the snapshot was sent
+    std::vector<std::vector<std::pair<PlayerID, uint32_t>>> acks_in_flight(ack_lag + 1);
+
+    // With a budget, keep sending after the simulation stops until every client has caught up
+    const size_t settle_limit = byte_budget ? 10 * SnapshotEncoder::max_history : 0;
+    size_t keyframe_bytes = 0;
+    size_t largest_bytes = 0;
+    size_t mismatches = 0;
+    size_t behind = 0;
+    size_t settle_ticks = 0;
+    SnapshotStats run_stats;
+    double encode_seconds = 0;
+    for (size_t tick = 0; tick < tick_count + settle_limit; ++tick)
+    {
+        bool settling = tick >= tick_count;
+        if (tick == tick_count)
+        {
+            run_stats = encoder.get_stats();
+        }
+
+        // Simulate: some units move, some get hit, a few die and respawn
+        std::vector<UnitID> ids;
+        for (const auto &[id, handle] : game_state.get_unit_handles())
+        {
+            ids.push_back(id);
+        }
+        if (settling)
+        {
+            ids.clear();
+        }
+        for (size_t i = 0; i < ids.size() / 10; ++i)
+        {
+            UnitRef unit = game_state.get_unit(ids[rng() % ids.size()]);
+            int x;
+            int y;
+            unit.get_position(x, y);
+            unit.set_position(x + static_cast<int>(rng() % 3) - 1, y + static_cast<int>(rng() % 3) - 1);
+        }
+        for (size_t i = 0; i < ids.size() / 50; ++i)
+        {
+            UnitRef unit = game_state.get_unit(ids[rng() % ids.size()]);
+            unit.set_health(std::max(0, unit.get_health() - 5));
+        }
+        for (size_t i = 0; i < (settling ? 0 : player_count / 2); ++i)
+        {
+            UnitID id = ids[rng() % ids.size()];
+            UnitRef unit = game_state.get_unit(id);
+            if (unit.is_valid())
+            {
+                PlayerID owner = unit.get_owner_id();
+                game_state.remove_unit(id);
+                const auto &[base_x, base_y] = bases[owner - 1];
+                game_state.spawn_unit(owner, UnitType::Archer, random_position(base_x), random_position(base_y), 100);
+            }
+        }
+        for (PlayerID player_id : settling ? std::vector<PlayerID>{} : players)
+        {
+            resource_manager.add_resource(player_id, "Gold", 1);
+            if (tick % 10 == 0)
+            {
+                game_state.update_player_score(player_id, game_state.get_player_score(player_id) + 1);
+            }
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        encoder.capture(game_state, resource_manager);
+        std::vector<Message> messages;
+        for (PlayerID player_id : players)
+        {
+            messages.push_back(encoder.encode(player_id, resource_names, byte_budget));
+        }
+        if (!settling)
+        {
+            encode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        }
+
+        if (tick == 0)
+        {
+            keyframe_bytes = messages.front().data.size();
+        }
+        for (const Message &message : messages)
+        {
+            largest_bytes = std::max(largest_bytes, message.data.size());
+        }
+
+        // Clients decode, check what they rebuilt and acknowledge
+        auto &arriving = acks_in_flight[tick % acks_in_flight.size()];
+        for (auto [player_id, sequence] : arriving)
+        {
+            encoder.acknowledge(player_id, sequence);
+        }
+        arriving.clear();
+        size_t caught_up = 0;
+        std::vector<UnitID> visible;
+        for (size_t i = 0; i < players.size(); ++i)
+        {
+            if (!decoders[i].apply(messages[i].view()))
+            {
+                ++mismatches;
+                continue;
+            }
+            const WorldSnapshot *snapshot = decoders[i].latest();
+            visible.clear();
+            if (interest)
+            {
+                interest_grid.visible_units(players[i], visible);
+            }
+            else
+            {
+                for (const auto &[id, handle] : game_state.get_unit_handles())
+                {
+                    visible.push_back(id);
+                }
+            }
+            bool same = snapshot->units.size() == visible.size() &&
+                        snapshot->scores == game_state.get_player_scores() &&
+                        snapshot->resources.at(players[i]) == resource_manager.get_player_resources().at(players[i]);
+            for (size_t u = 0; same && u < snapshot->units.size(); ++u)
+            {
+                const UnitState &a = snapshot->units[u];
+                UnitState b;
+                same = game_state.get_unit_state(visible[u], b) && a.id == b.id && a.owner == b.owner && a.x == b.x &&
+                       a.y == b.y && a.health == b.health;
+            }
+            caught_up += same ? 1 : 0;
+            if (!byte_budget)
+            {
+                mismatches += same ? 0 : 1;
+            }
+            else if (!same && !settling)
+            {
+                ++behind;
+            }
+            if (!keyframes_only)
+            {
+                arriving.emplace_back(players[i], snapshot->sequence);
+            }
+        }
+
+        if (settling)
+        {
+            ++settle_ticks;
+            if (caught_up == players.size())
+            {
+                break;
+            }
+            if (tick + 1 == tick_count + settle_limit)
+            {
+                mismatches += players.size() - caught_up;
+            }
+        }
+    }
+
+    const SnapshotStats &stats = byte_budget ? run_stats : encoder.get_stats();
+    size_t client_ticks = tick_count * player_count;
+    std::cout << "players x units:          " << player_count << " x " << units_per_player << "\n"
+              << "area of interest:         " << (interest ? "on" : "off") << "\n"
+              << "keyframes / deltas:       " << stats.keyframes << " / " << stats.deltas << "\n"
+              << "keyframe bytes:           " << keyframe_bytes << "\n"
+              << "bytes/client/tick:        " << stats.bytes / client_ticks << "\n"
+              << "encode us/client/tick:    " << encode_seconds * 1e6 / client_ticks << "\n"
+              << "interest enters / leaves: " << stats.interest_enters << " / " << stats.interest_leaves << "\n";
+    if (byte_budget)
+    {
+        std::cout << "budget bytes:             " << byte_budget << "\n"
+                  << "largest snapshot bytes:   " << largest_bytes << "\n"
+                  << "deferred/client/tick:     " << stats.units_deferred / client_ticks << "\n"
+                  << "client ticks behind:      " << behind << " of " << client_ticks << "\n"
+                  << "quiet ticks to catch up:  " << settle_ticks << "\n";
+    }
+    std::cout << "decode mismatches:        " << mismatches << "\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "server/command_queue.hpp"
+#include "server/game_state.hpp"
+#include <random>
+#include <vector>
+
+// The match lockstep-bench and replay-bench run. Every player starts with units_per_player
+// soldiers scattered over a 100x100 map. Each tick every player with units left orders a move
+// of up to 12 of them; one in four also attacks a random enemy unit, and one in ten harvests.
+class SyntheticMatch
+{
+public:
+    SyntheticMatch(size_t player_count, size_t units_per_player, std::mt19937::result_type seed)
+        : player_count_(player_count), units_per_player_(units_per_player), random_(seed), owned_(player_count + 1)
+    {
+    }
+
+    void populate(GameState &game_state)
+    {
+        for (PlayerID player = 1; player <= player_count_; ++player)
+        {
+            for (size_t i = 0; i < units_per_player_; ++i)
+            {
+                game_state.spawn_unit(player, UnitType::Soldier, static_cast<int>(random_() % 100),
+                                      static_cast<int>(random_() % 100), 100);
+            }
+            game_state.update_player_score(player, 0);
+        }
+    }
+
+    // Replaces commands with the orders for the next tick, given the world as it stands
+    void next_tick(const GameState &game_state, std::vector<PlayerCommand> &commands)
+    {
+        for (auto &units : owned_)
+        {
+            units.clear();
+        }
+        game_state.for_each_unit([this](const UnitState &unit)
+                                 { owned_[unit.owner].push_back(unit.id); });
+
+        commands.clear();
+        for (PlayerID player = 1; player <= player_count_; ++player)
+        {
+            const auto &units = owned_[player];
+            if (units.empty())
+            {
+                continue;
+            }
+            PlayerCommand move;
+            move.kind = PlayerCommand::Kind::Move;
+            move.player_id = player;
+            move.x = static_cast<int>(random_() % 100);
+            move.y = static_cast<int>(random_() % 100);
+            for (size_t k = 0; k < 12 && k < units.size(); ++k)
+            {
+                move.unit_ids.push_back(units[random_() % units.size()]);
+            }
+            commands.push_back(move);
+
+            PlayerID enemy = static_cast<PlayerID>(random_() % player_count_ + 1);
+            if (random_() % 4 == 0 && enemy != player && !owned_[enemy].empty())
+            {
+                PlayerCommand attack;
+                attack.kind = PlayerCommand::Kind::Attack;
+                attack.player_id = player;
+                attack.unit_id = units[random_() % units.size()];
+                attack.target_id = owned_[enemy][random_() % owned_[enemy].size()];
+                commands.push_back(attack);
+            }
+            if (random_() % 10 == 0)
+            {
+                PlayerCommand harvest;
+                harvest.kind = PlayerCommand::Kind::Harvest;
+                harvest.player_id = player;
+                harvest.unit_id = units[random_() % units.size()];
+                commands.push_back(harvest);
+            }
+        }
+    }
+
+private:
+    size_t player_count_;
+    size_t units_per_player_;
+    std::mt19937 random_;
+    std::vector<std::vector<UnitID>> owned_; // By player, rebuilt every tick
+};
\ No newline at end of file
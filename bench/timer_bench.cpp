@@ -0,0 +1,162 @@
+// Compares the timing-wheel Timer with the std::map scan it replaced, driven in game time.
+// Usage: timer-bench [--timers N] [--ticks N]
+//   N timers wait 0.1 to 60 s, half of them repeating; each tick advances the game 50 ms.
+//   insert: set_timeout or set_interval; update: one tick, including the callbacks that fire;
+//   cancel: clear_timer on every timer still live.
+
+#include "server/timer.hpp"
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+
+namespace
+{
+    // The previous Timer: every update visits every timer
+    class MapTimer
+    {
+    public:
+        std::uint32_t add(float seconds, std::function<void()> callback, bool is_repeating)
+        {
+            std::uint32_t id = next_id_++;
+            timers_[id] = {now_ + seconds, seconds, std::move(callback), is_repeating};
+            return id;
+        }
+
+        void clear(std::uint32_t id) { timers_.erase(id); }
+
+        void update(float delta_time)
+        {
+            now_ += delta_time;
+            std::vector<std::uint32_t> completed;
+            for (auto &[id, timer] : timers_)
+            {
+                if (now_ >= timer.next_trigger)
+                {
+                    timer.callback();
+                    if (timer.is_repeating)
+                    {
+                        timer.next_trigger += timer.interval;
+                    }
+                    else
+                    {
+                        completed.push_back(id);
+                    }
+                }
+            }
+            for (auto id : completed)
+            {
+                timers_.erase(id);
+            }
+        }
+
+    private:
+        struct TimerData
+        {
+            double next_trigger;
+            float interval;
+            std::function<void()> callback;
+            bool is_repeating;
+        };
+
+        std::map<std::uint32_t, TimerData> timers_;
+        std::uint32_t next_id_{1};
+        double now_{0};
+    };
+
+    double elapsed_ns(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t timer_count = 100000;
+    size_t ticks = 400;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--timers") == 0 && i + 1 < argc)
+            timer_count = std::stoul(argv[++i]);
+        else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            ticks = std::stoul(argv[++i]);
+    }
+    const float step = 0.05f;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> delay(0.1f, 60.0f);
+    std::vector<float> delays(timer_count);
+    std::vector<bool> repeating(timer_count);
+    for (size_t i = 0; i < timer_count; ++i)
+    {
+        delays[i] = delay(random);
+        repeating[i] = random() % 2 == 0;
+    }
+
+    std::uint64_t wheel_fired = 0;
+    std::uint64_t map_fired = 0;
+    Timer wheel;
+    wheel.update(0.0f); // Game time from the start
+    MapTimer legacy;
+    std::vector<TimerID> wheel_ids(timer_count);
+    std::vector<std::uint32_t> map_ids(timer_count);
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < timer_count; ++i)
+    {
+        auto callback = [&wheel_fired]() { ++wheel_fired; };
+        wheel_ids[i] = repeating[i] ? wheel.set_interval(delays[i], callback) : wheel.set_timeout(delays[i], callback);
+    }
+    double wheel_insert = elapsed_ns(start_time) / timer_count;
+
+    start_time = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < timer_count; ++i)
+    {
+        map_ids[i] = legacy.add(delays[i], [&map_fired]() { ++map_fired; }, repeating[i]);
+    }
+    double map_insert = elapsed_ns(start_time) / timer_count;
+
+    double wheel_update = 0;
+    double wheel_worst = 0;
+    double map_update = 0;
+    double map_worst = 0;
+    for (size_t tick = 0; tick < ticks; ++tick)
+    {
+        start_time = std::chrono::steady_clock::now();
+        wheel.update(step);
+        double wheel_tick = elapsed_ns(start_time);
+        start_time = std::chrono::steady_clock::now();
+        legacy.update(step);
+        double map_tick = elapsed_ns(start_time);
+        wheel_update += wheel_tick;
+        map_update += map_tick;
+        wheel_worst = std::max(wheel_worst, wheel_tick);
+        map_worst = std::max(map_worst, map_tick);
+    }
+    size_t live = wheel.get_timer_count();
+
+    start_time = std::chrono::steady_clock::now();
+    for (auto id : wheel_ids)
+    {
+        wheel.clear_timer(id);
+    }
+    double wheel_cancel = elapsed_ns(start_time) / timer_count;
+
+    start_time = std::chrono::steady_clock::now();
+    for (auto id : map_ids)
+    {
+        legacy.clear(id);
+    }
+    double map_cancel = elapsed_ns(start_time) / timer_count;
+
+    std::cout << "timers:                    " << timer_count << ", " << live << " live after " << ticks << " ticks of " << step * 1000 << " ms\n"
+              << "callbacks fired:           " << wheel_fired << " wheel, " << map_fired << " map\n"
+              << "                           timing wheel\tstd::map scan\n"
+              << "insert, ns                 " << wheel_insert << "\t" << map_insert << "\n"
+              << "update, us per tick        " << wheel_update / ticks / 1000 << "\t" << map_update / ticks / 1000 << "\n"
+              << "worst update, us           " << wheel_worst / 1000 << "\t" << map_worst / 1000 << "\n"
+              << "cancel, ns                 " << wheel_cancel << "\t" << map_cancel << "\n";
+    return wheel_fired != map_fired || wheel.get_timer_count() != 0;
+}
\ No newline at end of file
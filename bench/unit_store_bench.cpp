@@ -0,0 +1,180 @@
+// Times one update pass over many units: the Unit class hierarchy, one heap allocation per unit,
+// against UnitStore's parallel arrays.
+// Usage: unit-store-bench [--units N] [--ticks N]
+//   Each tick every unit steps towards its destination, then attacks a fixed target. Unit
+//   pointers are visited in allocation order, and again shuffled, as they end up once units
+//   have been spawned and killed over a match. Both sides must end with the same positions and
+//   health.
+
+#include "units/specific_units.hpp"
+#include "units/unit_store.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+
+namespace
+{
+    double elapsed_ns(std::chrono::steady_clock::time_point start_time)
+    {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    std::unique_ptr<Unit> make_unit(UnitType type, PlayerID owner)
+    {
+        switch (type)
+        {
+        case UnitType::Peasant:
+            return std::make_unique<Peasant>(owner);
+        case UnitType::Archer:
+            return std::make_unique<Archer>(owner);
+        case UnitType::Knight:
+            return std::make_unique<Knight>(owner);
+        case UnitType::Healer:
+            return std::make_unique<Healer>(owner);
+        case UnitType::Scout:
+            return std::make_unique<Scout>(owner);
+        default:
+            return std::make_unique<Soldier>(owner);
+        }
+    }
+
+    struct Result
+    {
+        double move_ns{0};
+        double attack_ns{0};
+    };
+
+    // The pass over the hierarchy, visiting units in the given order
+    Result run_units(std::vector<std::unique_ptr<Unit>> &units, const std::vector<size_t> &order,
+                     const std::vector<int> &destination_x, const std::vector<int> &destination_y,
+                     const std::vector<size_t> &targets, size_t ticks)
+    {
+        Result result;
+        for (size_t tick = 0; tick < ticks; ++tick)
+        {
+            auto start_time = std::chrono::steady_clock::now();
+            for (size_t i : order)
+            {
+                Unit &unit = *units[i];
+                int x, y;
+                unit.get_position(x, y);
+                int speed = unit.get_speed();
+                unit.set_position(x + std::clamp(destination_x[i] - x, -speed, speed),
+                                  y + std::clamp(destination_y[i] - y, -speed, speed));
+            }
+            result.move_ns += elapsed_ns(start_time);
+
+            start_time = std::chrono::steady_clock::now();
+            for (size_t i : order)
+            {
+                units[i]->attack(units[targets[i]].get());
+            }
+            result.attack_ns += elapsed_ns(start_time);
+        }
+        return result;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t unit_count = 50000;
+    size_t ticks = 200;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--units") == 0 && i + 1 < argc)
+            unit_count = std::max<size_t>(1, std::stoul(argv[++i]));
+        else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            ticks = std::stoul(argv[++i]);
+    }
+
+    const UnitType types[] = {UnitType::Peasant, UnitType::Soldier, UnitType::Archer,
+                              UnitType::Knight, UnitType::Healer, UnitType::Scout};
+    std::mt19937 random(5);
+    std::vector<int> x(unit_count), y(unit_count), destination_x(unit_count), destination_y(unit_count);
+    std::vector<size_t> targets(unit_count);
+    std::vector<UnitType> unit_types(unit_count);
+    for (size_t i = 0; i < unit_count; ++i)
+    {
+        unit_types[i] = types[random() % 6];
+        x[i] = static_cast<int>(random() % 1000);
+        y[i] = static_cast<int>(random() % 1000);
+        destination_x[i] = static_cast<int>(random() % 1000);
+        destination_y[i] = static_cast<int>(random() % 1000);
+        targets[i] = random() % unit_count;
+    }
+
+    std::vector<std::unique_ptr<Unit>> units;
+    UnitStore store;
+    std::vector<UnitStore::Handle> handles;
+    units.reserve(unit_count);
+    handles.reserve(unit_count);
+    for (size_t i = 0; i < unit_count; ++i)
+    {
+        PlayerID owner = static_cast<PlayerID>(i % 8 + 1);
+        units.push_back(make_unit(unit_types[i], owner));
+        units.back()->set_position(x[i], y[i]);
+        handles.push_back(store.spawn(unit_types[i], owner, x[i], y[i]));
+        store.set_destination(handles.back(), destination_x[i], destination_y[i]);
+    }
+    std::vector<UnitStore::Handle> target_handles(unit_count);
+    for (size_t i = 0; i < unit_count; ++i)
+    {
+        target_handles[i] = handles[targets[i]];
+    }
+
+    std::vector<size_t> in_order(unit_count);
+    std::iota(in_order.begin(), in_order.end(), 0);
+    Result ordered = run_units(units, in_order, destination_x, destination_y, targets, ticks);
+
+    Result store_result;
+    for (size_t tick = 0; tick < ticks; ++tick)
+    {
+        auto start_time = std::chrono::steady_clock::now();
+        store.update();
+        store_result.move_ns += elapsed_ns(start_time);
+
+        start_time = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < unit_count; ++i)
+        {
+            store.attack(handles[i], target_handles[i]);
+        }
+        store_result.attack_ns += elapsed_ns(start_time);
+    }
+
+    // Same passes must give the same world
+    bool matches = true;
+    for (size_t i = 0; i < unit_count && matches; ++i)
+    {
+        UnitRef unit = store.get(handles[i]);
+        int store_x, store_y, unit_x, unit_y;
+        unit.get_position(store_x, store_y);
+        units[i]->get_position(unit_x, unit_y);
+        matches = store_x == unit_x && store_y == unit_y && unit.get_health() == units[i]->get_health();
+    }
+
+    // The same hierarchy with its pointers visited in a churned order
+    std::vector<size_t> shuffled = in_order;
+    std::shuffle(shuffled.begin(), shuffled.end(), random);
+    Result churned = run_units(units, shuffled, destination_x, destination_y, targets, ticks);
+
+    double per_unit = static_cast<double>(unit_count) * ticks;
+    std::cout << "units:                     " << unit_count << ", " << ticks << " ticks\n"
+              << "                           UnitStore\tUnit, allocation order\tUnit, shuffled\n"
+              << "move, ns per unit          " << store_result.move_ns / per_unit << "\t\t" << ordered.move_ns / per_unit
+              << "\t\t\t" << churned.move_ns / per_unit << "\n"
+              << "attack, ns per unit        " << store_result.attack_ns / per_unit << "\t\t"
+              << ordered.attack_ns / per_unit << "\t\t\t" << churned.attack_ns / per_unit << "\n"
+              << "pass, us per tick          " << (store_result.move_ns + store_result.attack_ns) / ticks / 1000 << "\t\t"
+              << (ordered.move_ns + ordered.attack_ns) / ticks / 1000 << "\t\t\t"
+              << (churned.move_ns + churned.attack_ns) / ticks / 1000 << "\n"
+              << "store memory:              " << store.get_memory_usage() / 1024 << " KB\n";
+    if (!matches)
+    {
+        std::cerr << "UnitStore and Unit disagree on the world after the run" << std::endl;
+    }
+    return !matches;
+}
\ No newline at end of file
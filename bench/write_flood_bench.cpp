@@ -0,0 +1,127 @@
+// Floods a loopback client with small upgrade responses and counts send syscalls.
+// Usage: write-flood-bench [message_count] [--batch-bytes N] [--burst N]
+//   --batch-bytes 0 writes one message per syscall, as the path did before gathering
+
+#include "networking/client_connection.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <dlfcn.h>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <thread>
+
+namespace
+{
+    std::atomic<size_t> send_syscalls{0};
+
+    template <typename Fn>
+    Fn next_symbol(const char *name)
+    {
+        return reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+    }
+}
+
+// Interpose the libc send family so every syscall Asio issues is counted
+extern "C" ssize_t sendmsg(int fd, const struct msghdr *msg, int flags)
+{
+    static auto real = next_symbol<ssize_t (*)(int, const struct msghdr *, int)>("sendmsg");
+    send_syscalls.fetch_add(1, std::memory_order_relaxed);
+    return real(fd, msg, flags);
+}
+
+extern "C" ssize_t send(int fd, const void *buf, size_t len, int flags)
+{
+    static auto real = next_symbol<ssize_t (*)(int, const void *, size_t, int)>("send");
+    send_syscalls.fetch_add(1, std::memory_order_relaxed);
+    return real(fd, buf, len, flags);
+}
+
+extern "C" ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    static auto real = next_symbol<ssize_t (*)(int, const struct iovec *, int)>("writev");
+    send_syscalls.fetch_add(1, std::memory_order_relaxed);
+    return real(fd, iov, iovcnt);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t message_count = 200000;
+    size_t batch_bytes = 64 * 1024;
+    size_t burst_size = 64;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--batch-bytes") == 0 && i + 1 < argc)
+        {
+            batch_bytes = std::stoul(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--burst") == 0 && i + 1 < argc)
+        {
+            burst_size = std::stoul(argv[++i]);
+        }
+        else
+        {
+            message_count = std::stoul(argv[i]);
+        }
+    }
+
+    boost::asio::io_context io_context;
+    tcp::acceptor acceptor(io_context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    tcp::socket client(io_context);
+    client.connect(acceptor.local_endpoint());
+    tcp::socket server_side = acceptor.accept();
+
+    const Message response = Message::create_upgrade_response(true, "weapon", 2);
+    const size_t expected_bytes = response.serialize().size() * message_count;
+
+    auto connection = std::make_shared<ClientConnection>(std::move(server_side), 1);
+    connection->set_max_write_batch_bytes(batch_bytes);
+    connection->start();
+
+    std::thread reader([&client, expected_bytes]()
+                       {
+                           std::vector<uint8_t> buffer(64 * 1024);
+                           size_t received = 0;
+                           while (received < expected_bytes)
+                           {
+                               received += client.read_some(boost::asio::buffer(buffer));
+                           }
+                       });
+
+    // Queue responses in bursts, the way a tick of upgrade/resource results would arrive
+    size_t queued = 0;
+    std::function<void()> queue_burst = [&]()
+    {
+        for (size_t i = 0; i < burst_size && queued < message_count; ++i, ++queued)
+        {
+            connection->send_message(response);
+        }
+        if (queued < message_count)
+        {
+            boost::asio::post(io_context, queue_burst);
+        }
+    };
+
+    size_t syscalls_before = send_syscalls.load();
+    auto start_time = std::chrono::steady_clock::now();
+    boost::asio::post(io_context, queue_burst);
+    while (connection->get_stats().messages_sent < message_count && io_context.run_one())
+    {
+    }
+    reader.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    size_t syscalls = send_syscalls.load() - syscalls_before;
+
+    const auto &stats = connection->get_stats();
+    std::cout << "batch cap (bytes):    " << batch_bytes << "\n"
+              << "messages:             " << stats.messages_sent << "\n"
+              << "write batches:        " << stats.write_batches << "\n"
+              << "send syscalls:        " << syscalls << "\n"
+              << "syscalls/message:     " << static_cast<double>(syscalls) / stats.messages_sent << "\n"
+              << "messages/sec:         " << static_cast<size_t>(stats.messages_sent / seconds) << "\n"
+              << "MB/sec:               " << stats.bytes_sent / seconds / (1024 * 1024) << "\n";
+
+    connection->stop();
+    return 0;
+}
\ No newline at end of file
@@ -52,6 +52,8 @@ public:
     void unlock_technology(const std::string &tech_name);
 
 protected:
+    UnitStats apply_unit_modifier(UnitType type, UnitStats stats) const;
+
     std::string name_;
     std::string description_;
     std::map<std::string, FactionBonus> bonuses_;
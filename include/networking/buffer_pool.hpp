@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#if defined(BOOST_ASIO_HAS_IO_URING)
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/registered_buffer.hpp>
+#endif
+
+// Fixed-size receive blocks carved out of one contiguous slab. Connections
+// acquire a block on start and hand it back on destruction, so steady-state
+// reads never touch the heap.
+class BufferPool
+{
+public:
+    BufferPool(size_t block_size, size_t block_count);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // Returns nullptr when the slab is exhausted; callers fall back to their own storage
+    uint8_t *acquire();
+    void release(uint8_t *block);
+
+    size_t get_block_size() const { return block_size_; }
+    size_t get_block_count() const { return block_count_; }
+    size_t get_available_blocks() const;
+    uint8_t *get_slab() { return slab_.get(); }
+    size_t get_slab_size() const { return block_size_ * block_count_; }
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    // Registers every block with the io_uring instance behind io_context, so reads into a block
+    // can use fixed buffers. Call once per io_context before its connections start; if the
+    // kernel refuses, reads keep using plain buffers.
+    void register_blocks(boost::asio::io_context &io_context);
+
+    // The registered form of block for context; empty (size 0) when the blocks aren't registered there
+    boost::asio::mutable_registered_buffer get_registered_block(const uint8_t *block,
+                                                                const boost::asio::execution_context &context) const;
+#endif
+
+private:
+    size_t block_size_;
+    size_t block_count_;
+    std::unique_ptr<uint8_t[]> slab_;
+    std::vector<uint8_t *> free_blocks_;
+    mutable std::mutex mutex_;
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    struct Registration
+    {
+        const boost::asio::execution_context *context;
+        boost::asio::buffer_registration<std::vector<boost::asio::mutable_buffer>> buffers;
+    };
+    std::vector<Registration> registrations_; // One per io_context, written before connections start
+#endif
+};
\ No newline at end of file
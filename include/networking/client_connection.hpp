@@ -1,72 +1,181 @@
 #pragma once
 
 #include <boost/asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <memory>
-#include <queue>
 #include <vector>
-#include <functional>
 #include "../server/game_state.hpp"
 #include "../server/player.hpp"
 #include "../utils/types.hpp"
+#include "buffer_pool.hpp"
+#include "compact_codec.hpp"
+#include "frame_decoder.hpp"
 #include "message.hpp"
+#include "message_dispatcher.hpp"
+#include "payload_compressor.hpp"
+#include "rate_limiter.hpp"
 
 using boost::asio::ip::tcp;
-using MessageHandler = std::function<void(const Message &)>;
+
+struct ConnectionStats
+{
+    std::uint64_t messages_sent{0};
+    std::uint64_t bytes_sent{0};
+    std::uint64_t write_batches{0};
+    std::uint64_t messages_received{0};
+    std::uint64_t reads{0};
+    std::uint64_t messages_compressed{0};
+    std::uint64_t bytes_saved_by_compression{0};
+    std::uint64_t snapshots_superseded{0}; // Dropped unsent because a newer snapshot was queued
+    size_t queued_bytes_high_water{0};
+    size_t queued_messages_high_water{0};
+    bool evicted{false};
+    std::uint64_t messages_rate_limited{0}; // Dropped for exceeding a token bucket
+    std::uint64_t moves_merged{0};          // Over-limit moves replaced by a newer order for the same units
+};
+
+// Bounds on one connection's send backlog. A client that stays over either limit for
+// eviction_delay is disconnected rather than left to grow the queue.
+struct WriteQueueLimits
+{
+    size_t max_bytes{4 * 1024 * 1024};
+    size_t max_messages{4096};
+    std::chrono::steady_clock::duration eviction_delay{std::chrono::seconds(5)};
+};
 
 class ClientConnection : public std::enable_shared_from_this<ClientConnection>
 {
 public:
-    explicit ClientConnection(tcp::socket socket, PlayerID player_id);
+    ClientConnection(tcp::socket socket, PlayerID player_id,
+                     std::shared_ptr<BufferPool> buffer_pool = nullptr);
     ~ClientConnection();
 
     void start();
     void stop();
     void send_message(const Message &message);
+    void send_payload(SharedPayload payload);
     PlayerID get_player_id() const { return player_id_; }
     bool is_connected() const { return connected_; }
     void set_authenticated(bool auth) { authenticated_ = auth; }
     bool is_authenticated() const { return authenticated_; }
 
-    void set_message_handler(MessageHandler handler) { message_handler_ = std::move(handler); }
+    // Called once, on the connection's executor, when the connection closes for any reason
+    void set_disconnect_handler(std::function<void(PlayerID)> handler) { disconnect_handler_ = std::move(handler); }
+
+    // Handlers for everything but the handshake; shared by every connection of a server
+    void set_dispatcher(std::shared_ptr<const MessageDispatcher> dispatcher) { dispatcher_ = std::move(dispatcher); }
+
+    // Map bounds offered to clients that ask for the compact encoding; without them it is refused
+    void set_compact_layout(const CompactLayout &layout) { compact_layout_ = layout; }
+    uint32_t get_capabilities() const { return capabilities_; }
+
+    // Serialized NameDictionary sent to clients that ask for interned names; without it they are refused
+    void set_name_dictionary(SharedPayload dictionary) { name_dictionary_ = std::move(dictionary); }
+
+    // Outgoing payloads at least this large are compressed once the client accepts it; 0 refuses compression
+    void set_compression_threshold(size_t bytes) { compression_threshold_ = bytes; }
+
+    // Upper bound on bytes gathered into one write; 0 sends one message per write
+    void set_max_write_batch_bytes(size_t bytes) { max_write_batch_bytes_ = bytes; }
+    void set_write_queue_limits(const WriteQueueLimits &limits) { write_queue_limits_ = limits; }
+
+    // Inbound messages over these limits are dropped before dispatch, except moves: the latest
+    // over-limit move waits for a token, replacing any older one for the same units
+    void set_rate_limits(const RateLimits &limits);
+    size_t get_queued_bytes() const { return queued_bytes_; }
+    const ConnectionStats &get_stats() const { return stats_; }
 
 private:
-    void do_read_header();
-    void do_read_body();
+    void do_read();
+    bool dispatch_frames();
+    bool expand_compact(MessageView &message);
+    bool decompress(MessageView &message);
+    SharedPayload compress(SharedPayload payload);
     void do_write();
-    void handle_message(const Message &message);
+    void queue_payload(SharedPayload payload);
+    void drop_superseded_snapshots();
+    bool within_write_queue_limits();
+    bool running_in_this_thread();
+    void handle_message(const MessageView &message);
+    void dispatch_message(const MessageView &message);
+    void defer_move(const MessageView &move);
+    void schedule_deferred_move();
 
     // Message handlers
-    void handle_connect(const Message &message);
+    void handle_connect(const MessageView &message);
     void handle_disconnect();
-    void handle_chat_message(const Message &message);
-    void handle_move_request(const Message &message);
-    void handle_build_request(const Message &message);
-    void handle_attack_request(const Message &message);
-    void handle_harvest_request(const Message &message);
-
-    // Upgrade message handlers
-    void handle_upgrade_request(const Message &message);
-    void handle_technology_request(const Message &message);
-    void handle_upgrade_list_request();
-    void handle_upgrade_response(const Message &message);
-    void handle_technology_response(const Message &message);
-    void handle_upgrade_list_response(const Message &message);
+    void handle_server_response(const MessageView &message); // Client role: responses to our requests
 
     tcp::socket socket_;
     PlayerID player_id_;
     bool connected_{false};
     bool authenticated_{false};
-    MessageHandler message_handler_;
+    std::shared_ptr<const MessageDispatcher> dispatcher_;
+    std::function<void(PlayerID)> disconnect_handler_;
+
+    RateLimiter rate_limiter_;
+    std::vector<uint8_t> deferred_move_; // Payload of the move waiting for a token
+    bool has_deferred_move_{false};
+    boost::asio::steady_timer deferred_move_timer_;
+    bool deferred_move_timer_armed_{false};
+
+    // Negotiated in the Connect handshake; read by senders on other threads
+    std::atomic<uint32_t> capabilities_{0};
+    CompactLayout compact_layout_;
+    SharedPayload name_dictionary_;
+    std::vector<uint8_t> expanded_payload_;
+
+    // One deflate stream per direction, created when compression is accepted
+    size_t compression_threshold_{default_compression_threshold};
+    std::unique_ptr<PayloadCompressor> compressor_;
+    std::unique_ptr<PayloadDecompressor> decompressor_;
+    std::vector<uint8_t> decompressed_payload_;
 
     enum
     {
-        header_length = 4
+        default_receive_buffer_length = 16 * 1024, // Used when no pool is supplied
+        max_message_length = 1024 * 1024,
+        max_write_batch_buffers = 64, // Largest sequence Asio passes to a single writev
+        default_compression_threshold = 256
     };
-    std::vector<uint8_t> read_buffer_;
-    std::queue<std::vector<uint8_t>> write_queue_;
-    Message current_read_message_;
-    uint32_t current_message_size_{0};
-    uint32_t message_length_{0}; // Added missing member
+
+    // Snapshots are marked so an unsent one can be dropped when a newer one arrives. The first
+    // committed_messages_ entries have been handed to a write or the deflate stream and must go out.
+    struct QueuedPayload
+    {
+        SharedPayload payload;
+        bool snapshot;
+    };
+    std::deque<QueuedPayload> write_queue_;
+    size_t committed_messages_{0};
+    size_t queued_bytes_{0};
+    WriteQueueLimits write_queue_limits_;
+    bool over_write_queue_limits_{false};
+    std::chrono::steady_clock::time_point over_write_queue_limits_since_;
+
+    // Cheap-to-copy range over write_buffers_; the write operation keeps a copy of its buffer sequence
+    struct WriteBatch
+    {
+        const boost::asio::const_buffer *first;
+        const boost::asio::const_buffer *last;
+        const boost::asio::const_buffer *begin() const { return first; }
+        const boost::asio::const_buffer *end() const { return last; }
+    };
+    std::vector<boost::asio::const_buffer> write_buffers_;
+    size_t write_offset_{0};
+    size_t max_write_batch_bytes_{64 * 1024};
+    ConnectionStats stats_;
     bool writing_{false};
-    std::vector<uint8_t> message_buffer_;
+
+    // Reads land in a block borrowed from the pool; only frames larger than a
+    // block spill into the decoder's own grow-only buffer
+    std::shared_ptr<BufferPool> buffer_pool_;
+    uint8_t *pooled_buffer_{nullptr};
+    FrameDecoder decoder_;
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    boost::asio::mutable_registered_buffer registered_block_; // pooled_buffer_ as registered with our io_context
+#endif
 };
\ No newline at end of file
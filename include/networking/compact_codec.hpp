@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "message.hpp"
+
+// Coordinate widths for the compact encoding; both ends derive them from the map size
+// sent in ConnectResponse
+struct CompactLayout
+{
+    uint16_t width{0};
+    uint16_t height{0};
+    uint8_t x_bits{0};
+    uint8_t y_bits{0};
+
+    CompactLayout() = default;
+    CompactLayout(uint16_t map_width, uint16_t map_height);
+
+    bool contains(int x, int y) const { return x >= 0 && y >= 0 && x < width && y < height; }
+};
+
+// Compact wire encoding for connections that negotiated capabilities::compact_encoding.
+// Frames set message_flags::compact and carry a LEB128 size instead of the 4-byte one.
+// Commands with a compact form also shrink their payload:
+//   PlayerMove    [packed x,y][varint count][varint first id][varint id deltas...] (ids sorted)
+//   PlayerBuild   [packed x,y][varint building type]
+//   PlayerAttack  [varint attacker][varint target]
+//   PlayerHarvest [varint unit][varint resource]
+// where packed x,y is x_bits + y_bits little-endian bits rounded up to whole bytes.
+// Every other type keeps its standard payload.
+namespace compact_codec
+{
+    void write_varint(std::vector<uint8_t> &vec, uint64_t value);
+    bool read_varint(const uint8_t *&position, const uint8_t *end, uint64_t &value);
+
+    bool has_compact_payload(MessageType type);
+
+    // Appends the serialized message in compact form; a move or build outside the layout
+    // falls back to the standard form
+    void serialize(const Message &message, const CompactLayout &layout, std::vector<uint8_t> &out);
+
+    // Rewrites a compact payload into the standard layout the handlers read; false if malformed
+    bool expand(const MessageView &message, const CompactLayout &layout, std::vector<uint8_t> &out);
+}
\ No newline at end of file
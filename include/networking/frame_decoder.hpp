@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "message.hpp"
+
+// Splits a byte stream of length-prefixed frames ([u32 big-endian length][serialized Message])
+// into MessageViews. Bytes are read straight into the decoder's buffer and every complete frame
+// is handed out in place; a partial frame at the end waits for the next read. Frames never wrap,
+// so when the tail runs short the unread bytes are moved back to the front.
+class FrameDecoder
+{
+public:
+    enum class Status
+    {
+        Frame,     // view holds the next frame
+        NeedMore,  // no complete frame buffered
+        Oversized, // length header above max_frame_length
+        Malformed  // frame body is not a valid message
+    };
+
+    static constexpr size_t header_length = 4;
+
+    // storage may be null, in which case the decoder allocates its own buffer of capacity bytes
+    FrameDecoder(uint8_t *storage, size_t capacity, size_t max_frame_length);
+
+    // Free space after the buffered bytes; read_some into it, then commit what arrived
+    uint8_t *write_position() { return buffer_ + write_; }
+    size_t write_space() const { return capacity_ - write_; }
+    void commit(size_t bytes) { write_ += bytes; }
+
+    // Views returned here stay valid until the next call to next() or commit()
+    Status next(MessageView &view);
+
+    size_t buffered() const { return write_ - read_; }
+
+private:
+    void make_room(size_t frame_length);
+    void compact();
+
+    uint8_t *storage_;
+    size_t storage_capacity_;
+    size_t max_frame_length_;
+
+    // Active buffer: storage_ normally, overflow_ while a frame larger than storage_ is buffered
+    uint8_t *buffer_;
+    size_t capacity_;
+    size_t read_{0};
+    size_t write_{0};
+    std::vector<uint8_t> owned_storage_;
+    std::vector<uint8_t> overflow_;
+};
\ No newline at end of file
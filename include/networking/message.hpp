@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
+#include "../utils/types.hpp"
+#include "../utils/name_table.hpp"
 
 enum class MessageType : uint8_t
 {
@@ -38,7 +42,61 @@ enum class MessageType : uint8_t
     UpgradeListResponse,
 
     // Error messages
-    Error
+    Error,
+
+    // Snapshot messages (world state itself goes out as ResourceUpdate)
+    SnapshotAck,
+
+    // Sent after ConnectResponse to clients using interned names
+    NameDictionary,
+
+    // Part of the map the client is looking at, for area-of-interest filtering of snapshots
+    CameraUpdate,
+
+    // Lockstep rooms: the commands the server applied in a turn, a peer's checksum of the world
+    // after it, and the server's notice that a peer's checksum stopped matching its own
+    LockstepTurn,
+    StateHash,
+    LockstepDesync
+};
+
+// Number of MessageType values; new types go at the end of the enum, before updating this
+constexpr size_t message_type_count = static_cast<size_t>(MessageType::LockstepDesync) + 1;
+
+// High bits of the serialized type byte; the low bits hold the MessageType
+namespace message_flags
+{
+    constexpr uint8_t compact = 0x80;    // LEB128 size and compact payload, see compact_codec.hpp
+    constexpr uint8_t compressed = 0x40; // Payload deflated, see payload_compressor.hpp
+    constexpr uint8_t all = compact | compressed;
+}
+
+// Optional protocol features a client offers in Connect and the server accepts in ConnectResponse
+namespace capabilities
+{
+    constexpr uint32_t compact_encoding = 1 << 0;
+    constexpr uint32_t interned_names = 1 << 1;      // Upgrade, technology and resource names sent as NameIDs
+    constexpr uint32_t compressed_payloads = 1 << 2; // Large payloads deflated in both directions
+}
+
+struct Message;
+
+// Immutable serialized message, shared by every write queue it is sent to
+using SharedPayload = std::shared_ptr<const std::vector<uint8_t>>;
+
+// Non-owning view of a message; the payload points into the buffer it was parsed from
+struct MessageView
+{
+    MessageType type;
+    const uint8_t *data{nullptr};
+    size_t size{0};
+    uint32_t player_id{0};
+    bool compact{false};    // Payload still in compact form
+    bool compressed{false}; // Payload still deflated
+
+    const uint8_t *begin() const { return data; }
+    const uint8_t *end() const { return data + size; }
+    Message to_message() const;
 };
 
 struct Message
@@ -48,8 +106,9 @@ struct Message
     uint32_t player_id{0}; // Added player_id field
 
     // Basic message creation
-    static Message create_connect(const std::string &player_name);
+    static Message create_connect(const std::string &player_name, uint32_t offered_capabilities = 0);
     static Message create_chat(const std::string &text, bool team_only);
+    static Message create_chat_broadcast(uint32_t sender_id, const std::string &text, bool team_only);
     static Message create_move(int x, int y, std::vector<uint32_t> unit_ids);
     static Message create_build(int x, int y, uint32_t building_type);
     static Message create_attack(uint32_t attacker_id, uint32_t target_id);
@@ -64,6 +123,29 @@ struct Message
     static Message create_upgrade_list_response(const std::vector<std::string> &available_upgrades,
                                                 const std::vector<std::string> &available_technologies);
 
+    // Interned-name forms, for connections that negotiated capabilities::interned_names
+    static Message create_upgrade_request(NameID upgrade_id);
+    static Message create_upgrade_response(bool success, NameID upgrade_id, int new_level);
+    static Message create_technology_request(NameID tech_id);
+    static Message create_technology_response(bool success, NameID tech_id);
+    static Message create_upgrade_list_response(const std::vector<NameID> &available_upgrades,
+                                                const std::vector<NameID> &available_technologies);
+    static Message create_name_dictionary(const NameTable &upgrades, const NameTable &technologies,
+                                          const NameTable &resources);
+
+    // Snapshot acknowledgment
+    static Message create_snapshot_ack(uint32_t sequence);
+    static Message create_camera_update(int x, int y, int width, int height);
+
+    // Lockstep peer's checksum after a turn
+    static Message create_state_hash(uint32_t turn, uint64_t checksum);
+
+    MessageView view() const { return MessageView{type, data.data(), data.size(), player_id}; }
+
     std::vector<uint8_t> serialize() const;
+    SharedPayload serialize_shared() const;
     static Message deserialize(const std::vector<uint8_t> &data);
+
+    // Parses a serialized message (standard or compact header, possibly compressed) in place; returns false if the buffer is truncated
+    static bool parse(const uint8_t *buffer, size_t length, MessageView &view);
 };
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include "message_payloads.hpp"
+
+class ClientConnection;
+
+// Flat table of typed message handlers indexed by MessageType, built once by the server and
+// shared by every connection. A handler is a member function taking the connection and the
+// decoded payload:
+//
+//   dispatcher.on<payload::Move, &CastleServer::handle_move>(this);
+//
+// Each entry holds a function pointer generated for that member, so a message costs one table
+// load, the authentication check, the decode and a direct call. Connections that negotiated
+// interned names look in the table filled by on_interned first and fall back to the shared one.
+class MessageDispatcher
+{
+public:
+    enum class Access
+    {
+        Authenticated, // Dropped until the connection has completed Connect
+        Any
+    };
+
+    enum class Result
+    {
+        Handled,
+        Unregistered,
+        Unauthenticated,
+        Malformed
+    };
+
+    template <typename Payload, auto Handler, typename Target>
+    void on(Target *target, Access access = Access::Authenticated)
+    {
+        set<Payload, Handler>(standard_, target, access);
+    }
+
+    template <typename Payload, auto Handler, typename Target>
+    void on_interned(Target *target, Access access = Access::Authenticated)
+    {
+        set<Payload, Handler>(interned_, target, access);
+    }
+
+    Result dispatch(ClientConnection &connection, const MessageView &message) const;
+
+private:
+    using Thunk = bool (*)(void *target, ClientConnection &connection, const MessageView &message);
+
+    struct Entry
+    {
+        Thunk thunk{nullptr};
+        void *target{nullptr};
+        Access access{Access::Authenticated};
+    };
+    using Table = std::array<Entry, message_type_count>;
+
+    template <typename Payload, auto Handler, typename Target>
+    static bool invoke(void *target, ClientConnection &connection, const MessageView &message)
+    {
+        Payload payload;
+        if (!message_schema::decode(message, payload))
+        {
+            return false;
+        }
+        (static_cast<Target *>(target)->*Handler)(connection, payload);
+        return true;
+    }
+
+    template <typename Payload, auto Handler, typename Target>
+    static void set(Table &table, Target *target, Access access)
+    {
+        table[static_cast<size_t>(Payload::type)] = Entry{&invoke<Payload, Handler, Target>, target, access};
+    }
+
+    Table standard_{};
+    Table interned_{};
+};
\ No newline at end of file
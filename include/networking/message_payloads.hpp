@@ -0,0 +1,261 @@
+#pragma once
+
+#include "../utils/types.hpp"
+#include "message_schema.hpp"
+
+// Wire layout of every message with a fixed payload shape; see message_schema.hpp. Adding a
+// message is a MessageType and a struct here. ResourceUpdate snapshots have their own encoder
+// in server/snapshot.hpp.
+namespace payload
+{
+    using message_schema::ArrayView;
+    using message_schema::StringList;
+    using message_schema::Trailing;
+
+    struct Connect
+    {
+        static constexpr MessageType type = MessageType::Connect;
+        std::string_view player_name;
+        Trailing<uint32_t> offered_capabilities; // Absent from clients that predate capabilities
+        static constexpr auto fields() { return std::make_tuple(&Connect::player_name, &Connect::offered_capabilities); }
+    };
+
+    // Sent only to clients that offered capabilities; others get an empty ConnectResponse
+    struct ConnectResponse
+    {
+        static constexpr MessageType type = MessageType::ConnectResponse;
+        uint32_t accepted_capabilities;
+        uint16_t map_width;
+        uint16_t map_height;
+        static constexpr auto fields()
+        {
+            return std::make_tuple(&ConnectResponse::accepted_capabilities, &ConnectResponse::map_width,
+                                   &ConnectResponse::map_height);
+        }
+    };
+
+    // Chat from a client, and the server's relay of it
+    struct Chat
+    {
+        static constexpr MessageType type = MessageType::ChatMessage;
+        bool team_only;
+        std::string_view text;
+        static constexpr auto fields() { return std::make_tuple(&Chat::team_only, &Chat::text); }
+    };
+
+    struct ChatBroadcast
+    {
+        static constexpr MessageType type = MessageType::ChatMessage;
+        uint32_t sender_id;
+        bool team_only;
+        std::string_view text;
+        static constexpr auto fields() { return std::make_tuple(&ChatBroadcast::sender_id, &ChatBroadcast::team_only, &ChatBroadcast::text); }
+    };
+
+    // Player commands; compact_codec.hpp has their compact forms
+    struct Move
+    {
+        static constexpr MessageType type = MessageType::PlayerMove;
+        int x;
+        int y;
+        ArrayView<uint32_t> unit_ids;
+        static constexpr auto fields() { return std::make_tuple(&Move::x, &Move::y, &Move::unit_ids); }
+    };
+
+    struct Build
+    {
+        static constexpr MessageType type = MessageType::PlayerBuild;
+        int x;
+        int y;
+        uint32_t building_type;
+        static constexpr auto fields() { return std::make_tuple(&Build::x, &Build::y, &Build::building_type); }
+    };
+
+    struct Attack
+    {
+        static constexpr MessageType type = MessageType::PlayerAttack;
+        uint32_t attacker_id;
+        uint32_t target_id;
+        static constexpr auto fields() { return std::make_tuple(&Attack::attacker_id, &Attack::target_id); }
+    };
+
+    struct Harvest
+    {
+        static constexpr MessageType type = MessageType::PlayerHarvest;
+        uint32_t unit_id;
+        uint32_t resource_id;
+        static constexpr auto fields() { return std::make_tuple(&Harvest::unit_id, &Harvest::resource_id); }
+    };
+
+    // A player's arrival, as carried in lockstep turns and replays; the room queues it for each
+    // new member, and clients cannot send it
+    struct JoinGame
+    {
+        static constexpr MessageType type = MessageType::JoinGame;
+        int x;
+        int y;
+        static constexpr auto fields() { return std::make_tuple(&JoinGame::x, &JoinGame::y); }
+    };
+
+    // Upgrades and technologies by name
+    struct UpgradeRequest
+    {
+        static constexpr MessageType type = MessageType::RequestUpgrade;
+        std::string_view upgrade_name;
+        static constexpr auto fields() { return std::make_tuple(&UpgradeRequest::upgrade_name); }
+    };
+
+    struct UpgradeResponse
+    {
+        static constexpr MessageType type = MessageType::UpgradeResponse;
+        bool success;
+        std::string_view upgrade_name;
+        int new_level;
+        static constexpr auto fields() { return std::make_tuple(&UpgradeResponse::success, &UpgradeResponse::upgrade_name, &UpgradeResponse::new_level); }
+    };
+
+    struct TechnologyRequest
+    {
+        static constexpr MessageType type = MessageType::RequestTechnology;
+        std::string_view tech_name;
+        static constexpr auto fields() { return std::make_tuple(&TechnologyRequest::tech_name); }
+    };
+
+    struct TechnologyResponse
+    {
+        static constexpr MessageType type = MessageType::TechnologyResponse;
+        bool success;
+        std::string_view tech_name;
+        static constexpr auto fields() { return std::make_tuple(&TechnologyResponse::success, &TechnologyResponse::tech_name); }
+    };
+
+    struct UpgradeListRequest
+    {
+        static constexpr MessageType type = MessageType::UpgradeListRequest;
+        static constexpr auto fields() { return std::make_tuple(); }
+    };
+
+    struct UpgradeListResponse
+    {
+        static constexpr MessageType type = MessageType::UpgradeListResponse;
+        StringList<> available_upgrades;
+        StringList<> available_technologies;
+        static constexpr auto fields() { return std::make_tuple(&UpgradeListResponse::available_upgrades, &UpgradeListResponse::available_technologies); }
+    };
+
+    // The same messages on connections that negotiated capabilities::interned_names
+    struct InternedUpgradeRequest
+    {
+        static constexpr MessageType type = MessageType::RequestUpgrade;
+        NameID upgrade_id;
+        static constexpr auto fields() { return std::make_tuple(&InternedUpgradeRequest::upgrade_id); }
+    };
+
+    struct InternedUpgradeResponse
+    {
+        static constexpr MessageType type = MessageType::UpgradeResponse;
+        bool success;
+        NameID upgrade_id;
+        int new_level;
+        static constexpr auto fields() { return std::make_tuple(&InternedUpgradeResponse::success, &InternedUpgradeResponse::upgrade_id, &InternedUpgradeResponse::new_level); }
+    };
+
+    struct InternedTechnologyRequest
+    {
+        static constexpr MessageType type = MessageType::RequestTechnology;
+        NameID tech_id;
+        static constexpr auto fields() { return std::make_tuple(&InternedTechnologyRequest::tech_id); }
+    };
+
+    struct InternedTechnologyResponse
+    {
+        static constexpr MessageType type = MessageType::TechnologyResponse;
+        bool success;
+        NameID tech_id;
+        static constexpr auto fields() { return std::make_tuple(&InternedTechnologyResponse::success, &InternedTechnologyResponse::tech_id); }
+    };
+
+    struct InternedUpgradeListResponse
+    {
+        static constexpr MessageType type = MessageType::UpgradeListResponse;
+        ArrayView<NameID, uint16_t> available_upgrades;
+        ArrayView<NameID, uint16_t> available_technologies;
+        static constexpr auto fields() { return std::make_tuple(&InternedUpgradeListResponse::available_upgrades, &InternedUpgradeListResponse::available_technologies); }
+    };
+
+    // Upgrade, technology and resource names; a NameID is the position within its list
+    struct NameDictionary
+    {
+        static constexpr MessageType type = MessageType::NameDictionary;
+        StringList<uint16_t> upgrades;
+        StringList<uint16_t> technologies;
+        StringList<uint16_t> resources;
+        static constexpr auto fields() { return std::make_tuple(&NameDictionary::upgrades, &NameDictionary::technologies, &NameDictionary::resources); }
+    };
+
+    struct SnapshotAck
+    {
+        static constexpr MessageType type = MessageType::SnapshotAck;
+        uint32_t sequence;
+        static constexpr auto fields() { return std::make_tuple(&SnapshotAck::sequence); }
+    };
+
+    // In tiles
+    struct CameraUpdate
+    {
+        static constexpr MessageType type = MessageType::CameraUpdate;
+        int x;
+        int y;
+        int width;
+        int height;
+        static constexpr auto fields() { return std::make_tuple(&CameraUpdate::x, &CameraUpdate::y, &CameraUpdate::width, &CameraUpdate::height); }
+    };
+
+    // Head of a LockstepTurn; command_count TurnCommand entries follow it
+    struct LockstepTurn
+    {
+        static constexpr MessageType type = MessageType::LockstepTurn;
+        uint32_t turn;
+        uint32_t command_count;
+        static constexpr auto fields() { return std::make_tuple(&LockstepTurn::turn, &LockstepTurn::command_count); }
+    };
+
+    // One command inside a LockstepTurn, not a message of its own: who sent it, and the command
+    // as the payload of a command_type message (Move, Build, Attack or Harvest)
+    struct TurnCommand
+    {
+        PlayerID player_id;
+        MessageType command_type;
+        std::string_view body;
+        static constexpr auto fields() { return std::make_tuple(&TurnCommand::player_id, &TurnCommand::command_type, &TurnCommand::body); }
+    };
+
+    // A lockstep peer's checksum of the world after applying a turn; see GameState::checksum
+    struct StateHash
+    {
+        static constexpr MessageType type = MessageType::StateHash;
+        uint32_t turn;
+        uint64_t checksum;
+        static constexpr auto fields() { return std::make_tuple(&StateHash::turn, &StateHash::checksum); }
+    };
+
+    // Sent once, when a peer first reports a checksum that differs from the server's. The peer's
+    // world went wrong after last_good_turn and by first_bad_turn; 0 means no turn matched.
+    struct LockstepDesync
+    {
+        static constexpr MessageType type = MessageType::LockstepDesync;
+        uint32_t first_bad_turn;
+        uint32_t last_good_turn;
+        uint64_t expected_checksum;
+        static constexpr auto fields()
+        {
+            return std::make_tuple(&LockstepDesync::first_bad_turn, &LockstepDesync::last_good_turn,
+                                   &LockstepDesync::expected_checksum);
+        }
+    };
+
+    // Responses a client receives, by connection mode; the first payload with a matching type is used
+    using ClientInbound = message_schema::PayloadSet<UpgradeResponse, TechnologyResponse, UpgradeListResponse>;
+    using InternedClientInbound = message_schema::PayloadSet<InternedUpgradeResponse, InternedTechnologyResponse,
+                                                             InternedUpgradeListResponse, NameDictionary>;
+}
\ No newline at end of file
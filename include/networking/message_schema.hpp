@@ -0,0 +1,384 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "message.hpp"
+
+// Compile-time description of message payloads. A payload struct names its MessageType and
+// lists its fields in wire order; encode, decode and dispatch are generated from that list:
+//
+//   struct Attack
+//   {
+//       static constexpr MessageType type = MessageType::PlayerAttack;
+//       uint32_t attacker_id;
+//       uint32_t target_id;
+//       static constexpr auto fields() { return std::make_tuple(&Attack::attacker_id, &Attack::target_id); }
+//   };
+//
+// Field encodings (native byte order, as the hand-written readers used):
+//   arithmetic and enum types   copied as-is; bool is one byte
+//   std::string_view            [u32 length][bytes]
+//   ArrayView<T, Count>         [Count count][T...]
+//   StringList<Count>           [Count count]([u32 length][bytes])...
+//   Trailing<T>                 T, written only when non-zero and read only if bytes remain
+// Decoded views point into the message buffer, so decoding never allocates and the struct is
+// valid only as long as the buffer. Bytes after the last field are ignored, which lets a
+// payload grow by appending fields.
+namespace message_schema
+{
+    // Fixed-size elements over a byte range; built from a vector to encode, from the wire by decode
+    template <typename T, typename Count = uint32_t>
+    class ArrayView
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        ArrayView() = default;
+        ArrayView(const std::vector<T> &values)
+            : bytes_(reinterpret_cast<const uint8_t *>(values.data())), count_(static_cast<Count>(values.size())) {}
+        ArrayView(const uint8_t *bytes, Count count) : bytes_(bytes), count_(count) {}
+
+        size_t size() const { return count_; }
+        bool empty() const { return count_ == 0; }
+        const uint8_t *bytes() const { return bytes_; }
+        size_t byte_size() const { return count_ * sizeof(T); }
+
+        T operator[](size_t index) const
+        {
+            T value;
+            std::memcpy(&value, bytes_ + index * sizeof(T), sizeof(T));
+            return value;
+        }
+
+        std::vector<T> to_vector() const
+        {
+            std::vector<T> values;
+            copy_to(values);
+            return values;
+        }
+
+        // Replaces the contents of values, reusing its capacity
+        void copy_to(std::vector<T> &values) const
+        {
+            values.resize(count_);
+            if (count_)
+            {
+                std::memcpy(values.data(), bytes_, byte_size());
+            }
+        }
+
+        class iterator
+        {
+        public:
+            iterator(const ArrayView *view, size_t index) : view_(view), index_(index) {}
+            T operator*() const { return (*view_)[index_]; }
+            iterator &operator++()
+            {
+                ++index_;
+                return *this;
+            }
+            bool operator!=(const iterator &other) const { return index_ != other.index_; }
+
+        private:
+            const ArrayView *view_;
+            size_t index_;
+        };
+        iterator begin() const { return iterator(this, 0); }
+        iterator end() const { return iterator(this, count_); }
+
+    private:
+        const uint8_t *bytes_{nullptr};
+        Count count_{0};
+    };
+
+    // Length-prefixed strings; built from a vector to encode, from the wire by decode
+    template <typename Count = uint32_t>
+    class StringList
+    {
+    public:
+        StringList() = default;
+        StringList(const std::vector<std::string> &strings) : strings_(&strings), count_(static_cast<Count>(strings.size())) {}
+        StringList(const uint8_t *bytes, Count count) : bytes_(bytes), count_(count) {}
+
+        size_t size() const { return count_; }
+        bool empty() const { return count_ == 0; }
+
+        template <typename Fn>
+        void for_each(Fn fn) const
+        {
+            if (strings_)
+            {
+                for (const auto &string : *strings_)
+                {
+                    fn(std::string_view(string));
+                }
+                return;
+            }
+
+            const uint8_t *position = bytes_;
+            for (Count i = 0; i < count_; ++i)
+            {
+                uint32_t length;
+                std::memcpy(&length, position, sizeof(length));
+                fn(std::string_view(reinterpret_cast<const char *>(position + sizeof(length)), length));
+                position += sizeof(length) + length;
+            }
+        }
+
+    private:
+        const std::vector<std::string> *strings_{nullptr};
+        const uint8_t *bytes_{nullptr};
+        Count count_{0};
+    };
+
+    // Optional last field, for payloads that older peers send without it
+    template <typename T>
+    struct Trailing
+    {
+        T value{};
+    };
+
+    template <typename T, typename Enable = void>
+    struct FieldCodec
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "no wire encoding for this field type");
+
+        static size_t size(const T &) { return sizeof(T); }
+        static uint8_t *write(uint8_t *out, const T &value)
+        {
+            std::memcpy(out, &value, sizeof(T));
+            return out + sizeof(T);
+        }
+        static bool read(const uint8_t *&position, const uint8_t *end, T &value)
+        {
+            if (static_cast<size_t>(end - position) < sizeof(T))
+            {
+                return false;
+            }
+            std::memcpy(&value, position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+    };
+
+    template <>
+    struct FieldCodec<bool>
+    {
+        static size_t size(bool) { return 1; }
+        static uint8_t *write(uint8_t *out, bool value)
+        {
+            *out = value ? 1 : 0;
+            return out + 1;
+        }
+        static bool read(const uint8_t *&position, const uint8_t *end, bool &value)
+        {
+            if (position == end)
+            {
+                return false;
+            }
+            value = *position++ != 0;
+            return true;
+        }
+    };
+
+    template <>
+    struct FieldCodec<std::string_view>
+    {
+        static size_t size(std::string_view value) { return sizeof(uint32_t) + value.size(); }
+        static uint8_t *write(uint8_t *out, std::string_view value)
+        {
+            out = FieldCodec<uint32_t>::write(out, static_cast<uint32_t>(value.size()));
+            std::memcpy(out, value.data(), value.size());
+            return out + value.size();
+        }
+        static bool read(const uint8_t *&position, const uint8_t *end, std::string_view &value)
+        {
+            uint32_t length;
+            if (!FieldCodec<uint32_t>::read(position, end, length) || length > static_cast<size_t>(end - position))
+            {
+                return false;
+            }
+            value = std::string_view(reinterpret_cast<const char *>(position), length);
+            position += length;
+            return true;
+        }
+    };
+
+    template <typename T, typename Count>
+    struct FieldCodec<ArrayView<T, Count>>
+    {
+        static size_t size(const ArrayView<T, Count> &value) { return sizeof(Count) + value.byte_size(); }
+        static uint8_t *write(uint8_t *out, const ArrayView<T, Count> &value)
+        {
+            out = FieldCodec<Count>::write(out, static_cast<Count>(value.size()));
+            if (value.byte_size())
+            {
+                std::memcpy(out, value.bytes(), value.byte_size());
+            }
+            return out + value.byte_size();
+        }
+        static bool read(const uint8_t *&position, const uint8_t *end, ArrayView<T, Count> &value)
+        {
+            Count count;
+            if (!FieldCodec<Count>::read(position, end, count) ||
+                count > static_cast<size_t>(end - position) / sizeof(T))
+            {
+                return false;
+            }
+            value = ArrayView<T, Count>(position, count);
+            position += value.byte_size();
+            return true;
+        }
+    };
+
+    template <typename Count>
+    struct FieldCodec<StringList<Count>>
+    {
+        static size_t size(const StringList<Count> &value)
+        {
+            size_t total = sizeof(Count);
+            value.for_each([&](std::string_view string)
+                           { total += FieldCodec<std::string_view>::size(string); });
+            return total;
+        }
+        static uint8_t *write(uint8_t *out, const StringList<Count> &value)
+        {
+            out = FieldCodec<Count>::write(out, static_cast<Count>(value.size()));
+            value.for_each([&](std::string_view string)
+                           { out = FieldCodec<std::string_view>::write(out, string); });
+            return out;
+        }
+        static bool read(const uint8_t *&position, const uint8_t *end, StringList<Count> &value)
+        {
+            // Walk every string once so later iteration needs no checks
+            Count count;
+            if (!FieldCodec<Count>::read(position, end, count))
+            {
+                return false;
+            }
+            const uint8_t *start = position;
+            for (Count i = 0; i < count; ++i)
+            {
+                std::string_view string;
+                if (!FieldCodec<std::string_view>::read(position, end, string))
+                {
+                    return false;
+                }
+            }
+            value = StringList<Count>(start, count);
+            return true;
+        }
+    };
+
+    template <typename T>
+    struct FieldCodec<Trailing<T>>
+    {
+        static size_t size(const Trailing<T> &value) { return value.value != T{} ? sizeof(T) : 0; }
+        static uint8_t *write(uint8_t *out, const Trailing<T> &value)
+        {
+            return value.value != T{} ? FieldCodec<T>::write(out, value.value) : out;
+        }
+        static bool read(const uint8_t *&position, const uint8_t *end, Trailing<T> &value)
+        {
+            value.value = T{};
+            return position == end || FieldCodec<T>::read(position, end, value.value);
+        }
+    };
+
+    template <typename Payload, typename Field>
+    using field_codec = FieldCodec<std::remove_cv_t<std::remove_reference_t<decltype(std::declval<const Payload &>().*std::declval<Field>())>>>;
+
+    // Sizes the payload once, then writes every field straight into place
+    template <typename Payload>
+    Message encode(const Payload &payload)
+    {
+        Message message;
+        message.type = Payload::type;
+        std::apply([&](auto... fields)
+                   {
+            size_t size = (size_t{0} + ... + field_codec<Payload, decltype(fields)>::size(payload.*fields));
+            message.data.resize(size);
+            uint8_t *out = message.data.data();
+            ((out = field_codec<Payload, decltype(fields)>::write(out, payload.*fields)), ...);
+            (void)out; },
+                   Payload::fields());
+        return message;
+    }
+
+    // Appends the payload's fields to out, for messages that carry other payloads inside them
+    template <typename Payload>
+    void encode_to(std::vector<uint8_t> &out, const Payload &payload)
+    {
+        std::apply([&](auto... fields)
+                   {
+            size_t size = (size_t{0} + ... + field_codec<Payload, decltype(fields)>::size(payload.*fields));
+            size_t offset = out.size();
+            out.resize(offset + size);
+            uint8_t *position = out.data() + offset;
+            ((position = field_codec<Payload, decltype(fields)>::write(position, payload.*fields)), ...);
+            (void)position; },
+                   Payload::fields());
+    }
+
+    // Reads a payload embedded at position, leaving position after it; the counterpart of encode_to
+    template <typename Payload>
+    bool decode_from(const uint8_t *&position, const uint8_t *end, Payload &payload)
+    {
+        return std::apply([&](auto... fields)
+                          { return (field_codec<Payload, decltype(fields)>::read(position, end, payload.*fields) && ...); },
+                          Payload::fields());
+    }
+
+    // Reads the fields in order, checking each against the payload size; false if truncated
+    template <typename Payload>
+    bool decode(const MessageView &message, Payload &payload)
+    {
+        const uint8_t *position = message.data;
+        return decode_from(position, message.data + message.size, payload);
+    }
+
+    enum class DispatchResult
+    {
+        Handled,
+        Malformed, // Type matched but the payload did not decode
+        Unhandled  // No payload in the set has this type
+    };
+
+    // Decodes the message as the first payload in the set with its type and calls handler with it
+    template <typename... Payloads>
+    struct PayloadSet
+    {
+        template <typename Handler>
+        static DispatchResult dispatch(const MessageView &message, Handler &&handler)
+        {
+            DispatchResult result = DispatchResult::Unhandled;
+            (try_payload<Payloads>(message, handler, result) || ...);
+            return result;
+        }
+
+    private:
+        template <typename Payload, typename Handler>
+        static bool try_payload(const MessageView &message, Handler &handler, DispatchResult &result)
+        {
+            if (message.type != Payload::type)
+            {
+                return false;
+            }
+            Payload payload;
+            if (!decode(message, payload))
+            {
+                result = DispatchResult::Malformed;
+                return true;
+            }
+            handler(payload);
+            result = DispatchResult::Handled;
+            return true;
+        }
+    };
+}
\ No newline at end of file
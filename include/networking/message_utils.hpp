@@ -2,8 +2,10 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstring>
 #include <cstdint>
+#include "message.hpp"
 
 namespace message_utils
 {
@@ -37,4 +39,57 @@ namespace message_utils
         offset += length;
         return str;
     }
+
+    // Appends a message with the 4-byte big-endian length prefix ClientConnection reads
+    inline void write_frame(std::vector<uint8_t> &vec, const Message &message)
+    {
+        auto body = message.serialize();
+        uint32_t length = static_cast<uint32_t>(body.size());
+        vec.push_back(static_cast<uint8_t>(length >> 24));
+        vec.push_back(static_cast<uint8_t>(length >> 16));
+        vec.push_back(static_cast<uint8_t>(length >> 8));
+        vec.push_back(static_cast<uint8_t>(length));
+        vec.insert(vec.end(), body.begin(), body.end());
+    }
+
+    // Readers over a MessageView, used on the inbound path to avoid copying the payload. Each
+    // checks the read against the payload size and returns false, leaving offset alone, if it
+    // would run past the end.
+    template <typename T>
+    bool read_from_view(const MessageView &view, size_t &offset, T &value)
+    {
+        if (offset > view.size || view.size - offset < sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&value, view.data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    // The view points into the message buffer
+    inline bool read_string_view(const MessageView &view, size_t &offset, std::string_view &str)
+    {
+        size_t start = offset;
+        uint32_t length = 0;
+        if (!read_from_view(view, offset, length) || view.size - offset < length)
+        {
+            offset = start;
+            return false;
+        }
+        str = std::string_view(reinterpret_cast<const char *>(view.data + offset), length);
+        offset += length;
+        return true;
+    }
+
+    inline bool read_string(const MessageView &view, size_t &offset, std::string &str)
+    {
+        std::string_view value;
+        if (!read_string_view(view, offset, value))
+        {
+            return false;
+        }
+        str.assign(value);
+        return true;
+    }
 }
\ No newline at end of file
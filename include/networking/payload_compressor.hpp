@@ -0,0 +1,54 @@
+#pragma once
+
+#include <zlib.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "message.hpp"
+
+// Compressed frames for connections that negotiated capabilities::compressed_payloads.
+// The type byte gains message_flags::compressed and the payload (standard or compact form) is
+// replaced by the next chunk of that direction's raw deflate stream. Each chunk ends on a sync
+// flush with its trailing 00 00 ff ff dropped, so a message decodes as soon as it arrives while
+// the 32 KB window carries over: names and layouts repeated from earlier messages cost a few bytes.
+class PayloadCompressor
+{
+public:
+    explicit PayloadCompressor(int level = Z_BEST_SPEED);
+    ~PayloadCompressor();
+
+    PayloadCompressor(const PayloadCompressor &) = delete;
+    PayloadCompressor &operator=(const PayloadCompressor &) = delete;
+
+    // Appends the compressed frame to out, keeping the message's header form; false if zlib
+    // fails, after which the stream is out of step with the peer and the connection must close
+    bool compress(const MessageView &message, std::vector<uint8_t> &out);
+
+private:
+    z_stream stream_{};
+    bool initialized_{false}; // The stream needs ending, even after it has failed
+    bool ready_{false};
+};
+
+class PayloadDecompressor
+{
+public:
+    PayloadDecompressor();
+    ~PayloadDecompressor();
+
+    PayloadDecompressor(const PayloadDecompressor &) = delete;
+    PayloadDecompressor &operator=(const PayloadDecompressor &) = delete;
+
+    // Replaces out with the payload of one compressed message; false if it is corrupt or
+    // inflates past max_size
+    bool decompress(const uint8_t *data, size_t size, size_t max_size, std::vector<uint8_t> &out);
+
+private:
+    bool inflate_into(const uint8_t *data, size_t size, size_t max_size, std::vector<uint8_t> &out);
+    // Once out has reached max_size: whether the input left inflates to nothing more
+    bool inflate_finished();
+
+    z_stream stream_{};
+    bool initialized_{false}; // The stream needs ending, even after it has failed
+    bool ready_{false};
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include "message.hpp"
+
+// Token bucket settings: rate tokens a second, holding at most burst. Each message takes one
+// token. A zero rate means no limit.
+struct RateLimit
+{
+    double rate{0};
+    double burst{0};
+};
+
+// Limits for one connection: every message counts against connection, and against the entry for
+// its type. Disconnect is never limited.
+struct RateLimits
+{
+    RateLimit connection;
+    std::array<RateLimit, message_type_count> per_type{};
+
+    RateLimit &operator[](MessageType type) { return per_type[static_cast<size_t>(type)]; }
+    const RateLimit &operator[](MessageType type) const { return per_type[static_cast<size_t>(type)]; }
+
+    // Generous for a human player, far below what a flooding client sends
+    static RateLimits defaults();
+};
+
+class TokenBucket
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void configure(const RateLimit &limit, Clock::time_point now);
+    bool limited() const { return limit_.rate > 0; }
+
+    // Refills for the time since the last call, then reports whether a token is there
+    bool available(Clock::time_point now);
+    void take() { tokens_ -= 1; }
+    // How long until available() turns true; zero if it already is
+    Clock::duration time_until_available() const;
+
+private:
+    RateLimit limit_;
+    double tokens_{0};
+    Clock::time_point last_refill_;
+};
+
+// The buckets of one connection
+class RateLimiter
+{
+public:
+    using Clock = TokenBucket::Clock;
+
+    void configure(const RateLimits &limits, Clock::time_point now);
+    bool enabled() const { return enabled_; }
+
+    // Takes a token from the connection and type buckets, or from neither if either is empty
+    bool allow(MessageType type, Clock::time_point now);
+    Clock::duration time_until_allowed(MessageType type) const;
+
+private:
+    TokenBucket connection_;
+    std::array<TokenBucket, message_type_count> per_type_;
+    bool enabled_{false};
+};
\ No newline at end of file
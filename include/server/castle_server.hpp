@@ -3,55 +3,62 @@
 #include <boost/asio.hpp>
 #include <memory>
 #include <vector>
-#include <map>
+#include <mutex>
 #include "../utils/types.hpp"
-#include "game_state.hpp"
-#include "player_manager.hpp"
-#include "map.hpp"
-#include "resource_manager.hpp"
-#include "chat_handler.hpp"
-#include "timer.hpp"
+#include "room_manager.hpp"
 #include "../networking/client_connection.hpp"
+#include "../utils/slot_map.hpp"
 
 using boost::asio::ip::tcp;
 
+// Accepts connections and hands each one to a room, where the match it plays in runs. The
+// server itself only owns the listeners, the connection registry and what every connection
+// shares, such as the receive buffer pool.
 class CastleServer
 {
 public:
-    CastleServer(boost::asio::io_context &io_context, unsigned short port);
+    // Rooms tick on room_context; with reuse_port set, further acceptors can bind the same port
+    // through add_listener
+    CastleServer(boost::asio::io_context &io_context, boost::asio::io_context &room_context, unsigned short port,
+                 bool reuse_port = false);
     ~CastleServer();
 
     void start();
     void stop();
+    void add_listener(boost::asio::io_context &io_context);
     std::shared_ptr<ClientConnection> handle_client(tcp::socket socket);
-    GameState *get_game_state() { return game_state_.get(); }
+    size_t get_connection_count();
     void set_cheat_enabled(bool enabled) { cheat_enabled_ = enabled; }
-    void set_game_speed(float speed) { game_speed_ = speed; }
+    void set_write_queue_limits(const WriteQueueLimits &limits) { write_queue_limits_ = limits; }
+    // Applies to connections accepted afterwards; RateLimits{} turns limiting off
+    void set_rate_limits(const RateLimits &limits) { rate_limits_ = limits; }
+    // Applies to rooms created afterwards
+    void set_room_settings(const RoomSettings &settings) { room_manager_->set_settings(settings); }
+    RoomManager &get_room_manager() { return *room_manager_; }
+    GameLoopStats get_tick_stats() const { return room_manager_->get_tick_stats(); }
 
-    // Upgrade system handlers
-    void handle_upgrade_request(PlayerID player_id, const Message &message);
-    void handle_technology_request(PlayerID player_id, const Message &message);
-    void handle_upgrade_list_request(PlayerID player_id);
-    void send_upgrade_response(PlayerID player_id, bool success,
-                               const std::string &upgrade_name, int new_level);
-    void send_technology_response(PlayerID player_id, bool success,
-                                  const std::string &tech_name);
+    // Sent to every connection, whatever its room; serialized once and shared
+    void broadcast(const Message &message);
 
 private:
-    void accept_connections();
+    void accept_connections(tcp::acceptor &acceptor);
     void handle_accept(std::error_code ec, tcp::socket socket);
+    std::unique_ptr<tcp::acceptor> open_acceptor(boost::asio::io_context &io_context);
+    void remove_connection(PlayerID player_id);
 
     boost::asio::io_context &io_context_;
-    tcp::acceptor acceptor_;
-    std::unique_ptr<GameState> game_state_;
-    std::unique_ptr<PlayerManager> player_manager_;
-    std::unique_ptr<Map> map_;
-    std::unique_ptr<ResourceManager> resource_manager_;
-    std::unique_ptr<ChatHandler> chat_handler_;
-    std::unique_ptr<Timer> timer_;
+    unsigned short port_;
+    bool reuse_port_;
+    std::vector<std::unique_ptr<tcp::acceptor>> acceptors_;
+    std::unique_ptr<RoomManager> room_manager_;
+    std::shared_ptr<BufferPool> receive_pool_;
+    SharedPayload name_dictionary_;
+    WriteQueueLimits write_queue_limits_;
+    RateLimits rate_limits_{RateLimits::defaults()};
     bool cheat_enabled_{false};
-    float game_speed_{1.0f};
     bool running_{false};
-    std::vector<std::shared_ptr<ClientConnection>> clients_;
-    std::map<PlayerID, std::shared_ptr<ClientConnection>> connections_;
+    std::mutex clients_mutex_; // Acceptors and handlers may run on several threads
+    // A connection's handle is its player id. Closed connections are removed by a posted
+    // remove_connection, never while a fan-out holds clients_mutex_.
+    SlotMap<std::shared_ptr<ClientConnection>> connections_;
 };
\ No newline at end of file
@@ -27,6 +27,7 @@ public:
     bool is_player_muted(PlayerID player_id) const;
     void mute_player(PlayerID player_id);
     void unmute_player(PlayerID player_id);
+    size_t get_memory_usage() const;
 
 private:
     std::deque<ChatMessage> message_history_;
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../utils/types.hpp"
+
+// A player command decoded on a network thread, waiting for the simulation tick
+struct PlayerCommand
+{
+    enum class Kind : uint8_t
+    {
+        Move,
+        Build,
+        Attack,
+        Harvest,
+        Join // Queued by the room for a new member, not sent by clients
+    };
+
+    Kind kind{Kind::Move};
+    PlayerID player_id{0};
+    std::uint64_t sequence{0}; // Queue order; the tick applies commands in this order
+    std::chrono::steady_clock::time_point received_at;
+
+    int x{0}; // Move, Build, Join: where the player's starting units go
+    int y{0};
+    uint32_t building_type{0}; // Build
+    UnitID unit_id{0};         // Attack: the attacker, Harvest: the harvester
+    uint32_t target_id{0};     // Attack: the target unit, Harvest: the resource
+    std::vector<UnitID> unit_ids; // Move
+};
+
+struct CommandQueueStats
+{
+    std::uint64_t pushed{0};
+    std::uint64_t rejected_full{0};
+    std::uint64_t drains{0};
+    std::uint64_t drained{0};
+    std::uint64_t last_drain_count{0};
+    std::uint64_t max_drain_count{0};
+};
+
+// Bounded multi-producer, single-consumer ring of player commands for one match. Network
+// threads push from their handlers without taking a lock; the simulation thread drains it in
+// one batch at the start of each tick. A claimed slot's position is the command's sequence
+// number, so the tick sees commands in the order their pushes claimed slots.
+//
+// Slots are reused in place: a command's unit id vector keeps its capacity across laps of the
+// ring, so steady-state pushes don't allocate.
+class CommandQueue
+{
+public:
+    explicit CommandQueue(size_t capacity = 4096); // Rounded up to a power of two
+
+    CommandQueue(const CommandQueue &) = delete;
+    CommandQueue &operator=(const CommandQueue &) = delete;
+
+    // Any thread. fill writes the command's fields; kind, player, sequence and receive time are
+    // stamped here. Returns false, without calling fill, when the queue is full.
+    template <typename Fill>
+    bool push(PlayerCommand::Kind kind, PlayerID player_id, Fill &&fill)
+    {
+        std::uint64_t position = enqueue_position_.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;)
+        {
+            slot = &slots_[position & mask_];
+            std::uint64_t ready = slot->ready.load(std::memory_order_acquire);
+            if (ready == position)
+            {
+                if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (ready < position)
+            {
+                rejected_full_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = enqueue_position_.load(std::memory_order_relaxed);
+            }
+        }
+
+        PlayerCommand &command = slot->command;
+        command.kind = kind;
+        command.player_id = player_id;
+        command.sequence = position;
+        command.received_at = std::chrono::steady_clock::now();
+        fill(command);
+        slot->ready.store(position + 1, std::memory_order_release);
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Simulation thread only. Calls apply for every command pushed before the drain started, in
+    // sequence order; commands pushed meanwhile wait for the next tick. Returns the count.
+    template <typename Apply>
+    size_t drain(Apply &&apply)
+    {
+        std::uint64_t end = enqueue_position_.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (dequeue_position_ < end)
+        {
+            Slot &slot = slots_[dequeue_position_ & mask_];
+            // A producer that claimed this slot may not have filled it yet; it goes next tick
+            if (slot.ready.load(std::memory_order_acquire) != dequeue_position_ + 1)
+            {
+                break;
+            }
+            apply(static_cast<const PlayerCommand &>(slot.command));
+            slot.ready.store(dequeue_position_ + slots_.size(), std::memory_order_release);
+            ++dequeue_position_;
+            ++count;
+        }
+        record_drain(count);
+        return count;
+    }
+
+    size_t get_capacity() const { return slots_.size(); }
+    // Approximate while producers are pushing
+    size_t get_size() const;
+    CommandQueueStats get_stats() const;
+    // The ring itself; the unit id vectors its slots keep are not counted
+    size_t get_memory_usage() const { return slots_.capacity() * sizeof(Slot); }
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<std::uint64_t> ready{0}; // position + 1 once filled; position + capacity once free again
+        PlayerCommand command;
+    };
+
+    void record_drain(size_t count);
+
+    std::vector<Slot> slots_;
+    std::uint64_t mask_;
+    alignas(64) std::atomic<std::uint64_t> enqueue_position_{0};
+    alignas(64) std::uint64_t dequeue_position_{0};
+    std::atomic<std::uint64_t> dequeue_published_{0};
+    std::atomic<std::uint64_t> pushed_{0};
+    std::atomic<std::uint64_t> rejected_full_{0};
+    std::atomic<std::uint64_t> drains_{0};
+    std::atomic<std::uint64_t> last_drain_count_{0};
+    std::atomic<std::uint64_t> max_drain_count_{0};
+};
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+struct GameLoopStats
+{
+    std::uint64_t ticks{0};
+    std::uint64_t late_ticks{0};    // Run after their scheduled time, to catch up
+    std::uint64_t skipped_ticks{0}; // Dropped because the loop fell more than max_catch_up behind
+    std::uint64_t over_budget{0};   // Took longer than one tick period
+    std::chrono::nanoseconds total_tick_time{0};
+    std::chrono::nanoseconds max_tick_time{0};
+
+    void merge(const GameLoopStats &other);
+};
+
+// Fixed-timestep loop on an asio steady_timer. Ticks are scheduled tick_rate times a second of
+// wall time and each advances the game by the same step, so the simulation does not depend on
+// when the timer actually fires. A loop that wakes late runs the ticks it missed back to back,
+// up to max_catch_up; beyond that they are dropped and the game slows down rather than
+// spiralling further behind.
+//
+// Only one timer wait is ever outstanding, so ticks never overlap, whichever thread runs them.
+// The wait keeps the loop alive, so create it with make_shared; once stopped, it goes when the
+// last pending wait completes.
+class GameLoop : public std::enable_shared_from_this<GameLoop>
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    // Receives the game time one tick covers, in seconds
+    using TickHandler = std::function<void(float delta_time)>;
+
+    static constexpr unsigned default_tick_rate = 20;
+    static constexpr unsigned default_max_catch_up = 5;
+
+    GameLoop(boost::asio::io_context &io_context, TickHandler on_tick);
+
+    // Take effect from the next tick; safe to call from any thread
+    void set_tick_rate(unsigned ticks_per_second);
+    void set_game_speed(float speed);
+    void set_max_catch_up(unsigned ticks) { max_catch_up_ = ticks; }
+    unsigned get_tick_rate() const { return tick_rate_; }
+    float get_game_speed() const { return game_speed_; }
+
+    // phase, a fraction of a tick period, delays the first tick, so loops started together can be
+    // spread across the period instead of all waking at once
+    void start(float phase = 0.0f);
+    // Ticks already running finish; no further ones start
+    void stop();
+    bool is_running() const { return running_; }
+
+    GameLoopStats get_stats() const;
+
+private:
+    Clock::duration period() const;
+    void schedule();
+    void on_timer(const boost::system::error_code &ec);
+
+    boost::asio::strand<boost::asio::io_context::executor_type> strand_;
+    boost::asio::steady_timer timer_;
+    TickHandler on_tick_;
+    std::atomic<unsigned> tick_rate_{default_tick_rate};
+    std::atomic<float> game_speed_{1.0f};
+    std::atomic<unsigned> max_catch_up_{default_max_catch_up};
+    std::atomic<bool> running_{false};
+    Clock::time_point next_tick_;
+
+    mutable std::mutex stats_mutex_;
+    GameLoopStats stats_;
+};
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include "player_manager.hpp"
 #include "../factions/faction.hpp"
 #include "../upgrades/upgrade_manager.hpp"
+#include "../units/unit.hpp"
+#include "../units/unit_store.hpp"
 
 using PlayerID = std::uint32_t;
 
@@ -19,6 +21,17 @@ enum class VictoryState
     Draw
 };
 
+// Replicated state of one unit; what snapshots, lockstep and replays see of a GameState unit
+struct UnitState
+{
+    UnitID id;
+    PlayerID owner;
+    UnitType type;
+    int x;
+    int y;
+    int health;
+};
+
 class GameState
 {
 public:
@@ -30,6 +43,7 @@ public:
 
     void update_player_score(PlayerID player_id, int score);
     int get_player_score(PlayerID player_id) const;
+    const std::map<PlayerID, int> &get_player_scores() const { return player_scores_; }
 
     bool is_game_over() const { return is_game_over_; }
     void set_game_over(bool game_over) { is_game_over_ = game_over; }
@@ -46,13 +60,59 @@ public:
     bool is_game_started() const { return game_started_; }
     void set_game_started(bool started) { game_started_ = started; }
 
+    // Lockstep turns applied to this state
+    std::uint32_t get_turn() const { return turn_; }
+    void set_turn(std::uint32_t turn) { turn_ = turn; }
+    void advance_turn() { ++turn_; }
+
+    // Hash of the turn, units, unit id counter and scores. Every peer that applies the same turns
+    // to the same start gets the same value; fields are hashed as fixed-width integers, so it does
+    // not depend on struct layout or the platform's byte order.
+    std::uint64_t checksum() const;
+
+    // Unit management. Units live in a UnitStore, with the type's base stats; ids are handed out
+    // in order, never reused, and map to the store's handles. 0 if the type cannot be spawned or
+    // the store is full.
+    UnitID spawn_unit(PlayerID owner, UnitType type, int x, int y, int health);
+    // Inserts a unit under its own id, as received from the server; false if its type cannot be
+    // spawned. The id counter is left alone: the newest units may have died, so set it with
+    // set_next_unit_id.
+    bool restore_unit(const UnitState &unit);
+    void remove_unit(UnitID id);
+    // Not valid if there is no such unit
+    UnitRef get_unit(UnitID id);
+    bool get_unit_state(UnitID id, UnitState &unit) const;
+    size_t get_unit_count() const { return unit_handles_.size(); }
+    const std::map<UnitID, UnitStore::Handle> &get_unit_handles() const { return unit_handles_; }
+    // Calls visit with each unit as a UnitState, in id order
+    template <typename Visit>
+    void for_each_unit(Visit &&visit) const
+    {
+        for (const auto &[id, handle] : unit_handles_)
+        {
+            visit(unit_state(id, units_.index_of(handle)));
+        }
+    }
+    // Id the next spawn takes; a restored world sets it from the same source as its units
+    UnitID get_next_unit_id() const { return next_unit_id_; }
+    void set_next_unit_id(UnitID id) { next_unit_id_ = id; }
+
     // Upgrade management
     UpgradeManager &get_upgrade_manager() { return *upgrade_manager_; }
     const UpgradeManager &get_upgrade_manager() const { return *upgrade_manager_; }
 
+    // Approximate heap bytes held by units, scores and upgrades
+    size_t get_memory_usage() const;
+
 private:
+    UnitState unit_state(UnitID id, size_t index) const;
+
     VictoryState victory_state_{VictoryState::None};
     std::map<PlayerID, int> player_scores_;
+    UnitStore units_;
+    std::map<UnitID, UnitStore::Handle> unit_handles_;
+    UnitID next_unit_id_{1};
+    std::uint32_t turn_{0};
     std::int64_t elapsed_time_{0};
     bool is_game_over_{false};
     std::unique_ptr<PlayerManager> player_manager_;
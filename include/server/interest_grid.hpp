@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "../utils/types.hpp"
+#include "game_state.hpp"
+#include "map.hpp"
+
+// Part of the map a client reports looking at, in tiles
+struct CameraRect
+{
+    int x{0};
+    int y{0};
+    int width{0};
+    int height{0};
+};
+
+// Area of interest: which units a client is sent. The map is split into square cells of
+// cell_size tiles; a client sees the units in every cell within vision_range tiles of a cell
+// holding one of its own units, and in every cell its camera overlaps. Units are bucketed once per snapshot, so
+// gathering one client's units costs what that client can see, not the size of the world.
+class InterestGrid
+{
+public:
+    static constexpr int default_cell_size = 8;
+    static constexpr int default_vision_range = 8;
+
+    explicit InterestGrid(const Map &map, int cell_size = default_cell_size, int vision_range = default_vision_range);
+
+    // Buckets units by cell. They must be ordered by id and stay unchanged until the next rebuild.
+    void rebuild(const std::vector<UnitState> &units);
+
+    // Replaces visible with the ids of the units player_id can see, in id order
+    void visible_units(PlayerID player_id, std::vector<UnitID> &visible);
+
+    // Safe to call from network threads
+    void set_camera(PlayerID player_id, const CameraRect &camera);
+    bool get_camera(PlayerID player_id, CameraRect &camera);
+    void remove_client(PlayerID player_id);
+
+    // Simulation thread, like rebuild
+    size_t get_memory_usage();
+
+private:
+    // Positions past the edge fall in the edge cells
+    int column_of(int64_t x) const;
+    int row_of(int64_t y) const;
+    int column_of(int x) const; // 32-bit division, for unit positions
+    int row_of(int y) const;
+    void mark_cells(int64_t min_x, int64_t min_y, int64_t max_x, int64_t max_y);
+
+    int columns_;
+    int rows_;
+    int cell_size_;
+    int vision_range_;
+
+    const std::vector<UnitState> *units_{nullptr};
+    // Unit indices by cell: cell c holds cell_units_[cell_starts_[c]] up to cell_starts_[c + 1]
+    std::vector<uint32_t> cell_starts_;
+    std::vector<uint32_t> cell_units_;
+    std::vector<uint32_t> unit_cells_;
+    std::vector<PlayerID> cell_owners_; // Owner of the last unit bucketed into each cell
+    std::map<PlayerID, std::vector<uint32_t>> owned_cells_; // Cells holding each player's units
+
+    // A cell or unit is marked for the client being gathered when its entry equals stamp_, so
+    // marks never need clearing
+    std::vector<uint32_t> cell_marks_;
+    std::vector<uint32_t> unit_marks_;
+    uint32_t stamp_{0};
+    std::vector<uint32_t> marked_cells_;
+    std::vector<uint32_t> gathered_;
+
+    std::mutex cameras_mutex_;
+    std::map<PlayerID, CameraRect> cameras_;
+};
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "../utils/types.hpp"
+#include "../utils/name_table.hpp"
+#include "../networking/message.hpp"
+#include "command_queue.hpp"
+#include "game_state.hpp"
+#include "resource_manager.hpp"
+
+// Player commands as the Move, Build, Attack and Harvest messages clients send; lockstep turns
+// and replays carry them in this form
+namespace lockstep
+{
+    Message encode_command(const PlayerCommand &command);
+    // Sets the command's kind and fields from a standard payload, leaving its player alone; false
+    // if the message is not a well-formed command
+    bool decode_command(const MessageView &message, PlayerCommand &command);
+}
+
+// Deterministic lockstep. A lockstep room sends each turn's commands instead of the world: every
+// tick it applies the commands that arrived since the last one, in queue order, and sends them
+// to its members as one LockstepTurn. Peers load the world once from a keyframe snapshot and then
+// apply each turn with the same rules (see simulation.hpp), so they stay in step with the server
+// at a few bytes per command, however many units there are. Peers report a StateHash of their
+// world after a turn, and the server checks it against its own.
+//
+// A LockstepTurn is a payload::LockstepTurn followed by one payload::TurnCommand per command, in
+// the order the server applied them; the embedded commands use the standard encodings from
+// message_payloads.hpp, with JoinGame for a member's arrival.
+class LockstepTurnBuilder
+{
+public:
+    void begin(uint32_t turn);
+    // Commands of kinds a turn cannot carry are ignored
+    void add(const PlayerCommand &command);
+    size_t get_command_count() const { return count_; }
+    // The turn's message; the builder can begin the next one straight away
+    Message finish();
+
+private:
+    std::vector<uint8_t> data_;
+    std::vector<uint8_t> body_; // The command being added
+    uint32_t count_{0};
+};
+
+enum class LockstepCheck
+{
+    Match,
+    Diverged,        // First mismatch for this peer
+    AlreadyDiverged, // Later reports from a peer that has diverged are not checked
+    Unverifiable     // The server no longer holds, or never had, its checksum for the turn
+};
+
+struct LockstepStats
+{
+    std::uint64_t turns{0};
+    std::uint64_t hashes_checked{0};
+    std::uint64_t unverifiable{0};
+    std::uint64_t desyncs{0};
+    uint32_t first_divergent_turn{0}; // Earliest first_bad_turn of any peer; 0 if none diverged
+};
+
+// Server side: the server's checksum after each recent turn, and each peer's verdict. A peer's
+// world diverged after its last matching turn and by its first mismatching one; a peer that
+// reports every turn pins the divergence to first_bad_turn exactly.
+class LockstepVerifier
+{
+public:
+    static constexpr size_t max_history = 256;
+
+    struct Peer
+    {
+        uint32_t last_good_turn{0};
+        uint32_t first_bad_turn{0}; // 0 while in sync
+    };
+
+    // Simulation thread, once per turn, in turn order
+    void record(uint32_t turn, uint64_t checksum);
+
+    // Safe to call from network threads. expected receives the server's checksum, when it has one.
+    LockstepCheck report(PlayerID player_id, uint32_t turn, uint64_t checksum, uint64_t &expected);
+    bool get_peer(PlayerID player_id, Peer &peer) const;
+    void remove_peer(PlayerID player_id);
+
+    LockstepStats get_stats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<std::pair<uint32_t, uint64_t>> history_; // Consecutive turns, oldest first
+    std::map<PlayerID, Peer> peers_;
+    LockstepStats stats_;
+};
+
+// Client side: a copy of the world kept in step by applying turns. Units, scores and the peer's
+// own resources come from the keyframe; other players' resources only count what turns add.
+class LockstepPeer
+{
+public:
+    LockstepPeer();
+
+    // Loads the world from a keyframe ResourceUpdate; the next turn applied must be the one sent
+    // after it. resource_names is the table the keyframe was encoded with, if any.
+    bool load(PlayerID player_id, const MessageView &keyframe, const NameTable *resource_names = nullptr);
+
+    // Applies a LockstepTurn. Returns false, leaving the world unchanged, if the message is
+    // malformed or is not the turn after the last one applied.
+    bool apply(const MessageView &turn);
+
+    bool is_loaded() const { return loaded_; }
+    uint32_t get_turn() const { return game_state_->get_turn(); }
+    uint64_t get_checksum() const { return game_state_->checksum(); }
+    Message create_state_hash() const { return Message::create_state_hash(get_turn(), get_checksum()); }
+
+    GameState &get_game_state() { return *game_state_; }
+    const GameState &get_game_state() const { return *game_state_; }
+
+private:
+    std::unique_ptr<GameState> game_state_;
+    std::unique_ptr<ResourceManager> resource_manager_;
+    std::vector<PlayerCommand> commands_; // Scratch, reused across turns
+    bool loaded_{false};
+    bool started_{false}; // A turn has been applied since load
+};
\ No newline at end of file
@@ -39,6 +39,7 @@ public:
     int get_width() const { return width_; }
     int get_height() const { return height_; }
     int get_tile_size() const { return tile_size_; }
+    size_t get_memory_usage() const;
 
 private:
     int width_;
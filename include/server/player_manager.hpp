@@ -24,6 +24,7 @@ public:
     std::shared_ptr<Player> get_player(PlayerID player_id);
     void assign_to_team(PlayerID player_id, TeamNumber team);
     std::vector<PlayerID> get_players_in_team(TeamNumber team) const;
+    std::vector<PlayerID> get_teammates(PlayerID player_id) const; // Includes the player
     PlayerID generate_next_player_id() { return next_player_id_++; }
 
     friend class CastleServer;
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../networking/compact_codec.hpp"
+#include "command_queue.hpp"
+#include "game_state.hpp"
+#include "resource_manager.hpp"
+
+// Replay file, append-only, in native byte order:
+//   [u32 magic "CRPL"][u16 version][u16 map width][u16 map height][u16 tick rate]
+//   then records: [u8 kind][varint ticks since the previous record][varint body size][body]
+//     Tick      {[varint player id][command message, compact form]}   the tick's commands, in order
+//     Keyframe  [u64 checksum][ResourceUpdate keyframe]               the world after the tick
+//     End       [u64 checksum]                                        the world when recording stopped
+// The first record is a keyframe. Ticks without commands have no record. Commands use the
+// compact message encoding for the header's map size, falling back to the standard form.
+// Keyframes hold what GameState::checksum covers: units, the unit id counter (carried by the
+// snapshot keyframe) and scores. The world between ticks depends on nothing else, so replaying
+// the commands from any keyframe rebuilds it exactly.
+struct ReplayHeader
+{
+    uint16_t map_width{0};
+    uint16_t map_height{0};
+    uint16_t tick_rate{0};
+};
+
+namespace replay_records
+{
+    constexpr uint8_t tick = 0;
+    constexpr uint8_t keyframe = 1;
+    constexpr uint8_t end = 2;
+}
+
+struct ReplayRecorderStats
+{
+    std::uint64_t ticks{0}; // Ticks with commands
+    std::uint64_t commands{0};
+    std::uint64_t keyframes{0};
+    std::uint64_t bytes{0};
+};
+
+// Writes a match's command stream as it is applied. Simulation thread only.
+class ReplayRecorder
+{
+public:
+    static constexpr uint32_t default_keyframe_interval = 600; // 30 s at 20 ticks a second
+
+    explicit ReplayRecorder(uint32_t keyframe_interval = default_keyframe_interval);
+    ~ReplayRecorder();
+
+    // Creates the file and records a keyframe of the world as it stands
+    bool open(const std::string &path, const ReplayHeader &header, const GameState &game_state,
+              const ResourceManager &resource_manager);
+    bool is_open() const { return file_.is_open(); }
+
+    // Each command as the tick applies it, then end_tick once the world's turn has advanced
+    void add(const PlayerCommand &command);
+    void end_tick(const GameState &game_state, const ResourceManager &resource_manager);
+    // Records the End checksum and closes the file
+    void close(const GameState &game_state);
+
+    const ReplayRecorderStats &get_stats() const { return stats_; }
+
+private:
+    void write_keyframe(const GameState &game_state, const ResourceManager &resource_manager);
+    void write_record(uint8_t kind, uint32_t tick, const std::vector<uint8_t> &body);
+
+    std::ofstream file_;
+    CompactLayout layout_;
+    uint32_t keyframe_interval_;
+    uint32_t last_tick_{0}; // Of the last record written
+    std::vector<uint8_t> tick_body_;
+    std::vector<uint8_t> record_;
+    ReplayRecorderStats stats_;
+};
+
+struct ReplayStats
+{
+    std::uint64_t records{0}; // Tick records applied
+    std::uint64_t commands{0};
+    std::uint64_t keyframes_loaded{0};
+    std::uint64_t checksums_checked{0}; // Keyframes and the End record played through
+    std::uint64_t mismatches{0};
+    uint32_t first_mismatch_tick{0};
+};
+
+// Re-simulates a replay headlessly, as fast as the commands apply. The file is memory-mapped
+// and its keyframes indexed when opened; seeking loads the nearest keyframe at or before the
+// target and plays forward from there, so it costs the distance to that keyframe, not to the
+// start. A record cut short, by a crash mid-write, ends the replay.
+//
+// Playing through a keyframe or the End record checks the re-simulated world against its
+// checksum. A mismatch is counted and playback carries on with the re-simulated world, so
+// first_mismatch_tick bounds where the simulation stopped reproducing the match.
+class ReplayPlayer
+{
+public:
+    ReplayPlayer();
+    ~ReplayPlayer();
+
+    ReplayPlayer(const ReplayPlayer &) = delete;
+    ReplayPlayer &operator=(const ReplayPlayer &) = delete;
+
+    // The world starts at the first keyframe
+    bool open(const std::string &path);
+    void close();
+
+    const ReplayHeader &get_header() const { return header_; }
+    uint32_t get_first_tick() const { return keyframes_.empty() ? 0 : keyframes_.front().tick; }
+    uint32_t get_end_tick() const { return end_tick_; }
+    bool is_complete() const { return complete_; } // Has its End record
+    size_t get_keyframe_count() const { return keyframes_.size(); }
+    size_t get_file_size() const { return size_; }
+
+    bool seek(uint32_t tick);
+    // Plays forward to tick, or to the end; false if a record is malformed
+    bool play_to(uint32_t tick);
+
+    uint32_t get_tick() const { return game_state_->get_turn(); }
+    const GameState &get_game_state() const { return *game_state_; }
+    const ReplayStats &get_stats() const { return stats_; }
+
+private:
+    struct Record
+    {
+        uint8_t kind;
+        uint32_t tick;
+        const uint8_t *body;
+        size_t size;
+        size_t next; // Offset of the following record
+    };
+
+    struct Keyframe
+    {
+        uint32_t tick;
+        size_t offset;
+    };
+
+    bool read_record(size_t offset, uint32_t previous_tick, Record &record) const;
+    bool load_keyframe(const Keyframe &keyframe);
+    bool apply_commands(const Record &record);
+    void check(const Record &record);
+
+    int fd_{-1};
+    const uint8_t *data_{nullptr};
+    size_t size_{0};
+
+    ReplayHeader header_;
+    CompactLayout layout_;
+    std::vector<Keyframe> keyframes_;
+    size_t end_offset_{0}; // Just past the last whole record
+    uint32_t end_tick_{0};
+    bool complete_{false};
+
+    size_t cursor_{0};        // Next record to play
+    uint32_t cursor_tick_{0}; // Tick of the record before it
+
+    std::unique_ptr<GameState> game_state_;
+    std::unique_ptr<ResourceManager> resource_manager_;
+    PlayerCommand command_;
+    std::vector<uint8_t> expanded_;
+    ReplayStats stats_;
+};
\ No newline at end of file
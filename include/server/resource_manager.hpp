@@ -5,6 +5,7 @@
 #include <memory>
 #include <vector>
 #include "../utils/types.hpp"
+#include "../utils/name_table.hpp"
 #include "game_state.hpp"
 
 struct Resource
@@ -26,14 +27,18 @@ public:
     bool spend_resource(PlayerID player_id, const std::string &resource_name, int amount);
     int get_resource_amount(PlayerID player_id, const std::string &resource_name) const;
     std::vector<Resource> get_available_resources() const;
+    const NameTable &get_resource_names() const { return resource_names_; }
+    const std::map<PlayerID, std::map<std::string, int>> &get_player_resources() const { return player_resources_; }
 
     void add_resource_node(int x, int y, const Resource &resource);
     void remove_resource_node(int x, int y, int resource_id);
     void update(float delta_time); // For resource regeneration
+    size_t get_memory_usage() const;
 
 private:
     std::map<PlayerID, std::map<std::string, int>> player_resources_;
     std::vector<Resource> available_resources_;
+    NameTable resource_names_; // Available resources in declaration order
     struct ResourceNode
     {
         int x, y;
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../utils/types.hpp"
+#include "game_state.hpp"
+#include "player_manager.hpp"
+#include "map.hpp"
+#include "resource_manager.hpp"
+#include "chat_handler.hpp"
+#include "timer.hpp"
+#include "game_loop.hpp"
+#include "snapshot.hpp"
+#include "interest_grid.hpp"
+#include "command_queue.hpp"
+#include "lockstep.hpp"
+#include "replay.hpp"
+#include "../networking/client_connection.hpp"
+#include "../networking/message_dispatcher.hpp"
+
+using RoomID = std::uint32_t;
+
+// Shape of one match; fixed when its room is created
+struct RoomSettings
+{
+    size_t max_players{8};
+    int map_width{100};
+    int map_height{100};
+    int tile_size{32};
+    unsigned tick_rate{GameLoop::default_tick_rate};
+    float game_speed{1.0f};
+    // Commands each place can have waiting between ticks; a slot costs about 128 bytes, so the
+    // queue is sized by the room rather than fixed
+    size_t commands_per_player{64};
+    // Most bytes one client's snapshot may take; the least urgent unit updates wait when it
+    // would be exceeded. Zero means no cap.
+    size_t snapshot_budget{16 * 1024};
+    bool interest{true}; // Snapshots only carry units near a client's own units or camera
+    // Members get one keyframe, then each tick's commands as a LockstepTurn instead of
+    // snapshots; see lockstep.hpp. Interest and the snapshot budget do not apply.
+    bool lockstep{false};
+    // Each match is recorded to a replay file in this directory; empty records nothing
+    std::string replay_directory;
+};
+
+// Approximate heap bytes a room holds, as of its last tick
+struct RoomMemory
+{
+    size_t world{0};     // Units, scores, upgrades, map tiles and resources
+    size_t snapshots{0}; // Snapshot history, client views and the interest grid
+    size_t commands{0};
+    size_t timers{0};
+    size_t chat{0};
+
+    size_t total() const { return world + snapshots + commands + timers + chat; }
+};
+
+struct RoomInfo
+{
+    RoomID id{0};
+    size_t members{0};
+    RoomMemory memory;
+    GameLoopStats ticks;
+    LockstepStats lockstep;
+};
+
+// One match: its own world, timers, command queue and snapshot stream, ticked by its own
+// GameLoop. Members' messages come straight to the room through its dispatcher, which every
+// member connection holds and which keeps the room alive; rooms share nothing with each other.
+class Room : public std::enable_shared_from_this<Room>
+{
+public:
+    Room(RoomID id, boost::asio::io_context &io_context, const RoomSettings &settings);
+    ~Room();
+
+    RoomID get_id() const { return id_; }
+    const RoomSettings &get_settings() const { return settings_; }
+
+    // The room must be owned by a shared_ptr; ticks hold it only while they run
+    void start(float phase = 0.0f);
+    void stop();
+
+    // The connection must not have started reading: it is given the room's dispatcher and the
+    // compact layout for its map
+    bool add_member(const std::shared_ptr<ClientConnection> &connection);
+    bool remove_member(PlayerID player_id);
+    std::vector<PlayerID> get_member_ids() const;
+    size_t get_member_count() const;
+    bool is_full() const { return get_member_count() >= settings_.max_players; }
+    // Disconnects every member
+    void close();
+
+    RoomInfo get_info() const;
+
+    void start_game();
+    // Broadcasts serialize the message once and share the payload between the room's members
+    void broadcast(const Message &message);
+    void broadcast(const Message &message, const std::vector<PlayerID> &recipients);
+
+    // Message handlers, registered in the room's dispatch table by register_handlers
+    void handle_chat_message(ClientConnection &connection, const payload::Chat &chat);
+
+    // Player commands are queued on the network thread that read them and applied at the start
+    // of each tick
+    void handle_move_command(ClientConnection &connection, const payload::Move &move);
+    void handle_build_command(ClientConnection &connection, const payload::Build &build);
+    void handle_attack_command(ClientConnection &connection, const payload::Attack &attack);
+    void handle_harvest_command(ClientConnection &connection, const payload::Harvest &harvest);
+    CommandQueueStats get_command_queue_stats() const { return command_queue_->get_stats(); }
+
+    // One simulation step, run by the game loop: queued commands as the next turn, timers,
+    // resource regrowth, then snapshots, or the turn in a lockstep room
+    void tick(float delta_time);
+    // Applies the queued commands, recording them to the turn and the replay; returns how many
+    size_t run_turn();
+
+    // Sends every member a delta of the world since its last acknowledged snapshot
+    void send_snapshots();
+    void handle_snapshot_ack(ClientConnection &connection, const payload::SnapshotAck &ack);
+    void handle_camera_update(ClientConnection &connection, const payload::CameraUpdate &camera);
+
+    // Lockstep rooms: checks a member's checksum against the server's and tells it once if it
+    // has diverged
+    void handle_state_hash(ClientConnection &connection, const payload::StateHash &hash);
+
+    // Upgrade system handlers
+    void handle_upgrade_request(ClientConnection &connection, const payload::UpgradeRequest &request);
+    void handle_interned_upgrade_request(ClientConnection &connection, const payload::InternedUpgradeRequest &request);
+    void handle_technology_request(ClientConnection &connection, const payload::TechnologyRequest &request);
+    void handle_interned_technology_request(ClientConnection &connection,
+                                            const payload::InternedTechnologyRequest &request);
+    void handle_upgrade_list_request(ClientConnection &connection, const payload::UpgradeListRequest &request);
+
+private:
+    void register_handlers();
+    void send_turn();
+    void measure_memory();
+
+    RoomID id_;
+    boost::asio::io_context &io_context_;
+    RoomSettings settings_;
+    std::unique_ptr<GameState> game_state_;
+    std::unique_ptr<PlayerManager> player_manager_;
+    std::unique_ptr<Map> map_;
+    std::unique_ptr<ResourceManager> resource_manager_;
+    std::unique_ptr<ChatHandler> chat_handler_;
+    std::unique_ptr<Timer> timer_;
+    std::unique_ptr<SnapshotEncoder> snapshot_encoder_;
+    std::unique_ptr<InterestGrid> interest_grid_;
+    std::unique_ptr<CommandQueue> command_queue_;
+    std::unique_ptr<LockstepTurnBuilder> turn_builder_;
+    std::unique_ptr<LockstepVerifier> lockstep_verifier_;
+    std::unique_ptr<ReplayRecorder> replay_recorder_;
+    std::shared_ptr<GameLoop> game_loop_;
+    MessageDispatcher dispatcher_;
+
+    // Chat and upgrade requests are served on network threads, several members at a time
+    std::mutex requests_mutex_;
+
+    mutable std::mutex members_mutex_;
+    std::vector<std::shared_ptr<ClientConnection>> members_;
+    std::vector<PlayerID> joining_; // Lockstep members still to be sent their keyframe
+    // Lockstep members whose Join the last turn applied; their keyframe goes out with that turn.
+    // Only touched on the tick thread.
+    std::vector<PlayerID> joined_;
+
+    mutable std::mutex memory_mutex_;
+    RoomMemory memory_;
+};
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "room.hpp"
+
+// Creates, fills and destroys rooms. Every room ticks on a strand of one io_context, so a fixed
+// pool of threads running it shares the ticks of however many rooms there are, and one room never
+// ticks on two threads at once. Successive rooms start a golden-ratio fraction of a tick period
+// apart, which keeps their ticks spread over the period whatever the room count.
+//
+// Safe to call from any thread.
+class RoomManager
+{
+public:
+    static constexpr size_t default_max_rooms = 1024;
+
+    explicit RoomManager(boost::asio::io_context &io_context, size_t max_rooms = default_max_rooms);
+    ~RoomManager();
+
+    // Rooms created afterwards are made with these
+    void set_settings(const RoomSettings &settings);
+    RoomSettings get_settings() const;
+
+    // Puts a connection that has not started reading into the oldest room with a free place,
+    // creating one if every room is full. Returns nullptr when max_rooms rooms are all full.
+    std::shared_ptr<Room> assign(const std::shared_ptr<ClientConnection> &connection);
+    // An empty, running room; nullptr at max_rooms
+    std::shared_ptr<Room> create_room();
+    // Stops the room and disconnects its members
+    bool destroy_room(RoomID room_id);
+    // Takes the player out of their room; a room goes with its last member
+    void remove_player(PlayerID player_id);
+    // Destroys every room
+    void clear();
+
+    std::shared_ptr<Room> find_room(RoomID room_id) const;
+    std::shared_ptr<Room> find_player_room(PlayerID player_id) const;
+    size_t get_room_count() const;
+    std::vector<RoomInfo> get_room_info() const;
+    // Summed over every room, destroyed ones included
+    GameLoopStats get_tick_stats() const;
+
+private:
+    std::shared_ptr<Room> create_room_locked();
+    void retire(const std::shared_ptr<Room> &room);
+
+    boost::asio::io_context &io_context_;
+    size_t max_rooms_;
+
+    mutable std::mutex mutex_;
+    RoomSettings settings_;
+    RoomID next_room_id_{1};
+    float next_phase_{0.0f};
+    std::map<RoomID, std::shared_ptr<Room>> rooms_;
+    std::unordered_map<PlayerID, RoomID> player_rooms_;
+    GameLoopStats retired_stats_;
+};
\ No newline at end of file
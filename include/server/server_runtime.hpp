@@ -0,0 +1,42 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <memory>
+#include <vector>
+#include "castle_server.hpp"
+
+enum class NetworkMode
+{
+    Shared,  // One io_context run by every thread, connections on per-connection strands
+    Sharded  // One io_context and SO_REUSEPORT acceptor per thread
+};
+
+// Owns the io_contexts and threads the server runs on: thread_count network threads, and a
+// separate pool of room_thread_count threads that every room's ticks share
+class ServerRuntime
+{
+public:
+    ServerRuntime(NetworkMode mode, unsigned short port, size_t thread_count, size_t room_thread_count = 1);
+    ~ServerRuntime();
+
+    CastleServer &get_server() { return *server_; }
+    NetworkMode get_mode() const { return mode_; }
+    // Reactor the build uses for sockets: "io_uring" with the io_uring build option, else "epoll"
+    static const char *get_backend_name();
+    size_t get_thread_count() const { return thread_count_; }
+    size_t get_room_thread_count() const { return room_thread_count_; }
+
+    // Blocks until stop(); the calling thread serves as one of the workers
+    void run();
+    void stop();
+
+private:
+    NetworkMode mode_;
+    size_t thread_count_;
+    size_t room_thread_count_;
+    // Declared first so it outlives the network contexts, whose connections can hold rooms
+    boost::asio::io_context room_context_;
+    std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> room_work_;
+    std::vector<std::unique_ptr<boost::asio::io_context>> io_contexts_;
+    std::unique_ptr<CastleServer> server_;
+};
\ No newline at end of file
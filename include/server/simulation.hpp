@@ -0,0 +1,22 @@
+#pragma once
+
+#include "command_queue.hpp"
+#include "game_state.hpp"
+#include "resource_manager.hpp"
+
+// The game rules a player command is applied with. Rooms apply commands with these as they
+// drain them, and lockstep peers replay each turn with the same code, so both reach the same
+// state from the same commands.
+namespace simulation
+{
+    // Fixed amounts until unit stats are replicated into the world state
+    constexpr int attack_damage = 10;
+    constexpr int harvest_amount = 10;
+
+    // What a Join command spawns for the new player, in rows of three from its position
+    constexpr UnitType starting_units[] = {UnitType::Peasant, UnitType::Peasant, UnitType::Peasant,
+                                           UnitType::Soldier, UnitType::Soldier, UnitType::Archer};
+
+    // Players may only order their own units; anything else is ignored
+    void apply_command(GameState &game_state, ResourceManager &resource_manager, const PlayerCommand &command);
+}
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../utils/types.hpp"
+#include "../networking/message.hpp"
+#include "game_state.hpp"
+#include "resource_manager.hpp"
+#include "interest_grid.hpp"
+
+// World state as clients see it at one tick
+struct WorldSnapshot
+{
+    uint32_t sequence{0};
+    std::vector<UnitState> units; // Ordered by id
+    UnitID next_unit_id{0};       // Only keyframes carry it; 0 after a delta
+    std::map<PlayerID, int> scores;
+    std::map<PlayerID, std::map<std::string, int>> resources; // Each client only receives its own
+};
+
+struct SnapshotStats
+{
+    std::uint64_t keyframes{0};
+    std::uint64_t deltas{0};
+    std::uint64_t bytes{0};
+    // Units sent whole because they came into a client's area of interest, and units sent as
+    // removed because they left it; spawns and deaths are not counted
+    std::uint64_t interest_enters{0};
+    std::uint64_t interest_leaves{0};
+    // Unit updates held back for a later snapshot because the client's byte budget ran out
+    std::uint64_t units_deferred{0};
+};
+
+// ResourceUpdate payload:
+//   [u32 sequence][u32 baseline sequence, 0 for a keyframe][u32 next unit id, keyframes only]
+//   [u32 count]{[u32 unit id][u8 fields][owner u32, type u8 | x i32, y i32 | health i32]}
+//   [u32 count]{[u32 removed unit id]}
+//   [u16 count]{[u32 player id][i32 score]}
+//   [u16 count]{[string resource name | u16 NameID][i32 amount]}
+// Only fields and entries that differ from the baseline are present. Resources go out as
+// NameIDs to clients that negotiated capabilities::interned_names.
+namespace snapshot_fields
+{
+    constexpr uint8_t spawn = 1 << 0;
+    constexpr uint8_t position = 1 << 1;
+    constexpr uint8_t health = 1 << 2;
+    constexpr uint8_t all = spawn | position | health;
+}
+
+// Builds per-client ResourceUpdate messages as deltas against the last snapshot each
+// client acknowledged. The world history is shared by all clients; a client whose
+// acknowledged snapshot has dropped out of it (or who never acknowledged one) gets a keyframe.
+//
+// With an InterestGrid set, each client is only sent the units it can see, and the delta is taken
+// against what it was sent at the baseline: a unit entering its view arrives whole, as if it had
+// spawned, and one leaving it is listed as removed. SnapshotDecoder needs no changes for this.
+//
+// With a byte budget, unit updates that do not fit are held back. Each held-back unit builds up
+// priority every snapshot it misses, weighted by ownership, damage taken and distance from the
+// client's camera, and the highest priorities are sent first. A held-back unit stays as the
+// client last saw it, so the next delta still carries its change.
+class SnapshotEncoder
+{
+public:
+    static constexpr size_t max_history = 32;
+
+    // Records the current world state; call once per tick before encoding for clients
+    const WorldSnapshot &capture(const GameState &game_state, const ResourceManager &resource_manager);
+
+    // Filters units per client from the next capture on; nullptr sends every client every unit.
+    // The grid must outlive the encoder or be unset first.
+    void set_interest(InterestGrid *interest);
+
+    // Encodes the latest captured snapshot for one client; with resource_names set, resources
+    // are sent by id and any name missing from the table is left out. A nonzero byte_budget caps
+    // the payload, though removals, scores and resources are always sent whole.
+    Message encode(PlayerID player_id, const NameTable *resource_names = nullptr, size_t byte_budget = 0);
+
+    // Safe to call from network threads
+    void acknowledge(PlayerID player_id, uint32_t sequence);
+    void remove_client(PlayerID player_id);
+
+    const SnapshotStats &get_stats() const { return stats_; }
+    // Approximate heap bytes held by the history, shared encodings and client views. Call from
+    // the simulation thread, like capture.
+    size_t get_memory_usage();
+
+private:
+    // Ids of the units a client holds after one snapshot, in id order, and the state it holds
+    // for any whose update was held back
+    struct SentView
+    {
+        uint32_t sequence;
+        std::vector<UnitID> visible;
+        std::vector<UnitState> stale;
+    };
+
+    struct ClientView
+    {
+        std::deque<SentView> sent;
+        std::vector<std::pair<UnitID, float>> priorities; // Units held back last time, in id order
+    };
+
+    // A unit update: indices into visible_units_ and baseline_units_
+    static constexpr uint32_t no_baseline = 0xffffffff;
+    struct Change
+    {
+        uint32_t index;
+        uint32_t baseline;
+        uint8_t fields;
+        size_t size{0};
+        float priority{0};
+        bool send{false};
+    };
+
+    const WorldSnapshot *find(uint32_t sequence) const;
+    const std::vector<uint8_t> &world_section(const WorldSnapshot *baseline);
+    void write_client_units(std::vector<uint8_t> &data, PlayerID player_id, ClientView &view,
+                            const WorldSnapshot *baseline, const SentView *baseline_view, size_t unit_budget);
+    void prioritise(PlayerID player_id, const ClientView &view);
+
+    std::deque<WorldSnapshot> history_;
+    uint32_t next_sequence_{1};
+    // Snapshots before this were filtered differently and are never used as a baseline
+    uint32_t first_baseline_{1};
+
+    // Unit and score sections of the latest snapshot, keyed by baseline sequence; clients
+    // acknowledging the same snapshot share one encoding
+    std::map<uint32_t, std::vector<uint8_t>> world_sections_;
+
+    InterestGrid *interest_{nullptr};
+    // Clients on the per-client path. Only touched by capture and encode; clients removed from
+    // network threads are queued in departed_ and dropped at the next capture.
+    std::map<PlayerID, ClientView> views_;
+
+    // Scratch space reused across encodes
+    std::vector<UnitID> visible_;
+    std::vector<UnitState> visible_units_;
+    std::vector<UnitState> baseline_units_;
+    std::vector<Change> changes_;
+    std::vector<uint32_t> by_priority_;
+    std::vector<UnitID> removed_;
+    std::vector<UnitID> held_back_;
+    std::vector<uint8_t> tail_;
+
+    std::mutex acks_mutex_;
+    std::map<PlayerID, uint32_t> acked_;
+    std::vector<PlayerID> departed_;
+    SnapshotStats stats_;
+};
+
+// Client side: rebuilds snapshots from ResourceUpdate messages
+class SnapshotDecoder
+{
+public:
+    // resource_names must match what the server encodes with, i.e. the NameDictionary it sent
+    explicit SnapshotDecoder(PlayerID player_id, const NameTable *resource_names = nullptr)
+        : player_id_(player_id), resource_names_(resource_names) {}
+
+    // Returns false if the message is malformed or its baseline is no longer held
+    bool apply(const MessageView &message);
+
+    // Latest decoded snapshot, or nullptr before the first one; acknowledge its sequence
+    const WorldSnapshot *latest() const { return received_.empty() ? nullptr : &received_.back(); }
+
+private:
+    PlayerID player_id_;
+    const NameTable *resource_names_;
+    std::deque<WorldSnapshot> received_;
+};
\ No newline at end of file
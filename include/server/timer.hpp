@@ -1,13 +1,18 @@
 #pragma once
 
+#include <array>
 #include <chrono>
-#include <functional>
-#include <map>
-#include <memory>
+#include <cstdint>
+#include <vector>
+#include "../utils/small_callback.hpp"
 
-using TimerID = std::uint32_t;
-using TimerCallback = std::function<void()>;
+using TimerID = std::uint64_t; // [u32 generation][u32 slot]; never 0
+using TimerCallback = SmallCallback<48>;
 
+// Timeouts and intervals on a hierarchical timing wheel: four levels of 256 slots, the first at
+// millisecond resolution, so timers up to 49 days out are placed and cancelled in O(1). Each
+// update only visits the slots it passes and the timers due in them; a far-off timer moves down
+// a level as its time approaches, at most three times over its life.
 class Timer
 {
 public:
@@ -16,26 +21,66 @@ public:
 
     TimerID set_timeout(float seconds, TimerCallback callback);
     TimerID set_interval(float seconds, TimerCallback callback);
+    // Safe from a callback, including a timer's own
     void clear_timer(TimerID timer_id);
     void update();
+    // Advances by delta_time seconds of game time rather than wall time, for a fixed-timestep
+    // loop; once used, timers are measured in game time
+    void update(float delta_time);
     void pause();
     void resume();
     float get_elapsed_time() const;
+    size_t get_timer_count() const { return active_count_; }
+    size_t get_memory_usage() const;
 
 private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int level_bits = 8;
+    static constexpr uint32_t slots_per_level = 1u << level_bits;
+    static constexpr uint32_t level_count = 4;
+    static constexpr uint32_t head_count = level_count * slots_per_level;
+    static constexpr uint32_t firing_head = head_count; // Timers taken off a slot to fire
+    static constexpr uint32_t first_timer_link = head_count + 1;
+
     struct TimerData
     {
-        std::chrono::steady_clock::time_point next_trigger;
-        float interval;
         TimerCallback callback;
-        bool is_repeating;
+        Clock::time_point next_trigger;
+        Clock::duration interval;
+        uint64_t due_tick{0};
+        uint32_t generation{1};
+        bool is_repeating{false};
+        bool active{false};
+    };
+
+    // Slot lists are circular and doubly linked through links_: the slot heads, the firing
+    // head, then one entry per timer
+    struct Link
+    {
+        uint32_t prev;
+        uint32_t next;
     };
 
-    std::map<TimerID, TimerData> timers_;
-    TimerID next_timer_id_{1};
+    std::vector<TimerData> timers_;
+    std::vector<Link> links_;
+    std::vector<uint32_t> free_timers_;
+    size_t active_count_{0};
+
+    Clock::time_point origin_; // Tick 0
+    uint64_t current_tick_{0}; // Next tick to run
     bool is_paused_{false};
-    std::chrono::steady_clock::time_point last_update_;
+    Clock::time_point last_update_;
     float elapsed_time_{0.0f};
+    bool game_time_{false};
 
-    TimerID generate_timer_id();
+    TimerID add_timer(float seconds, TimerCallback callback, bool is_repeating);
+    Clock::time_point now() const;
+    void advance_to(Clock::time_point now);
+    void run_tick();
+    void cascade(uint32_t level, uint32_t slot);
+    void place(uint32_t index);
+    void link(uint32_t head, uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
 };
\ No newline at end of file
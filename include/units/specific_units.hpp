@@ -9,8 +9,10 @@ class UnitStats;
 class Peasant : public Unit
 {
 public:
+    static constexpr bool harvests = true;
+
     explicit Peasant(PlayerID owner_id);
-    bool can_harvest() const override { return true; }
+    bool can_harvest() const override { return harvests; }
     static UnitStats get_base_stats();
 };
 
@@ -38,8 +40,11 @@ public:
 class Healer : public Unit
 {
 public:
+    static constexpr bool attacks = false;
+    static constexpr int heal_amount = 20;
+
     explicit Healer(PlayerID owner_id);
-    bool can_attack() const override { return false; }
+    bool can_attack() const override { return attacks; }
     void heal_target(Unit *target);
     static UnitStats get_base_stats();
 };
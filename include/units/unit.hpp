@@ -38,14 +38,20 @@ protected:
     int current_health;
 
 public:
+    // What each class can do; a subclass that differs hides these with its own values, which
+    // UnitStore's type table also reads
+    static constexpr bool attacks = true;
+    static constexpr bool harvests = false;
+    static constexpr int heal_amount = 0;
+
     Unit(UnitType type, PlayerID owner_id, const UnitStats &initial_stats);
     virtual ~Unit() = default;
 
     virtual void move(int dx, int dy);
     virtual void attack(Unit *target);
     virtual void take_damage(int damage);
-    virtual bool can_attack() const { return true; }
-    virtual bool can_harvest() const { return false; }
+    virtual bool can_attack() const { return attacks; }
+    virtual bool can_harvest() const { return harvests; }
 
     const UnitStats &get_stats() const { return stats; }
     void modify_stats(const UnitStats &new_stats)
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "unit.hpp"
+#include "unit_stats.hpp"
+#include "utils/slot_allocator.hpp"
+
+// Per-type behaviour, in place of virtual overrides: one entry per UnitType
+struct UnitTypeInfo
+{
+    UnitStats base_stats{0, 0, 0, 0, 0, 0};
+    bool trainable{false}; // Has a unit class; the others cannot be spawned yet
+    bool can_attack{true};
+    bool can_harvest{false};
+    int heal_amount{0};
+};
+
+class UnitRef;
+
+// Units in dense parallel arrays, one entry per live unit in each: type, owner, position,
+// destination, health and the combat stats. A pass over one field reads only that field's
+// array, and nothing is allocated per unit. Units are addressed by SlotAllocator handles with a
+// 20-bit slot, [u12 generation][u20 slot], so a store holds about a million units; removing a
+// unit moves the last one into its place, so the arrays stay dense and their order is not
+// stable. Costs are per type, from type_info.
+//
+// Not synchronised, and units must not be spawned or removed during a pass over the arrays.
+class UnitStore
+{
+public:
+    static constexpr unsigned slot_bits = 20;
+    using Slots = SlotAllocator<slot_bits>;
+    using Handle = Slots::Handle;
+    static constexpr Handle invalid_handle = Slots::invalid_handle;
+    static constexpr size_t max_size = Slots::max_size;
+    static constexpr size_t no_index = Slots::no_index;
+
+    static const UnitTypeInfo &type_info(UnitType type);
+
+    // Spawns with the type's base stats, or the given ones; invalid_handle if the type cannot be
+    // spawned or the store is full. The destination starts at the unit's position.
+    Handle spawn(UnitType type, PlayerID owner, int x, int y);
+    Handle spawn(UnitType type, PlayerID owner, int x, int y, const UnitStats &stats);
+    // False if the handle is stale or was never issued
+    bool remove(Handle handle);
+    void clear();
+
+    bool contains(Handle handle) const { return index_of(handle) != no_index; }
+    // The unit's position in the arrays, valid until the next spawn or remove; no_index if stale
+    size_t index_of(Handle handle) const { return slots_.index_of(handle); }
+    Handle handle_at(size_t index) const { return slots_.handle_at(index); }
+    size_t size() const { return type_.size(); }
+    bool empty() const { return type_.empty(); }
+
+    // One step of every unit towards its destination, by up to its speed on each axis
+    void update();
+    void set_destination(Handle handle, int x, int y);
+
+    // As Unit::take_damage: armor reduces damage to no less than 1, and negative damage heals
+    // up to max health
+    void take_damage(Handle handle, int damage);
+    // False if either handle is stale or the attacker's type cannot attack
+    bool attack(Handle attacker, Handle target);
+    // Heals by the healer type's heal_amount; false if it has none or the target is unhurt
+    bool heal(Handle healer, Handle target);
+    // Removes every unit at 0 health; returns how many
+    size_t remove_dead();
+
+    UnitRef get(Handle handle);
+
+    // The arrays, indexed alike, for passes over every unit
+    const std::vector<UnitType> &get_types() const { return type_; }
+    const std::vector<PlayerID> &get_owners() const { return owner_; }
+    const std::vector<int> &get_x() const { return x_; }
+    const std::vector<int> &get_y() const { return y_; }
+    const std::vector<int> &get_health() const { return health_; }
+    const std::vector<int> &get_max_health() const { return max_health_; }
+    const std::vector<int> &get_attack() const { return attack_; }
+    const std::vector<int> &get_armor() const { return armor_; }
+    const std::vector<int> &get_speed() const { return speed_; }
+
+    size_t get_memory_usage() const;
+
+private:
+    friend class UnitRef;
+
+    void set_stats(size_t index, const UnitStats &stats);
+    void apply_damage(size_t index, int damage);
+
+    Slots slots_;
+    std::vector<UnitType> type_;
+    std::vector<PlayerID> owner_;
+    std::vector<int> x_;
+    std::vector<int> y_;
+    std::vector<int> destination_x_;
+    std::vector<int> destination_y_;
+    std::vector<int> health_;
+    std::vector<int> max_health_;
+    std::vector<int> attack_;
+    std::vector<int> armor_;
+    std::vector<int> speed_;
+};
+
+// The Unit API over a unit in a UnitStore, for code off the hot path. A stale handle reads as a
+// dead unit with no stats, and changes to it are ignored.
+class UnitRef
+{
+public:
+    UnitRef(UnitStore &store, UnitStore::Handle handle) : store_(&store), handle_(handle) {}
+
+    UnitStore::Handle get_handle() const { return handle_; }
+    bool is_valid() const { return store_->contains(handle_); }
+
+    void move(int dx, int dy);
+    void attack(UnitRef target) { store_->attack(handle_, target.handle_); }
+    void take_damage(int damage) { store_->take_damage(handle_, damage); }
+    void heal_target(UnitRef target) { store_->heal(handle_, target.handle_); }
+    bool can_attack() const { return is_valid() && UnitStore::type_info(get_unit_type()).can_attack; }
+    bool can_harvest() const { return is_valid() && UnitStore::type_info(get_unit_type()).can_harvest; }
+
+    UnitStats get_stats() const;
+    // Costs stay the type's
+    void modify_stats(const UnitStats &new_stats);
+
+    PlayerID get_owner_id() const { return read(store_->owner_, PlayerID{0}); }
+    UnitType get_unit_type() const { return read(store_->type_, UnitType::Peasant); }
+    int get_health() const { return read(store_->health_, 0); }
+    // Not clamped to max health, for state restored as it was
+    void set_health(int health);
+    int get_max_health() const { return read(store_->max_health_, 0); }
+    int get_attack() const { return read(store_->attack_, 0); }
+    int get_armor() const { return read(store_->armor_, 0); }
+    int get_speed() const { return read(store_->speed_, 0); }
+    void set_position(int new_x, int new_y);
+    void get_position(int &out_x, int &out_y) const;
+
+private:
+    template <typename T>
+    T read(const std::vector<T> &values, T fallback) const
+    {
+        size_t index = store_->index_of(handle_);
+        return index != UnitStore::no_index ? values[index] : fallback;
+    }
+
+    UnitStore *store_;
+    UnitStore::Handle handle_;
+};
\ No newline at end of file
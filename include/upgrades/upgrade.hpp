@@ -44,6 +44,9 @@ public:
     float get_total_modifier(const std::string &attribute) const;
     float get_level_scaling() const { return level_scaling_; }
 
+    // Approximate heap bytes, the object itself included
+    size_t get_memory_usage() const;
+
 protected:
     void set_level_scaling(float scaling) { level_scaling_ = scaling; }
 
@@ -5,14 +5,15 @@
 #include <string>
 #include <vector>
 #include "../utils/types.hpp"
+#include "../utils/name_table.hpp"
 #include "upgrade.hpp"
 #include "specific_upgrades.hpp"
 #include "../server/player.hpp"
 
 struct PlayerUpgrades
 {
-    std::map<std::string, std::unique_ptr<Upgrade>> upgrades;
-    std::vector<std::string> completed_technologies;
+    std::vector<std::unique_ptr<Upgrade>> upgrades; // Indexed by upgrade id
+    std::vector<bool> completed_technologies;       // Indexed by technology id
 };
 
 class UpgradeManager
@@ -21,23 +22,41 @@ public:
     UpgradeManager();
     ~UpgradeManager() = default;
 
+    // Upgrades and technologies are identified by their position in these tables; the
+    // name overloads below only resolve the id
+    const NameTable &get_upgrade_names() const { return upgrade_names_; }
+    const NameTable &get_technology_names() const { return technology_names_; }
+
     // Upgrade operations
+    bool purchase_upgrade(PlayerID player_id, NameID upgrade_id);
     bool purchase_upgrade(PlayerID player_id, const std::string &upgrade_name);
+    bool can_purchase_upgrade(PlayerID player_id, NameID upgrade_id) const;
     bool can_purchase_upgrade(PlayerID player_id, const std::string &upgrade_name) const;
     float get_modifier(PlayerID player_id, const std::string &upgrade_name, const std::string &attribute) const;
 
     // Technology management
+    bool unlock_technology(PlayerID player_id, NameID tech_id);
     bool unlock_technology(PlayerID player_id, const std::string &tech_name);
+    bool has_technology(PlayerID player_id, NameID tech_id) const;
     bool has_technology(PlayerID player_id, const std::string &tech_name) const;
+    std::vector<NameID> get_available_technology_ids(PlayerID player_id) const;
     std::vector<std::string> get_available_technologies(PlayerID player_id) const;
 
     // Get upgrade information
+    std::vector<NameID> get_available_upgrade_ids(PlayerID player_id) const;
     std::vector<std::string> get_available_upgrades(PlayerID player_id) const;
+    int get_upgrade_level(PlayerID player_id, NameID upgrade_id) const;
     int get_upgrade_level(PlayerID player_id, const std::string &upgrade_name) const;
 
+    // Approximate heap bytes held for players' upgrades
+    size_t get_memory_usage() const;
+
 private:
     void initialize_player_upgrades(PlayerID player_id);
     std::unique_ptr<Upgrade> create_upgrade(const std::string &upgrade_name) const;
+    const Upgrade *find_upgrade(PlayerID player_id, NameID upgrade_id) const;
 
+    NameTable upgrade_names_;
+    NameTable technology_names_;
     std::map<PlayerID, PlayerUpgrades> player_upgrades_;
 };
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// Rough heap footprint of standard containers, for per-room memory accounting. Only the
+// container's own storage is counted; callers add what its elements own. Tree nodes are charged
+// the three links and colour of a red-black node on top of the value.
+namespace memory_usage
+{
+    constexpr size_t tree_node_overhead = 4 * sizeof(void *);
+
+    template <typename T>
+    size_t of(const std::vector<T> &values)
+    {
+        return values.capacity() * sizeof(T);
+    }
+
+    template <typename T>
+    size_t of(const std::deque<T> &values)
+    {
+        return values.size() * sizeof(T);
+    }
+
+    template <typename Key, typename Value>
+    size_t of(const std::map<Key, Value> &values)
+    {
+        return values.size() * (sizeof(typename std::map<Key, Value>::value_type) + tree_node_overhead);
+    }
+
+    // Short strings live inside the object
+    inline size_t of(const std::string &value)
+    {
+        return value.capacity() > 15 ? value.capacity() + 1 : 0;
+    }
+}
\ No newline at end of file
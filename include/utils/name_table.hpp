@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "types.hpp"
+
+// Fixed list of names numbered by position; the numbers are what the wire carries in
+// place of the names once a client has the table
+class NameTable
+{
+public:
+    static constexpr NameID invalid_id = 0xffff;
+
+    NameTable() = default;
+    explicit NameTable(std::vector<std::string> names);
+
+    NameID find(const std::string &name) const;
+    const std::string *get_name(NameID id) const { return id < names_.size() ? &names_[id] : nullptr; }
+    const std::vector<std::string> &get_names() const { return names_; }
+    size_t size() const { return names_.size(); }
+
+private:
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, NameID> ids_;
+};
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "memory_usage.hpp"
+
+// Generational handles for values the caller keeps packed in its own arrays, index 0 up to
+// size(). A handle is 32 bits, [generation][SlotBits-bit slot]; its slot records where the value
+// currently sits. Freeing a slot advances its generation, so the old handle stops resolving even
+// after the slot is reused. Backs SlotMap and UnitStore.
+//
+// Not synchronised.
+template <unsigned SlotBits>
+class SlotAllocator
+{
+    static_assert(SlotBits > 0 && SlotBits < 32, "the generation needs some of the handle's bits");
+
+public:
+    using Handle = std::uint32_t;
+    static constexpr Handle invalid_handle = 0; // Generations start at 1, so no handle is 0
+    static constexpr size_t max_size = (size_t{1} << SlotBits) - 1;
+    static constexpr size_t no_index = ~size_t{0};
+
+    // A handle for a value the caller appends at index size(); invalid_handle when every slot is
+    // taken, in which case nothing should be appended
+    Handle allocate()
+    {
+        std::uint32_t slot_index;
+        if (!free_slots_.empty())
+        {
+            slot_index = free_slots_.front();
+            free_slots_.pop_front();
+        }
+        else if (slots_.size() < max_size)
+        {
+            slot_index = static_cast<std::uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        else
+        {
+            return invalid_handle;
+        }
+
+        Slot &slot = slots_[slot_index];
+        slot.value_index = static_cast<std::uint32_t>(value_slots_.size());
+        value_slots_.push_back(slot_index);
+        return (slot.generation << SlotBits) | slot_index;
+    }
+
+    // Frees the handle's slot and returns its value's index; the caller then moves its last value
+    // into that index and drops the last one. no_index, with nothing freed, if the handle is
+    // stale or was never issued.
+    size_t remove(Handle handle)
+    {
+        size_t index = index_of(handle);
+        if (index == no_index)
+        {
+            return no_index;
+        }
+
+        std::uint32_t last_slot = value_slots_.back();
+        slots_[last_slot].value_index = static_cast<std::uint32_t>(index);
+        value_slots_[index] = last_slot;
+        value_slots_.pop_back();
+        release(handle & slot_mask);
+        return index;
+    }
+
+    // Frees every slot; the caller empties its arrays
+    void clear()
+    {
+        for (std::uint32_t slot_index : value_slots_)
+        {
+            release(slot_index);
+        }
+        value_slots_.clear();
+    }
+
+    // The value's index, valid until the next allocate or remove; no_index if the handle is stale
+    size_t index_of(Handle handle) const
+    {
+        std::uint32_t slot_index = handle & slot_mask;
+        if (slot_index >= slots_.size())
+        {
+            return no_index;
+        }
+        const Slot &slot = slots_[slot_index];
+        if (slot.value_index == no_value || slot.generation != handle >> SlotBits)
+        {
+            return no_index;
+        }
+        return slot.value_index;
+    }
+
+    Handle handle_at(size_t index) const
+    {
+        std::uint32_t slot_index = value_slots_[index];
+        return (slots_[slot_index].generation << SlotBits) | slot_index;
+    }
+
+    size_t size() const { return value_slots_.size(); }
+
+    size_t get_memory_usage() const
+    {
+        return memory_usage::of(slots_) + memory_usage::of(free_slots_) + memory_usage::of(value_slots_);
+    }
+
+private:
+    static constexpr std::uint32_t slot_mask = (1u << SlotBits) - 1;
+    static constexpr std::uint32_t generation_mask = 0xffffffffu >> SlotBits;
+    static constexpr std::uint32_t no_value = 0xffffffff;
+
+    struct Slot
+    {
+        std::uint32_t generation{1};
+        std::uint32_t value_index{no_value};
+    };
+
+    void release(std::uint32_t slot_index)
+    {
+        Slot &slot = slots_[slot_index];
+        slot.value_index = no_value;
+        slot.generation = (slot.generation + 1) & generation_mask;
+        if (slot.generation == 0)
+        {
+            slot.generation = 1;
+        }
+        free_slots_.push_back(slot_index);
+    }
+
+    std::vector<Slot> slots_;
+    // Reused oldest first, so each slot's generation advances as slowly as possible
+    std::deque<std::uint32_t> free_slots_;
+    std::vector<std::uint32_t> value_slots_; // Slot of each value, for fixing up after a removal
+};
\ No newline at end of file
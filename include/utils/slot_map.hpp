@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "slot_allocator.hpp"
+
+// Values addressed by 32-bit handles, [u16 generation][u16 slot]. Insert, lookup and remove
+// are O(1). Removing a value advances its slot's generation, so the old handle stops resolving
+// even after the slot is reused. Values are stored packed for iteration; removal moves the last
+// value into the gap, so iteration order is not stable.
+//
+// Not synchronised, and values must not be inserted or removed while iterating.
+template <typename T>
+class SlotMap
+{
+public:
+    using Handle = SlotAllocator<16>::Handle;
+    static constexpr Handle invalid_handle = SlotAllocator<16>::invalid_handle;
+    static constexpr size_t max_size = SlotAllocator<16>::max_size;
+
+    // Returns invalid_handle when every slot is taken
+    Handle insert(T value)
+    {
+        Handle handle = slots_.allocate();
+        if (handle != invalid_handle)
+        {
+            values_.push_back(std::move(value));
+        }
+        return handle;
+    }
+
+    T *get(Handle handle)
+    {
+        size_t index = slots_.index_of(handle);
+        return index != SlotAllocator<16>::no_index ? &values_[index] : nullptr;
+    }
+
+    const T *get(Handle handle) const
+    {
+        size_t index = slots_.index_of(handle);
+        return index != SlotAllocator<16>::no_index ? &values_[index] : nullptr;
+    }
+
+    // False if the handle is stale or was never issued
+    bool remove(Handle handle)
+    {
+        size_t index = slots_.remove(handle);
+        if (index == SlotAllocator<16>::no_index)
+        {
+            return false;
+        }
+        if (index != values_.size() - 1)
+        {
+            values_[index] = std::move(values_.back());
+        }
+        values_.pop_back();
+        return true;
+    }
+
+    void clear()
+    {
+        slots_.clear();
+        values_.clear();
+    }
+
+    size_t size() const { return values_.size(); }
+    bool empty() const { return values_.empty(); }
+
+    typename std::vector<T>::iterator begin() { return values_.begin(); }
+    typename std::vector<T>::iterator end() { return values_.end(); }
+    typename std::vector<T>::const_iterator begin() const { return values_.begin(); }
+    typename std::vector<T>::const_iterator end() const { return values_.end(); }
+
+private:
+    SlotAllocator<16> slots_;
+    std::vector<T> values_;
+};
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Move-only void() callable. Callables up to Capacity bytes, lambdas with a few captures or a
+// whole std::function, are stored inline; larger ones fall back to the heap.
+template <size_t Capacity>
+class SmallCallback
+{
+public:
+    SmallCallback() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, SmallCallback>>>
+    SmallCallback(F &&callable)
+    {
+        using Callable = std::decay_t<F>;
+        if constexpr (fits_inline<Callable>)
+        {
+            new (storage_) Callable(std::forward<F>(callable));
+            ops_ = &inline_ops<Callable>;
+        }
+        else
+        {
+            new (storage_) Callable *(new Callable(std::forward<F>(callable)));
+            ops_ = &heap_ops<Callable>;
+        }
+    }
+
+    SmallCallback(SmallCallback &&other) noexcept { take(other); }
+
+    SmallCallback &operator=(SmallCallback &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    SmallCallback(const SmallCallback &) = delete;
+    SmallCallback &operator=(const SmallCallback &) = delete;
+
+    ~SmallCallback() { reset(); }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+    void operator()() { ops_->invoke(storage_); }
+
+    void reset()
+    {
+        if (ops_)
+        {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void *storage);
+        void (*move)(void *from, void *to); // Leaves from destroyed
+        void (*destroy)(void *storage);
+    };
+
+    template <typename Callable>
+    static constexpr bool fits_inline = sizeof(Callable) <= Capacity &&
+                                        alignof(Callable) <= alignof(std::max_align_t) &&
+                                        std::is_nothrow_move_constructible_v<Callable>;
+
+    template <typename Callable>
+    static constexpr Ops inline_ops = {
+        [](void *storage)
+        { (*static_cast<Callable *>(storage))(); },
+        [](void *from, void *to)
+        {
+            new (to) Callable(std::move(*static_cast<Callable *>(from)));
+            static_cast<Callable *>(from)->~Callable();
+        },
+        [](void *storage)
+        { static_cast<Callable *>(storage)->~Callable(); }};
+
+    template <typename Callable>
+    static constexpr Ops heap_ops = {
+        [](void *storage)
+        { (**static_cast<Callable **>(storage))(); },
+        [](void *from, void *to)
+        { new (to) Callable *(*static_cast<Callable **>(from)); },
+        [](void *storage)
+        { delete *static_cast<Callable **>(storage); }};
+
+    void take(SmallCallback &other)
+    {
+        if (other.ops_)
+        {
+            other.ops_->move(other.storage_, storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];
+    const Ops *ops_{nullptr};
+};
\ No newline at end of file
@@ -6,4 +6,10 @@
 using PlayerID = uint32_t;
 
 // Team number type
-using TeamNumber = uint16_t;
\ No newline at end of file
+using TeamNumber = uint16_t;
+
+// Unit identification type
+using UnitID = uint32_t;
+
+// Interned upgrade, technology or resource name
+using NameID = uint16_t;
\ No newline at end of file
@@ -65,22 +65,26 @@ std::unique_ptr<Unit> Faction::create_unit(UnitType type, PlayerID owner_id)
     }
 
     // Apply faction modifiers
-    if (unit)
+    if (unit && get_unit_modifier(type))
     {
-        if (const UnitModifier *modifier = get_unit_modifier(type))
-        {
-            UnitStats modified_stats = unit->get_stats();
-            modified_stats.max_health = static_cast<int>(modified_stats.max_health * modifier->health_modifier);
-            modified_stats.attack = static_cast<int>(modified_stats.attack * modifier->attack_modifier);
-            modified_stats.armor = static_cast<int>(modified_stats.armor * modifier->defense_modifier);
-            modified_stats.speed = static_cast<int>(modified_stats.speed * modifier->speed_modifier);
-            unit->modify_stats(modified_stats);
-        }
+        unit->modify_stats(apply_unit_modifier(type, unit->get_stats()));
     }
 
     return unit;
 }
 
+UnitStats Faction::apply_unit_modifier(UnitType type, UnitStats stats) const
+{
+    if (const UnitModifier *modifier = get_unit_modifier(type))
+    {
+        stats.max_health = static_cast<int>(stats.max_health * modifier->health_modifier);
+        stats.attack = static_cast<int>(stats.attack * modifier->attack_modifier);
+        stats.armor = static_cast<int>(stats.armor * modifier->defense_modifier);
+        stats.speed = static_cast<int>(stats.speed * modifier->speed_modifier);
+    }
+    return stats;
+}
+
 bool Faction::can_build_unit(UnitType type) const
 {
     return std::find(available_units_.begin(), available_units_.end(), type) != available_units_.end();
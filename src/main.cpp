@@ -1,6 +1,8 @@
 #include "server/castle_server.hpp"
+#include "server/server_runtime.hpp"
 #include <iostream>
 #include <boost/asio.hpp>
+#include <cstring>
 #include <thread>
 #include <chrono>
 
@@ -8,14 +10,76 @@ int main(int argc, char *argv[])
 {
     try
     {
+        // Usage: castle-game [port] [--sharded] [--threads N] [--send-backlog-kb N] [--evict-after-ms N]
+        //                   [--no-rate-limits] [--no-interest] [--snapshot-budget-kb N] [--tick-rate N]
+        //                   [--room-size N] [--room-threads N] [--lockstep] [--record-replays DIR]
         unsigned short port = 12345;
-        if (argc > 1)
+        NetworkMode mode = NetworkMode::Shared;
+        size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t room_threads = num_threads;
+        WriteQueueLimits write_queue_limits;
+        RateLimits rate_limits = RateLimits::defaults();
+        RoomSettings room_settings;
+        for (int i = 1; i < argc; ++i)
         {
-            port = static_cast<unsigned short>(std::stoi(argv[1]));
+            if (std::strcmp(argv[i], "--sharded") == 0)
+            {
+                mode = NetworkMode::Sharded;
+            }
+            else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            {
+                num_threads = std::stoul(argv[++i]);
+            }
+            else if (std::strcmp(argv[i], "--send-backlog-kb") == 0 && i + 1 < argc)
+            {
+                write_queue_limits.max_bytes = std::stoul(argv[++i]) * 1024;
+            }
+            else if (std::strcmp(argv[i], "--evict-after-ms") == 0 && i + 1 < argc)
+            {
+                write_queue_limits.eviction_delay = std::chrono::milliseconds(std::stoul(argv[++i]));
+            }
+            else if (std::strcmp(argv[i], "--no-rate-limits") == 0)
+            {
+                rate_limits = RateLimits{};
+            }
+            else if (std::strcmp(argv[i], "--no-interest") == 0)
+            {
+                room_settings.interest = false;
+            }
+            else if (std::strcmp(argv[i], "--snapshot-budget-kb") == 0 && i + 1 < argc)
+            {
+                room_settings.snapshot_budget = std::stoul(argv[++i]) * 1024;
+            }
+            else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+            {
+                room_settings.tick_rate = static_cast<unsigned>(std::stoul(argv[++i]));
+            }
+            else if (std::strcmp(argv[i], "--room-size") == 0 && i + 1 < argc)
+            {
+                room_settings.max_players = std::max<size_t>(1, std::stoul(argv[++i]));
+            }
+            else if (std::strcmp(argv[i], "--room-threads") == 0 && i + 1 < argc)
+            {
+                room_threads = std::stoul(argv[++i]);
+            }
+            else if (std::strcmp(argv[i], "--lockstep") == 0)
+            {
+                room_settings.lockstep = true;
+            }
+            else if (std::strcmp(argv[i], "--record-replays") == 0 && i + 1 < argc)
+            {
+                room_settings.replay_directory = argv[++i];
+            }
+            else
+            {
+                port = static_cast<unsigned short>(std::stoi(argv[i]));
+            }
         }
 
-        boost::asio::io_context io_context;
-        CastleServer server(io_context, port);
+        ServerRuntime runtime(mode, port, num_threads, room_threads);
+        runtime.get_server().set_write_queue_limits(write_queue_limits);
+        runtime.get_server().set_rate_limits(rate_limits);
+        runtime.get_server().set_room_settings(room_settings);
 
         std::cout << R"(
             _________                  __  .__             _________                                
@@ -26,26 +90,15 @@ int main(int argc, char *argv[])
                     \/     \/     \/                 \/          \/     \/                 \/
             )" << std::endl;
 
-        std::cout << "Castle Game Server starting on port " << port << std::endl;
-        server.start();
+        std::cout << "Castle Game Server starting on port " << port
+                  << " (" << (mode == NetworkMode::Sharded ? "sharded" : "shared") << " networking, "
+                  << runtime.get_thread_count() << " threads, " << ServerRuntime::get_backend_name() << ", "
+                  << room_settings.max_players << " players per room on " << runtime.get_room_thread_count()
+                  << " room threads, " << room_settings.tick_rate << " ticks/s"
+                  << (room_settings.lockstep ? ", lockstep" : "") << ")" << std::endl;
 
-        // Run the server with multiple threads
-        const int num_threads = std::thread::hardware_concurrency();
-        std::vector<std::thread> threads;
-        for (int i = 0; i < num_threads - 1; ++i)
-        {
-            threads.emplace_back([&io_context]()
-                                 { io_context.run(); });
-        }
-
-        // Main thread also runs the io_context
-        io_context.run();
-
-        // Wait for all threads to complete
-        for (auto &thread : threads)
-        {
-            thread.join();
-        }
+        // Runs the server on all threads; the main thread is one of them
+        runtime.run();
     }
     catch (const std::exception &e)
     {
@@ -54,4 +107,4 @@ int main(int argc, char *argv[])
     }
 
     return 0;
-}
+}
\ No newline at end of file
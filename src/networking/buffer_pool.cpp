@@ -0,0 +1,82 @@
+#include "networking/buffer_pool.hpp"
+#if defined(BOOST_ASIO_HAS_IO_URING)
+#include <iostream>
+#endif
+
+BufferPool::BufferPool(size_t block_size, size_t block_count)
+    : block_size_(block_size), block_count_(block_count),
+      slab_(std::make_unique<uint8_t[]>(block_size * block_count))
+{
+    free_blocks_.reserve(block_count_);
+    for (size_t i = block_count_; i > 0; --i)
+    {
+        free_blocks_.push_back(slab_.get() + (i - 1) * block_size_);
+    }
+}
+
+BufferPool::~BufferPool() = default;
+
+uint8_t *BufferPool::acquire()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_blocks_.empty())
+    {
+        return nullptr;
+    }
+
+    uint8_t *block = free_blocks_.back();
+    free_blocks_.pop_back();
+    return block;
+}
+
+void BufferPool::release(uint8_t *block)
+{
+    if (!block)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_blocks_.push_back(block);
+}
+
+size_t BufferPool::get_available_blocks() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_blocks_.size();
+}
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+void BufferPool::register_blocks(boost::asio::io_context &io_context)
+{
+    std::vector<boost::asio::mutable_buffer> blocks;
+    blocks.reserve(block_count_);
+    for (size_t i = 0; i < block_count_; ++i)
+    {
+        blocks.push_back(boost::asio::buffer(slab_.get() + i * block_size_, block_size_));
+    }
+
+    try
+    {
+        registrations_.push_back(Registration{&io_context, boost::asio::register_buffers(io_context, blocks)});
+    }
+    catch (const boost::system::system_error &e)
+    {
+        // Typically RLIMIT_MEMLOCK; reads still work, just without fixed buffers
+        std::cerr << "Could not register receive buffers with io_uring: " << e.what() << "\n";
+    }
+}
+
+boost::asio::mutable_registered_buffer BufferPool::get_registered_block(const uint8_t *block,
+                                                                        const boost::asio::execution_context &context) const
+{
+    for (const auto &registration : registrations_)
+    {
+        if (registration.context == &context)
+        {
+            return registration.buffers.cbegin()[static_cast<size_t>(block - slab_.get()) / block_size_];
+        }
+    }
+    return boost::asio::mutable_registered_buffer();
+}
+#endif
\ No newline at end of file
@@ -1,20 +1,92 @@
 #include "networking/client_connection.hpp"
-#include "networking/message_utils.hpp"
+#include "networking/message_dispatcher.hpp"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <typeinfo>
 
-using namespace message_utils;
+namespace
+{
+    // Client-role responses are only reported; interned names print as their ids
+    struct ResponsePrinter
+    {
+        void operator()(const payload::UpgradeResponse &response) const
+        {
+            print_upgrade(response.upgrade_name, response.success, response.new_level);
+        }
+        void operator()(const payload::InternedUpgradeResponse &response) const
+        {
+            print_upgrade("#" + std::to_string(response.upgrade_id), response.success, response.new_level);
+        }
+        void operator()(const payload::TechnologyResponse &response) const
+        {
+            print_technology(response.tech_name, response.success);
+        }
+        void operator()(const payload::InternedTechnologyResponse &response) const
+        {
+            print_technology("#" + std::to_string(response.tech_id), response.success);
+        }
+        template <typename ListResponse>
+        void operator()(const ListResponse &response) const
+        {
+            std::cout << "Received upgrade list update:\n";
+            std::cout << "Available upgrades: " << response.available_upgrades.size() << "\n";
+            std::cout << "Available technologies: " << response.available_technologies.size() << "\n";
+        }
+        void operator()(const payload::NameDictionary &dictionary) const
+        {
+            std::cout << "Received name dictionary: " << dictionary.upgrades.size() << " upgrades, "
+                      << dictionary.technologies.size() << " technologies, "
+                      << dictionary.resources.size() << " resources\n";
+        }
+
+        static void print_upgrade(std::string_view upgrade_name, bool success, int new_level)
+        {
+            std::cout << "Upgrade " << upgrade_name << " "
+                      << (success ? "succeeded" : "failed")
+                      << " (new level: " << new_level << ")\n";
+        }
+        static void print_technology(std::string_view tech_name, bool success)
+        {
+            std::cout << "Technology " << tech_name << " "
+                      << (success ? "unlocked" : "failed to unlock") << "\n";
+        }
+    };
+}
 
-ClientConnection::ClientConnection(tcp::socket socket, PlayerID player_id)
-    : socket_(std::move(socket)), player_id_(player_id), read_buffer_(header_length)
+ClientConnection::ClientConnection(tcp::socket socket, PlayerID player_id,
+                                   std::shared_ptr<BufferPool> buffer_pool)
+    : socket_(std::move(socket)), player_id_(player_id),
+      deferred_move_timer_(socket_.get_executor()),
+      buffer_pool_(std::move(buffer_pool)),
+      pooled_buffer_(buffer_pool_ ? buffer_pool_->acquire() : nullptr),
+      decoder_(pooled_buffer_,
+               pooled_buffer_ ? buffer_pool_->get_block_size() : default_receive_buffer_length,
+               max_message_length)
 {
+    write_buffers_.reserve(max_write_batch_buffers);
 }
 
-ClientConnection::~ClientConnection() = default;
+ClientConnection::~ClientConnection()
+{
+    if (buffer_pool_)
+    {
+        buffer_pool_->release(pooled_buffer_);
+    }
+}
 
 void ClientConnection::start()
 {
     connected_ = true;
-    do_read_header();
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    if (pooled_buffer_)
+    {
+        registered_block_ = buffer_pool_->get_registered_block(
+            pooled_buffer_,
+            boost::asio::query(socket_.get_executor(), boost::asio::execution::context_as<boost::asio::execution_context &>));
+    }
+#endif
+    do_read();
 }
 
 void ClientConnection::stop()
@@ -24,321 +96,549 @@ void ClientConnection::stop()
         connected_ = false;
         boost::system::error_code ec;
         socket_.close(ec);
+        if (disconnect_handler_)
+        {
+            disconnect_handler_(player_id_);
+        }
     }
 }
 
 void ClientConnection::send_message(const Message &message)
 {
-    auto serialized = message.serialize();
-    bool write_in_progress = !write_queue_.empty();
-    write_queue_.push(std::move(serialized));
-
-    if (!write_in_progress)
+    if (capabilities_ & capabilities::compact_encoding)
     {
-        do_write();
+        auto payload = std::make_shared<std::vector<uint8_t>>();
+        compact_codec::serialize(message, compact_layout_, *payload);
+        send_payload(std::move(payload));
+        return;
     }
-}
 
-void ClientConnection::do_read_header()
-{
-    auto self(shared_from_this());
-    boost::asio::async_read(socket_,
-                            boost::asio::buffer(read_buffer_, header_length),
-                            [this, self](boost::system::error_code ec, std::size_t /*length*/)
-                            {
-                                if (!ec && connected_)
-                                {
-                                    message_length_ =
-                                        (static_cast<uint32_t>(read_buffer_[0]) << 24) |
-                                        (static_cast<uint32_t>(read_buffer_[1]) << 16) |
-                                        (static_cast<uint32_t>(read_buffer_[2]) << 8) |
-                                        static_cast<uint32_t>(read_buffer_[3]);
-
-                                    message_buffer_.resize(message_length_);
-                                    do_read_body();
-                                }
-                                else
-                                {
-                                    stop();
-                                }
-                            });
+    send_payload(message.serialize_shared());
 }
 
-void ClientConnection::do_read_body()
+void ClientConnection::send_payload(SharedPayload payload)
 {
-    auto self(shared_from_this());
-    boost::asio::async_read(socket_,
-                            boost::asio::buffer(message_buffer_, message_length_),
-                            [this, self](boost::system::error_code ec, std::size_t /*length*/)
-                            {
-                                if (!ec && connected_)
-                                {
-                                    Message message = Message::deserialize(message_buffer_);
-                                    handle_message(message);
-                                    do_read_header();
-                                }
-                                else
-                                {
-                                    stop();
-                                }
-                            });
-}
+    if (!running_in_this_thread())
+    {
+        // Called from another connection or thread; hop onto this connection's executor
+        auto self(shared_from_this());
+        boost::asio::dispatch(socket_.get_executor(),
+                              [this, self, payload = std::move(payload)]() mutable
+                              { queue_payload(std::move(payload)); });
+        return;
+    }
 
-void ClientConnection::do_write()
-{
-    auto self(shared_from_this());
-    boost::asio::async_write(socket_,
-                             boost::asio::buffer(write_queue_.front()),
-                             [this, self](boost::system::error_code ec, std::size_t /*length*/)
-                             {
-                                 if (!ec && connected_)
-                                 {
-                                     write_queue_.pop();
-                                     if (!write_queue_.empty())
-                                     {
-                                         do_write();
-                                     }
-                                 }
-                                 else
-                                 {
-                                     stop();
-                                 }
-                             });
+    queue_payload(std::move(payload));
 }
 
-void ClientConnection::handle_message(const Message &message)
+void ClientConnection::queue_payload(SharedPayload payload)
 {
-    switch (message.type)
+    if (!connected_)
     {
-    case MessageType::Connect:
-        handle_connect(message);
-        break;
-    case MessageType::Disconnect:
-        handle_disconnect();
-        break;
-    case MessageType::ChatMessage:
-        handle_chat_message(message);
-        break;
-    case MessageType::PlayerMove:
-        handle_move_request(message);
-        break;
-    case MessageType::PlayerBuild:
-        handle_build_request(message);
-        break;
-    case MessageType::PlayerAttack:
-        handle_attack_request(message);
-        break;
-    case MessageType::PlayerHarvest:
-        handle_harvest_request(message);
-        break;
-    case MessageType::RequestUpgrade:
-        handle_upgrade_request(message);
-        break;
-    case MessageType::RequestTechnology:
-        handle_technology_request(message);
-        break;
-    case MessageType::UpgradeListRequest:
-        handle_upgrade_list_request();
-        break;
-    case MessageType::UpgradeResponse:
-        handle_upgrade_response(message);
-        break;
-    case MessageType::TechnologyResponse:
-        handle_technology_response(message);
-        break;
-    case MessageType::UpgradeListResponse:
-        handle_upgrade_list_response(message);
-        break;
-    default:
-        std::cerr << "Unknown message type received\n";
-        break;
+        return;
     }
 
-    if (message_handler_)
+    // Each snapshot is a delta against one the client acknowledged, never against an unsent one,
+    // so a newer snapshot replaces any still waiting in the queue
+    bool snapshot = !payload->empty() &&
+                    static_cast<MessageType>((*payload)[0] & ~message_flags::all) == MessageType::ResourceUpdate;
+    if (snapshot)
     {
-        message_handler_(message);
+        drop_superseded_snapshots();
     }
-}
 
-void ClientConnection::handle_connect(const Message &message)
-{
-    connected_ = true;
-    // Send acknowledgment back to client
-    Message response;
-    response.type = MessageType::ConnectResponse;
-    response.player_id = player_id_;
-    send_message(response);
+    queued_bytes_ += payload->size();
+    write_queue_.push_back(QueuedPayload{std::move(payload), snapshot});
+    stats_.queued_bytes_high_water = std::max(stats_.queued_bytes_high_water, queued_bytes_);
+    stats_.queued_messages_high_water = std::max(stats_.queued_messages_high_water, write_queue_.size());
+    if (!within_write_queue_limits())
+    {
+        return;
+    }
+
+    if (!writing_)
+    {
+        do_write();
+    }
 }
 
-void ClientConnection::handle_disconnect()
+void ClientConnection::drop_superseded_snapshots()
 {
-    connected_ = false;
-    socket_.close();
+    for (size_t i = write_queue_.size(); i > committed_messages_; --i)
+    {
+        auto entry = write_queue_.begin() + (i - 1);
+        if (entry->snapshot)
+        {
+            queued_bytes_ -= entry->payload->size();
+            write_queue_.erase(entry);
+            ++stats_.snapshots_superseded;
+        }
+    }
 }
 
-void ClientConnection::handle_chat_message(const Message &message)
+bool ClientConnection::within_write_queue_limits()
 {
-    if (!authenticated_)
-        return;
+    if (queued_bytes_ <= write_queue_limits_.max_bytes && write_queue_.size() <= write_queue_limits_.max_messages)
+    {
+        over_write_queue_limits_ = false;
+        return true;
+    }
 
-    // Forward the chat message to the message handler if set
-    if (message_handler_)
+    auto now = std::chrono::steady_clock::now();
+    if (!over_write_queue_limits_)
     {
-        message_handler_(message);
+        over_write_queue_limits_ = true;
+        over_write_queue_limits_since_ = now;
+        return true;
     }
+    if (now - over_write_queue_limits_since_ < write_queue_limits_.eviction_delay)
+    {
+        return true;
+    }
+
+    std::cerr << "Player " << player_id_ << " has " << queued_bytes_ << " bytes in " << write_queue_.size()
+              << " messages waiting to send, disconnecting\n";
+    stats_.evicted = true;
+    stop();
+
+    // The in-flight write still references the committed entries; the rest can go now
+    for (size_t i = committed_messages_; i < write_queue_.size(); ++i)
+    {
+        queued_bytes_ -= write_queue_[i].payload->size();
+    }
+    write_queue_.erase(write_queue_.begin() + committed_messages_, write_queue_.end());
+    return false;
 }
 
-void ClientConnection::handle_move_request(const Message &message)
+bool ClientConnection::running_in_this_thread()
 {
-    if (!authenticated_)
-        return;
-
-    // Forward the move request to the message handler
-    if (message_handler_)
+    // any_io_executor::target does not check the type in older Boost releases, so compare first
+    using strand_type = boost::asio::strand<boost::asio::io_context::executor_type>;
+    auto executor = socket_.get_executor();
+    if (executor.target_type() == typeid(strand_type))
+    {
+        return executor.target<strand_type>()->running_in_this_thread();
+    }
+    if (executor.target_type() == typeid(boost::asio::io_context::executor_type))
     {
-        message_handler_(message);
+        return executor.target<boost::asio::io_context::executor_type>()->running_in_this_thread();
     }
+    return false;
 }
 
-void ClientConnection::handle_build_request(const Message &message)
+void ClientConnection::do_read()
 {
-    if (!authenticated_)
+    auto self(shared_from_this());
+    auto on_read = [this, self](boost::system::error_code ec, std::size_t length)
+    {
+        if (ec || !connected_)
+        {
+            stop();
+            return;
+        }
+
+        ++stats_.reads;
+        decoder_.commit(length);
+        if (dispatch_frames())
+        {
+            do_read();
+        }
+    };
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    // Reads into the pooled block go through its registered form; the overflow buffer used for
+    // oversized frames is not registered
+    uint8_t *position = decoder_.write_position();
+    if (registered_block_.size() != 0 && position >= pooled_buffer_ &&
+        position < pooled_buffer_ + registered_block_.size())
+    {
+        socket_.async_read_some(boost::asio::buffer(registered_block_ + static_cast<size_t>(position - pooled_buffer_),
+                                                    decoder_.write_space()),
+                                std::move(on_read));
         return;
+    }
+#endif
+    socket_.async_read_some(boost::asio::buffer(decoder_.write_position(), decoder_.write_space()),
+                            std::move(on_read));
+}
 
-    // Forward the build request to the message handler
-    if (message_handler_)
+bool ClientConnection::dispatch_frames()
+{
+    // Handle every complete frame this read delivered before reading again
+    MessageView message;
+    while (connected_)
     {
-        message_handler_(message);
+        switch (decoder_.next(message))
+        {
+        case FrameDecoder::Status::Frame:
+            ++stats_.messages_received;
+            if (message.compressed && !decompress(message))
+            {
+                std::cerr << "Malformed compressed message, closing connection\n";
+                stop();
+                return false;
+            }
+            if (message.compact && !expand_compact(message))
+            {
+                std::cerr << "Malformed compact message, closing connection\n";
+                stop();
+                return false;
+            }
+            message.player_id = player_id_;
+            handle_message(message);
+            break;
+        case FrameDecoder::Status::NeedMore:
+            return true;
+        case FrameDecoder::Status::Oversized:
+            std::cerr << "Message exceeds " << max_message_length << " bytes, closing connection\n";
+            stop();
+            return false;
+        case FrameDecoder::Status::Malformed:
+            std::cerr << "Malformed message, closing connection\n";
+            stop();
+            return false;
+        }
     }
+    return false;
 }
 
-void ClientConnection::handle_attack_request(const Message &message)
+bool ClientConnection::expand_compact(MessageView &message)
 {
-    if (!authenticated_)
-        return;
+    if (!(capabilities_ & capabilities::compact_encoding))
+    {
+        return false;
+    }
 
-    // Forward the attack request to the message handler
-    if (message_handler_)
+    // Handlers read the standard layout; expanded_payload_ is reused, so this stays allocation-free
+    if (compact_codec::has_compact_payload(message.type))
     {
-        message_handler_(message);
+        if (!compact_codec::expand(message, compact_layout_, expanded_payload_))
+        {
+            return false;
+        }
+        message.data = expanded_payload_.data();
+        message.size = expanded_payload_.size();
     }
+    message.compact = false;
+    return true;
 }
 
-void ClientConnection::handle_harvest_request(const Message &message)
+bool ClientConnection::decompress(MessageView &message)
 {
-    if (!authenticated_)
-        return;
-
-    // Forward the harvest request to the message handler
-    if (message_handler_)
+    if (!decompressor_ ||
+        !decompressor_->decompress(message.data, message.size, max_message_length, decompressed_payload_))
     {
-        message_handler_(message);
+        return false;
     }
+
+    message.data = decompressed_payload_.data();
+    message.size = decompressed_payload_.size();
+    message.compressed = false;
+    return true;
 }
 
-void ClientConnection::handle_upgrade_request(const Message &message)
+SharedPayload ClientConnection::compress(SharedPayload payload)
 {
-    if (!is_authenticated())
+    MessageView message;
+    if (!Message::parse(payload->data(), payload->size(), message) || message.compressed ||
+        message.size < compression_threshold_)
     {
-        return;
+        return payload;
     }
 
-    // Forward the upgrade request to the server through the message handler
-    if (message_handler_)
+    auto compressed = std::make_shared<std::vector<uint8_t>>();
+    if (!compressor_->compress(message, *compressed))
     {
-        message_handler_(message);
+        std::cerr << "Compression failed, closing connection\n";
+        stop();
+        return nullptr;
     }
+
+    ++stats_.messages_compressed;
+    stats_.bytes_saved_by_compression += payload->size() - std::min(payload->size(), compressed->size());
+    return compressed;
 }
 
-void ClientConnection::handle_technology_request(const Message &message)
+void ClientConnection::do_write()
 {
-    if (!is_authenticated())
+    // Gather as much of the queue as fits in one batch; the first message always goes.
+    // A partially written front message resumes at write_offset_.
+    write_buffers_.clear();
+    size_t batch_bytes = 0;
+    size_t offset = write_offset_;
+    for (size_t i = 0; i < write_queue_.size(); ++i)
     {
-        return;
+        SharedPayload &payload = write_queue_[i].payload;
+        if (i >= committed_messages_)
+        {
+            // Deflated only once it is certain to be sent, so the stream matches the wire
+            if (compressor_ && payload->size() >= compression_threshold_)
+            {
+                size_t uncompressed_size = payload->size();
+                payload = compress(std::move(payload));
+                if (!payload)
+                {
+                    return;
+                }
+                queued_bytes_ = queued_bytes_ - uncompressed_size + payload->size();
+            }
+            committed_messages_ = i + 1;
+        }
+
+        size_t remaining = payload->size() - offset;
+        if (!write_buffers_.empty() &&
+            (batch_bytes + remaining > max_write_batch_bytes_ ||
+             write_buffers_.size() == max_write_batch_buffers))
+        {
+            break;
+        }
+        write_buffers_.push_back(boost::asio::buffer(payload->data() + offset, remaining));
+        batch_bytes += remaining;
+        offset = 0;
     }
 
-    // Forward the technology request to the server through the message handler
-    if (message_handler_)
+    // async_write would split the batch into 16-buffer writev calls, so partial
+    // writes are handled here and the whole batch goes out in a single syscall
+    writing_ = true;
+    auto self(shared_from_this());
+    socket_.async_write_some(
+        WriteBatch{write_buffers_.data(), write_buffers_.data() + write_buffers_.size()},
+        [this, self](boost::system::error_code ec, std::size_t length)
+        {
+            writing_ = false;
+            if (!ec && connected_)
+            {
+                ++stats_.write_batches;
+                stats_.bytes_sent += length;
+                while (length > 0)
+                {
+                    size_t remaining = write_queue_.front().payload->size() - write_offset_;
+                    if (length < remaining)
+                    {
+                        write_offset_ += length;
+                        break;
+                    }
+                    length -= remaining;
+                    write_offset_ = 0;
+                    queued_bytes_ -= write_queue_.front().payload->size();
+                    write_queue_.pop_front();
+                    --committed_messages_;
+                    ++stats_.messages_sent;
+                }
+                if (over_write_queue_limits_ && !within_write_queue_limits())
+                {
+                    return;
+                }
+                if (!write_queue_.empty())
+                {
+                    do_write();
+                }
+            }
+            else
+            {
+                stop();
+            }
+        });
+}
+
+void ClientConnection::set_rate_limits(const RateLimits &limits)
+{
+    rate_limiter_.configure(limits, RateLimiter::Clock::now());
+}
+
+void ClientConnection::handle_message(const MessageView &message)
+{
+    if (rate_limiter_.enabled() && message.type != MessageType::Disconnect)
     {
-        message_handler_(message);
+        // A move behind a waiting one must not overtake it
+        bool move = message.type == MessageType::PlayerMove;
+        if (move && has_deferred_move_)
+        {
+            defer_move(message);
+            return;
+        }
+        if (!rate_limiter_.allow(message.type, RateLimiter::Clock::now()))
+        {
+            if (move)
+            {
+                defer_move(message);
+            }
+            else
+            {
+                ++stats_.messages_rate_limited;
+            }
+            return;
+        }
     }
+
+    dispatch_message(message);
 }
 
-void ClientConnection::handle_upgrade_list_request()
+void ClientConnection::defer_move(const MessageView &move)
 {
-    if (!is_authenticated())
+    if (has_deferred_move_)
     {
-        return;
+        // Only an order for the same units supersedes the waiting one; otherwise it is lost
+        payload::Move waiting;
+        payload::Move incoming;
+        MessageView waiting_view = move;
+        waiting_view.data = deferred_move_.data();
+        waiting_view.size = deferred_move_.size();
+        bool same_units = message_schema::decode(waiting_view, waiting) && message_schema::decode(move, incoming) &&
+                          waiting.unit_ids.byte_size() == incoming.unit_ids.byte_size() &&
+                          std::memcmp(waiting.unit_ids.bytes(), incoming.unit_ids.bytes(), waiting.unit_ids.byte_size()) == 0;
+        if (same_units)
+        {
+            ++stats_.moves_merged;
+        }
+        else
+        {
+            ++stats_.messages_rate_limited;
+        }
     }
 
-    // Create and forward the upgrade list request
-    Message request;
-    request.type = MessageType::UpgradeListRequest;
+    deferred_move_.assign(move.begin(), move.end());
+    has_deferred_move_ = true;
+    schedule_deferred_move();
+}
 
-    if (message_handler_)
+void ClientConnection::schedule_deferred_move()
+{
+    if (deferred_move_timer_armed_)
     {
-        message_handler_(request);
+        return;
     }
+
+    deferred_move_timer_armed_ = true;
+    deferred_move_timer_.expires_after(rate_limiter_.time_until_allowed(MessageType::PlayerMove));
+    auto self(shared_from_this());
+    deferred_move_timer_.async_wait([this, self](const boost::system::error_code &ec)
+                                    {
+                                        deferred_move_timer_armed_ = false;
+                                        if (ec || !connected_ || !has_deferred_move_)
+                                        {
+                                            return;
+                                        }
+                                        if (!rate_limiter_.allow(MessageType::PlayerMove, RateLimiter::Clock::now()))
+                                        {
+                                            schedule_deferred_move();
+                                            return;
+                                        }
+
+                                        has_deferred_move_ = false;
+                                        MessageView move;
+                                        move.type = MessageType::PlayerMove;
+                                        move.data = deferred_move_.data();
+                                        move.size = deferred_move_.size();
+                                        move.player_id = player_id_;
+                                        dispatch_message(move);
+                                    });
 }
 
-void ClientConnection::handle_upgrade_response(const Message &message)
+void ClientConnection::dispatch_message(const MessageView &message)
 {
-    if (!is_authenticated())
+    // The handshake belongs to the connection; everything else goes through the server's table
+    switch (message.type)
     {
+    case MessageType::Connect:
+        handle_connect(message);
         return;
+    case MessageType::Disconnect:
+        handle_disconnect();
+        return;
+    default:
+        break;
     }
 
-    size_t offset = 0;
-    bool success = message_utils::read_from_vector<bool>(message.data, offset);
-    std::string upgrade_name = message_utils::read_string(message.data, offset);
-    int new_level = message_utils::read_from_vector<int>(message.data, offset);
+    if (dispatcher_)
+    {
+        switch (dispatcher_->dispatch(*this, message))
+        {
+        case MessageDispatcher::Result::Handled:
+        case MessageDispatcher::Result::Unauthenticated:
+            return;
+        case MessageDispatcher::Result::Malformed:
+            std::cerr << "Malformed message of type " << static_cast<int>(message.type) << " received\n";
+            return;
+        case MessageDispatcher::Result::Unregistered:
+            break;
+        }
+    }
 
-    std::cout << "Upgrade " << upgrade_name << " "
-              << (success ? "succeeded" : "failed")
-              << " (new level: " << new_level << ")\n";
+    // Client role: responses to our own requests
+    handle_server_response(message);
 }
 
-void ClientConnection::handle_technology_response(const Message &message)
+void ClientConnection::handle_connect(const MessageView &message)
 {
-    if (!is_authenticated())
+    // There are no credentials yet; completing the handshake is what admits a player
+    connected_ = true;
+    authenticated_ = true;
+    // Send acknowledgment back to client
+    Message response;
+    response.type = MessageType::ConnectResponse;
+    response.player_id = player_id_;
+
+    // Clients that offer capabilities append a bitmask after their name and get back the
+    // accepted subset plus the map bounds; older clients get the empty response
+    payload::Connect connect;
+    if (!message_schema::decode(message, connect) || !connect.offered_capabilities.value)
     {
+        send_message(response);
         return;
     }
 
-    size_t offset = 0;
-    bool success = message_utils::read_from_vector<bool>(message.data, offset);
-    std::string tech_name = message_utils::read_string(message.data, offset);
+    uint32_t offered = connect.offered_capabilities.value;
+    uint32_t accepted = 0;
+    if (compact_layout_.width)
+    {
+        accepted |= offered & capabilities::compact_encoding;
+    }
+    if (name_dictionary_)
+    {
+        accepted |= offered & capabilities::interned_names;
+    }
+    if (compression_threshold_)
+    {
+        accepted |= offered & capabilities::compressed_payloads;
+    }
+    response = message_schema::encode(payload::ConnectResponse{accepted, compact_layout_.width, compact_layout_.height});
+    response.player_id = player_id_;
+    send_message(response);
+    if (accepted & capabilities::interned_names)
+    {
+        send_payload(name_dictionary_);
+    }
+    if (accepted & capabilities::compressed_payloads)
+    {
+        // The response above went out plain; everything queued from here on may be compressed
+        compressor_ = std::make_unique<PayloadCompressor>();
+        decompressor_ = std::make_unique<PayloadDecompressor>();
+    }
+    capabilities_ = accepted;
+}
 
-    std::cout << "Technology " << tech_name << " "
-              << (success ? "unlocked" : "failed to unlock") << "\n";
+void ClientConnection::handle_disconnect()
+{
+    stop();
 }
 
-void ClientConnection::handle_upgrade_list_response(const Message &message)
+void ClientConnection::handle_server_response(const MessageView &message)
 {
     if (!is_authenticated())
     {
         return;
     }
 
-    size_t offset = 0;
-
-    // Read available upgrades
-    uint32_t upgrade_count = message_utils::read_from_vector<uint32_t>(message.data, offset);
-    std::vector<std::string> available_upgrades;
-    for (uint32_t i = 0; i < upgrade_count; ++i)
+    auto result = capabilities_ & capabilities::interned_names
+                      ? payload::InternedClientInbound::dispatch(message, ResponsePrinter{})
+                      : payload::ClientInbound::dispatch(message, ResponsePrinter{});
+    if (result == message_schema::DispatchResult::Malformed)
     {
-        available_upgrades.push_back(message_utils::read_string(message.data, offset));
+        std::cerr << "Malformed server response received\n";
     }
-
-    // Read available technologies
-    uint32_t tech_count = message_utils::read_from_vector<uint32_t>(message.data, offset);
-    std::vector<std::string> available_technologies;
-    for (uint32_t i = 0; i < tech_count; ++i)
+    else if (result == message_schema::DispatchResult::Unhandled)
     {
-        available_technologies.push_back(message_utils::read_string(message.data, offset));
+        std::cerr << "Unknown message type received\n";
     }
-
-    std::cout << "Received upgrade list update:\n";
-    std::cout << "Available upgrades: " << upgrade_count << "\n";
-    std::cout << "Available technologies: " << tech_count << "\n";
 }
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "networking/compact_codec.hpp"
+#include "networking/message_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace message_utils;
+
+namespace
+{
+    constexpr size_t max_varint32_length = 5;
+
+    uint8_t bits_for(uint16_t extent)
+    {
+        uint8_t bits = 0;
+        while ((1u << bits) < extent)
+        {
+            ++bits;
+        }
+        return bits;
+    }
+
+    uint8_t *encode_varint32(uint8_t *position, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            *position++ = static_cast<uint8_t>(value) | 0x80;
+            value >>= 7;
+        }
+        *position++ = static_cast<uint8_t>(value);
+        return position;
+    }
+
+    size_t packed_length(const CompactLayout &layout)
+    {
+        return (layout.x_bits + layout.y_bits + 7) / 8;
+    }
+
+    void write_packed(std::vector<uint8_t> &vec, const CompactLayout &layout, int x, int y)
+    {
+        uint32_t packed = static_cast<uint32_t>(x) | (static_cast<uint32_t>(y) << layout.x_bits);
+        for (size_t i = 0; i < packed_length(layout); ++i)
+        {
+            vec.push_back(static_cast<uint8_t>(packed >> (8 * i)));
+        }
+    }
+
+    bool read_packed(const uint8_t *&position, const uint8_t *end, const CompactLayout &layout, int &x, int &y)
+    {
+        size_t length = packed_length(layout);
+        if (static_cast<size_t>(end - position) < length)
+        {
+            return false;
+        }
+        uint32_t packed = 0;
+        for (size_t i = 0; i < length; ++i)
+        {
+            packed |= static_cast<uint32_t>(*position++) << (8 * i);
+        }
+        x = static_cast<int>(packed & ((1u << layout.x_bits) - 1));
+        y = static_cast<int>((packed >> layout.x_bits) & ((1u << layout.y_bits) - 1));
+        return layout.contains(x, y);
+    }
+
+    bool read_varint32(const uint8_t *&position, const uint8_t *end, uint32_t &value)
+    {
+        // Sorted id deltas are almost always a single byte
+        if (position < end && *position < 0x80)
+        {
+            value = *position++;
+            return true;
+        }
+
+        uint64_t wide;
+        if (!compact_codec::read_varint(position, end, wide) || wide > std::numeric_limits<uint32_t>::max())
+        {
+            return false;
+        }
+        value = static_cast<uint32_t>(wide);
+        return true;
+    }
+
+    // Writes the compact payload of a standard-form message; false if it has to stay standard
+    bool encode_payload(const Message &message, const CompactLayout &layout, std::vector<uint8_t> &out)
+    {
+        size_t offset = 0;
+        switch (message.type)
+        {
+        case MessageType::PlayerMove:
+        {
+            int x = read_from_vector<int>(message.data, offset);
+            int y = read_from_vector<int>(message.data, offset);
+            uint32_t count = read_from_vector<uint32_t>(message.data, offset);
+            if (!layout.contains(x, y))
+            {
+                return false;
+            }
+
+            // A move order is a set of units, so sort to make every delta small
+            thread_local std::vector<uint32_t> unit_ids;
+            unit_ids.resize(count);
+            std::memcpy(unit_ids.data(), message.data.data() + offset, count * sizeof(uint32_t));
+            if (!std::is_sorted(unit_ids.begin(), unit_ids.end()))
+            {
+                std::sort(unit_ids.begin(), unit_ids.end());
+            }
+
+            write_packed(out, layout, x, y);
+            compact_codec::write_varint(out, count);
+
+            // Write the deltas straight into worst-case space, then trim
+            size_t ids_offset = out.size();
+            out.resize(ids_offset + count * max_varint32_length);
+            uint8_t *position = out.data() + ids_offset;
+            uint32_t previous = 0;
+            for (uint32_t id : unit_ids)
+            {
+                position = encode_varint32(position, id - previous);
+                previous = id;
+            }
+            out.resize(position - out.data());
+            return true;
+        }
+        case MessageType::PlayerBuild:
+        {
+            int x = read_from_vector<int>(message.data, offset);
+            int y = read_from_vector<int>(message.data, offset);
+            if (!layout.contains(x, y))
+            {
+                return false;
+            }
+            write_packed(out, layout, x, y);
+            compact_codec::write_varint(out, read_from_vector<uint32_t>(message.data, offset));
+            return true;
+        }
+        case MessageType::PlayerAttack:
+        case MessageType::PlayerHarvest:
+            compact_codec::write_varint(out, read_from_vector<uint32_t>(message.data, offset));
+            compact_codec::write_varint(out, read_from_vector<uint32_t>(message.data, offset));
+            return true;
+        default:
+            out.insert(out.end(), message.data.begin(), message.data.end());
+            return true;
+        }
+    }
+}
+
+CompactLayout::CompactLayout(uint16_t map_width, uint16_t map_height)
+    : width(map_width), height(map_height), x_bits(bits_for(map_width)), y_bits(bits_for(map_height))
+{
+}
+
+namespace compact_codec
+{
+    void write_varint(std::vector<uint8_t> &vec, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            vec.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        vec.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool read_varint(const uint8_t *&position, const uint8_t *end, uint64_t &value)
+    {
+        value = 0;
+        for (unsigned shift = 0; shift < 64 && position < end; shift += 7)
+        {
+            uint8_t byte = *position++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool has_compact_payload(MessageType type)
+    {
+        return type == MessageType::PlayerMove || type == MessageType::PlayerBuild ||
+               type == MessageType::PlayerAttack || type == MessageType::PlayerHarvest;
+    }
+
+    void serialize(const Message &message, const CompactLayout &layout, std::vector<uint8_t> &out)
+    {
+        // Leave room for the longest size prefix, encode the payload, then close the gap
+        size_t start = out.size();
+        out.reserve(start + 1 + max_varint32_length + message.data.size());
+        out.push_back(static_cast<uint8_t>(message.type) | message_flags::compact);
+        out.resize(out.size() + max_varint32_length);
+        size_t payload_start = out.size();
+        if (!encode_payload(message, layout, out))
+        {
+            out.resize(start);
+            write_to_vector(out, message.type);
+            write_to_vector(out, static_cast<uint32_t>(message.data.size()));
+            out.insert(out.end(), message.data.begin(), message.data.end());
+            return;
+        }
+
+        size_t payload_size = out.size() - payload_start;
+        uint8_t size_prefix[max_varint32_length];
+        size_t prefix_length = encode_varint32(size_prefix, static_cast<uint32_t>(payload_size)) - size_prefix;
+        uint8_t *size_position = out.data() + start + 1;
+        std::memmove(size_position + prefix_length, out.data() + payload_start, payload_size);
+        std::memcpy(size_position, size_prefix, prefix_length);
+        out.resize(start + 1 + prefix_length + payload_size);
+    }
+
+    bool expand(const MessageView &message, const CompactLayout &layout, std::vector<uint8_t> &out)
+    {
+        out.clear();
+        const uint8_t *position = message.data;
+        const uint8_t *end = message.data + message.size;
+        switch (message.type)
+        {
+        case MessageType::PlayerMove:
+        {
+            int x;
+            int y;
+            uint32_t count;
+            if (!read_packed(position, end, layout, x, y) || !read_varint32(position, end, count) ||
+                count > static_cast<size_t>(end - position))
+            {
+                return false;
+            }
+            write_to_vector(out, x);
+            write_to_vector(out, y);
+            write_to_vector(out, count);
+
+            // Size once and store in place; the id list is the bulk of every large move
+            size_t ids_offset = out.size();
+            out.resize(ids_offset + count * sizeof(uint32_t));
+            uint8_t *ids = out.data() + ids_offset;
+            uint64_t id = 0;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint32_t delta;
+                if (!read_varint32(position, end, delta))
+                {
+                    return false;
+                }
+                id += delta;
+                if (id > std::numeric_limits<uint32_t>::max())
+                {
+                    return false;
+                }
+                uint32_t value = static_cast<uint32_t>(id);
+                std::memcpy(ids + i * sizeof(uint32_t), &value, sizeof(value));
+            }
+            break;
+        }
+        case MessageType::PlayerBuild:
+        {
+            int x;
+            int y;
+            uint32_t building_type;
+            if (!read_packed(position, end, layout, x, y) || !read_varint32(position, end, building_type))
+            {
+                return false;
+            }
+            write_to_vector(out, x);
+            write_to_vector(out, y);
+            write_to_vector(out, building_type);
+            break;
+        }
+        case MessageType::PlayerAttack:
+        case MessageType::PlayerHarvest:
+        {
+            uint32_t first;
+            uint32_t second;
+            if (!read_varint32(position, end, first) || !read_varint32(position, end, second))
+            {
+                return false;
+            }
+            write_to_vector(out, first);
+            write_to_vector(out, second);
+            break;
+        }
+        default:
+            return false;
+        }
+        return position == end;
+    }
+}
\ No newline at end of file
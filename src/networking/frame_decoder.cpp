@@ -0,0 +1,106 @@
+#include "networking/frame_decoder.hpp"
+#include <algorithm>
+#include <cstring>
+
+FrameDecoder::FrameDecoder(uint8_t *storage, size_t capacity, size_t max_frame_length)
+    : storage_(storage), storage_capacity_(capacity), max_frame_length_(max_frame_length)
+{
+    if (!storage_)
+    {
+        owned_storage_.resize(capacity);
+        storage_ = owned_storage_.data();
+    }
+    buffer_ = storage_;
+    capacity_ = storage_capacity_;
+}
+
+FrameDecoder::Status FrameDecoder::next(MessageView &view)
+{
+    if (read_ == write_)
+    {
+        // Everything consumed: rewind, and leave the overflow buffer if a large frame moved us there
+        read_ = write_ = 0;
+        buffer_ = storage_;
+        capacity_ = storage_capacity_;
+        return Status::NeedMore;
+    }
+
+    size_t available = write_ - read_;
+    if (available < header_length)
+    {
+        make_room(header_length);
+        return Status::NeedMore;
+    }
+
+    const uint8_t *header = buffer_ + read_;
+    uint32_t length = (static_cast<uint32_t>(header[0]) << 24) |
+                      (static_cast<uint32_t>(header[1]) << 16) |
+                      (static_cast<uint32_t>(header[2]) << 8) |
+                      static_cast<uint32_t>(header[3]);
+    if (length > max_frame_length_)
+    {
+        return Status::Oversized;
+    }
+
+    size_t frame_length = header_length + length;
+    if (available < frame_length)
+    {
+        make_room(frame_length);
+        return Status::NeedMore;
+    }
+
+    if (!Message::parse(header + header_length, length, view))
+    {
+        return Status::Malformed;
+    }
+
+    read_ += frame_length;
+    return Status::Frame;
+}
+
+void FrameDecoder::make_room(size_t frame_length)
+{
+    if (frame_length > capacity_)
+    {
+        // Frame can never fit the active buffer; continue it in the (grow-only) overflow buffer
+        size_t available = write_ - read_;
+        if (buffer_ == overflow_.data())
+        {
+            compact();
+            overflow_.resize(frame_length);
+        }
+        else
+        {
+            if (overflow_.size() < frame_length)
+            {
+                overflow_.resize(frame_length);
+            }
+            std::memcpy(overflow_.data(), buffer_ + read_, available);
+            read_ = 0;
+            write_ = available;
+        }
+        buffer_ = overflow_.data();
+        capacity_ = overflow_.size();
+        return;
+    }
+
+    // Move the partial frame to the front when it would not fit the tail, or when the tail is
+    // getting too small to make reads worthwhile
+    if (read_ + frame_length > capacity_ || capacity_ - write_ < capacity_ / 4)
+    {
+        compact();
+    }
+}
+
+void FrameDecoder::compact()
+{
+    if (read_ == 0)
+    {
+        return;
+    }
+
+    size_t available = write_ - read_;
+    std::memmove(buffer_, buffer_ + read_, available);
+    read_ = 0;
+    write_ = available;
+}
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "networking/message.hpp"
+#include "networking/compact_codec.hpp"
+#include "networking/message_payloads.hpp"
 #include <cstring>
 
 namespace
@@ -18,149 +20,122 @@ namespace
         offset += sizeof(T);
         return value;
     }
-
-    void write_string(std::vector<uint8_t> &vec, const std::string &str)
-    {
-        uint32_t length = static_cast<uint32_t>(str.length());
-        write_to_vector(vec, length);
-        vec.insert(vec.end(), str.begin(), str.end());
-    }
-
-    std::string read_string(const std::vector<uint8_t> &vec, size_t &offset)
-    {
-        uint32_t length = read_from_vector<uint32_t>(vec, offset);
-        std::string str(vec.begin() + offset, vec.begin() + offset + length);
-        offset += length;
-        return str;
-    }
 }
 
-Message Message::create_connect(const std::string &player_name)
+// Layouts live in message_payloads.hpp; these keep the established call sites
+Message Message::create_connect(const std::string &player_name, uint32_t offered_capabilities)
 {
-    Message msg;
-    msg.type = MessageType::Connect;
-    write_string(msg.data, player_name);
-    return msg;
+    return message_schema::encode(payload::Connect{player_name, {offered_capabilities}});
 }
 
 Message Message::create_chat(const std::string &text, bool team_only)
 {
-    Message msg;
-    msg.type = MessageType::ChatMessage;
-    write_to_vector(msg.data, team_only);
-    write_string(msg.data, text);
-    return msg;
+    return message_schema::encode(payload::Chat{team_only, text});
+}
+
+Message Message::create_chat_broadcast(uint32_t sender_id, const std::string &text, bool team_only)
+{
+    return message_schema::encode(payload::ChatBroadcast{sender_id, team_only, text});
 }
 
 Message Message::create_move(int x, int y, std::vector<uint32_t> unit_ids)
 {
-    Message msg;
-    msg.type = MessageType::PlayerMove;
-    write_to_vector(msg.data, x);
-    write_to_vector(msg.data, y);
-    uint32_t count = static_cast<uint32_t>(unit_ids.size());
-    write_to_vector(msg.data, count);
-    for (const auto &id : unit_ids)
-    {
-        write_to_vector(msg.data, id);
-    }
-    return msg;
+    return message_schema::encode(payload::Move{x, y, unit_ids});
 }
 
 Message Message::create_build(int x, int y, uint32_t building_type)
 {
-    Message msg;
-    msg.type = MessageType::PlayerBuild;
-    write_to_vector(msg.data, x);
-    write_to_vector(msg.data, y);
-    write_to_vector(msg.data, building_type);
-    return msg;
+    return message_schema::encode(payload::Build{x, y, building_type});
 }
 
 Message Message::create_attack(uint32_t attacker_id, uint32_t target_id)
 {
-    Message msg;
-    msg.type = MessageType::PlayerAttack;
-    write_to_vector(msg.data, attacker_id);
-    write_to_vector(msg.data, target_id);
-    return msg;
+    return message_schema::encode(payload::Attack{attacker_id, target_id});
 }
 
 Message Message::create_harvest(uint32_t unit_id, uint32_t resource_id)
 {
-    Message msg;
-    msg.type = MessageType::PlayerHarvest;
-    write_to_vector(msg.data, unit_id);
-    write_to_vector(msg.data, resource_id);
-    return msg;
+    return message_schema::encode(payload::Harvest{unit_id, resource_id});
 }
 
 Message Message::create_upgrade_request(const std::string &upgrade_name)
 {
-    Message msg;
-    msg.type = MessageType::RequestUpgrade;
-    write_string(msg.data, upgrade_name);
-    return msg;
+    return message_schema::encode(payload::UpgradeRequest{upgrade_name});
 }
 
 Message Message::create_upgrade_response(bool success, const std::string &upgrade_name, int new_level)
 {
-    Message msg;
-    msg.type = MessageType::UpgradeResponse;
-    write_to_vector(msg.data, success);
-    write_string(msg.data, upgrade_name);
-    write_to_vector(msg.data, new_level);
-    return msg;
+    return message_schema::encode(payload::UpgradeResponse{success, upgrade_name, new_level});
 }
 
 Message Message::create_technology_request(const std::string &tech_name)
 {
-    Message msg;
-    msg.type = MessageType::RequestTechnology;
-    write_string(msg.data, tech_name);
-    return msg;
+    return message_schema::encode(payload::TechnologyRequest{tech_name});
 }
 
 Message Message::create_technology_response(bool success, const std::string &tech_name)
 {
-    Message msg;
-    msg.type = MessageType::TechnologyResponse;
-    write_to_vector(msg.data, success);
-    write_string(msg.data, tech_name);
-    return msg;
+    return message_schema::encode(payload::TechnologyResponse{success, tech_name});
 }
 
 Message Message::create_upgrade_list_request()
 {
-    Message msg;
-    msg.type = MessageType::UpgradeListRequest;
-    return msg;
+    return message_schema::encode(payload::UpgradeListRequest{});
 }
 
 Message Message::create_upgrade_list_response(
     const std::vector<std::string> &available_upgrades,
     const std::vector<std::string> &available_technologies)
 {
-    Message msg;
-    msg.type = MessageType::UpgradeListResponse;
+    return message_schema::encode(payload::UpgradeListResponse{available_upgrades, available_technologies});
+}
 
-    // Write upgrades
-    uint32_t upgrade_count = static_cast<uint32_t>(available_upgrades.size());
-    write_to_vector(msg.data, upgrade_count);
-    for (const auto &upgrade : available_upgrades)
-    {
-        write_string(msg.data, upgrade);
-    }
+Message Message::create_upgrade_request(NameID upgrade_id)
+{
+    return message_schema::encode(payload::InternedUpgradeRequest{upgrade_id});
+}
 
-    // Write technologies
-    uint32_t tech_count = static_cast<uint32_t>(available_technologies.size());
-    write_to_vector(msg.data, tech_count);
-    for (const auto &tech : available_technologies)
-    {
-        write_string(msg.data, tech);
-    }
+Message Message::create_upgrade_response(bool success, NameID upgrade_id, int new_level)
+{
+    return message_schema::encode(payload::InternedUpgradeResponse{success, upgrade_id, new_level});
+}
 
-    return msg;
+Message Message::create_technology_request(NameID tech_id)
+{
+    return message_schema::encode(payload::InternedTechnologyRequest{tech_id});
+}
+
+Message Message::create_technology_response(bool success, NameID tech_id)
+{
+    return message_schema::encode(payload::InternedTechnologyResponse{success, tech_id});
+}
+
+Message Message::create_upgrade_list_response(const std::vector<NameID> &available_upgrades,
+                                              const std::vector<NameID> &available_technologies)
+{
+    return message_schema::encode(payload::InternedUpgradeListResponse{available_upgrades, available_technologies});
+}
+
+Message Message::create_name_dictionary(const NameTable &upgrades, const NameTable &technologies,
+                                        const NameTable &resources)
+{
+    return message_schema::encode(payload::NameDictionary{upgrades.get_names(), technologies.get_names(),
+                                                          resources.get_names()});
+}
+
+Message Message::create_snapshot_ack(uint32_t sequence)
+{
+    return message_schema::encode(payload::SnapshotAck{sequence});
+}
+
+Message Message::create_camera_update(int x, int y, int width, int height)
+{
+    return message_schema::encode(payload::CameraUpdate{x, y, width, height});
+}
+
+Message Message::create_state_hash(uint32_t turn, uint64_t checksum)
+{
+    return message_schema::encode(payload::StateHash{turn, checksum});
 }
 
 std::vector<uint8_t> Message::serialize() const
@@ -173,6 +148,11 @@ std::vector<uint8_t> Message::serialize() const
     return result;
 }
 
+SharedPayload Message::serialize_shared() const
+{
+    return std::make_shared<const std::vector<uint8_t>>(serialize());
+}
+
 Message Message::deserialize(const std::vector<uint8_t> &data)
 {
     Message msg;
@@ -181,4 +161,55 @@ Message Message::deserialize(const std::vector<uint8_t> &data)
     uint32_t size = read_from_vector<uint32_t>(data, offset);
     msg.data.assign(data.begin() + offset, data.begin() + offset + size);
     return msg;
+}
+
+bool Message::parse(const uint8_t *buffer, size_t length, MessageView &view)
+{
+    if (length < sizeof(MessageType))
+    {
+        return false;
+    }
+
+    const uint8_t *position = buffer + sizeof(MessageType);
+    const uint8_t *end = buffer + length;
+    uint8_t type = buffer[0];
+    uint64_t size;
+    if (type & message_flags::compact)
+    {
+        if (!compact_codec::read_varint(position, end, size))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        uint32_t fixed_size;
+        if (static_cast<size_t>(end - position) < sizeof(fixed_size))
+        {
+            return false;
+        }
+        std::memcpy(&fixed_size, position, sizeof(fixed_size));
+        position += sizeof(fixed_size);
+        size = fixed_size;
+    }
+    if (size > static_cast<size_t>(end - position))
+    {
+        return false;
+    }
+
+    view.type = static_cast<MessageType>(type & ~message_flags::all);
+    view.compact = (type & message_flags::compact) != 0;
+    view.compressed = (type & message_flags::compressed) != 0;
+    view.data = position;
+    view.size = size;
+    return true;
+}
+
+Message MessageView::to_message() const
+{
+    Message msg;
+    msg.type = type;
+    msg.data.assign(data, data + size);
+    msg.player_id = player_id;
+    return msg;
 }
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "networking/message_dispatcher.hpp"
+#include "networking/client_connection.hpp"
+
+MessageDispatcher::Result MessageDispatcher::dispatch(ClientConnection &connection, const MessageView &message) const
+{
+    size_t index = static_cast<size_t>(message.type);
+    if (index >= message_type_count)
+    {
+        return Result::Unregistered;
+    }
+
+    const Entry *entry = &standard_[index];
+    if ((connection.get_capabilities() & capabilities::interned_names) && interned_[index].thunk)
+    {
+        entry = &interned_[index];
+    }
+    if (!entry->thunk)
+    {
+        return Result::Unregistered;
+    }
+    if (entry->access == Access::Authenticated && !connection.is_authenticated())
+    {
+        return Result::Unauthenticated;
+    }
+    return entry->thunk(entry->target, connection, message) ? Result::Handled : Result::Malformed;
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "networking/payload_compressor.hpp"
+#include "networking/compact_codec.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // Raw deflate (no zlib header or checksum; TCP already covers corruption) with the full window
+    constexpr int window_bits = -15;
+    constexpr int memory_level = 8;
+
+    constexpr size_t max_header_length = 1 + 5;
+    constexpr uint8_t sync_flush_tail[] = {0x00, 0x00, 0xff, 0xff};
+}
+
+PayloadCompressor::PayloadCompressor(int level)
+{
+    initialized_ = deflateInit2(&stream_, level, Z_DEFLATED, window_bits, memory_level, Z_DEFAULT_STRATEGY) == Z_OK;
+    ready_ = initialized_;
+}
+
+PayloadCompressor::~PayloadCompressor()
+{
+    if (initialized_)
+    {
+        deflateEnd(&stream_);
+    }
+}
+
+bool PayloadCompressor::compress(const MessageView &message, std::vector<uint8_t> &out)
+{
+    if (!ready_)
+    {
+        return false;
+    }
+
+    // Leave room for the longest header, deflate after it, then write the size and close the gap
+    size_t start = out.size();
+    size_t payload_start = start + max_header_length;
+    out.resize(payload_start + deflateBound(&stream_, message.size) + sizeof(sync_flush_tail));
+
+    stream_.next_in = const_cast<Bytef *>(message.data);
+    stream_.avail_in = static_cast<uInt>(message.size);
+    size_t written = payload_start;
+    do
+    {
+        if (written == out.size())
+        {
+            out.resize(out.size() * 2);
+        }
+        stream_.next_out = out.data() + written;
+        stream_.avail_out = static_cast<uInt>(out.size() - written);
+        int result = deflate(&stream_, Z_SYNC_FLUSH);
+        written = out.size() - stream_.avail_out;
+        if (result != Z_OK && result != Z_BUF_ERROR)
+        {
+            ready_ = false;
+            return false;
+        }
+    } while (stream_.avail_out == 0);
+
+    // Every flush ends in the same empty stored block; the decompressor puts it back
+    if (written - payload_start < sizeof(sync_flush_tail) ||
+        std::memcmp(out.data() + written - sizeof(sync_flush_tail), sync_flush_tail, sizeof(sync_flush_tail)) != 0)
+    {
+        ready_ = false;
+        return false;
+    }
+    size_t payload_size = written - sizeof(sync_flush_tail) - payload_start;
+
+    std::vector<uint8_t> header;
+    header.push_back(static_cast<uint8_t>(message.type) | message_flags::compressed |
+                     (message.compact ? message_flags::compact : 0));
+    if (message.compact)
+    {
+        compact_codec::write_varint(header, payload_size);
+    }
+    else
+    {
+        uint32_t size = static_cast<uint32_t>(payload_size);
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&size);
+        header.insert(header.end(), bytes, bytes + sizeof(size));
+    }
+
+    uint8_t *header_position = out.data() + start;
+    std::memmove(header_position + header.size(), out.data() + payload_start, payload_size);
+    std::memcpy(header_position, header.data(), header.size());
+    out.resize(start + header.size() + payload_size);
+    return true;
+}
+
+PayloadDecompressor::PayloadDecompressor()
+{
+    initialized_ = inflateInit2(&stream_, window_bits) == Z_OK;
+    ready_ = initialized_;
+}
+
+PayloadDecompressor::~PayloadDecompressor()
+{
+    if (initialized_)
+    {
+        inflateEnd(&stream_);
+    }
+}
+
+bool PayloadDecompressor::decompress(const uint8_t *data, size_t size, size_t max_size, std::vector<uint8_t> &out)
+{
+    out.clear();
+    if (!ready_ || !inflate_into(data, size, max_size, out) ||
+        !inflate_into(sync_flush_tail, sizeof(sync_flush_tail), max_size, out))
+    {
+        // A bad chunk leaves the window out of step with the sender; nothing after it can decode
+        ready_ = false;
+        return false;
+    }
+    return true;
+}
+
+bool PayloadDecompressor::inflate_into(const uint8_t *data, size_t size, size_t max_size, std::vector<uint8_t> &out)
+{
+    stream_.next_in = const_cast<Bytef *>(data);
+    stream_.avail_in = static_cast<uInt>(size);
+    size_t written = out.size();
+    do
+    {
+        if (written == out.size())
+        {
+            if (out.size() >= max_size)
+            {
+                return inflate_finished();
+            }
+            out.resize(std::min(max_size, std::max<size_t>(out.size() * 2, std::max<size_t>(size * 4, 4096))));
+        }
+        stream_.next_out = out.data() + written;
+        stream_.avail_out = static_cast<uInt>(out.size() - written);
+        int result = inflate(&stream_, Z_SYNC_FLUSH);
+        written = out.size() - stream_.avail_out;
+        if (result == Z_BUF_ERROR && stream_.avail_in > 0 && stream_.avail_out > 0)
+        {
+            return false;
+        }
+        if (result != Z_OK && result != Z_BUF_ERROR)
+        {
+            return false; // Includes Z_STREAM_END: the stream never finishes while the connection is up
+        }
+    } while (stream_.avail_in > 0 || stream_.avail_out == 0);
+
+    out.resize(written);
+    return true;
+}
+
+bool PayloadDecompressor::inflate_finished()
+{
+    // The output is full at the limit; that is fine if the rest of the input inflates to nothing
+    uint8_t probe;
+    stream_.next_out = &probe;
+    stream_.avail_out = 1;
+    int result = inflate(&stream_, Z_SYNC_FLUSH);
+    return (result == Z_OK || result == Z_BUF_ERROR) && stream_.avail_out == 1 && stream_.avail_in == 0;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "networking/rate_limiter.hpp"
+#include <algorithm>
+
+RateLimits RateLimits::defaults()
+{
+    RateLimits limits;
+    limits.connection = {200, 400};
+    limits[MessageType::Connect] = {1, 3};
+    limits[MessageType::ChatMessage] = {2, 5};
+    limits[MessageType::PlayerMove] = {20, 40};
+    limits[MessageType::PlayerBuild] = {10, 20};
+    limits[MessageType::PlayerAttack] = {20, 40};
+    limits[MessageType::PlayerHarvest] = {20, 40};
+    limits[MessageType::RequestUpgrade] = {10, 20};
+    limits[MessageType::RequestTechnology] = {10, 20};
+    limits[MessageType::UpgradeListRequest] = {5, 10};
+    limits[MessageType::CameraUpdate] = {30, 60};
+    limits[MessageType::StateHash] = {60, 120}; // One a turn, with room for faster tick rates
+    return limits;
+}
+
+void TokenBucket::configure(const RateLimit &limit, Clock::time_point now)
+{
+    limit_ = limit;
+    tokens_ = std::max(limit.burst, 1.0);
+    last_refill_ = now;
+}
+
+bool TokenBucket::available(Clock::time_point now)
+{
+    if (!limited())
+    {
+        return true;
+    }
+
+    double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    if (elapsed > 0)
+    {
+        tokens_ = std::min(std::max(limit_.burst, 1.0), tokens_ + elapsed * limit_.rate);
+        last_refill_ = now;
+    }
+    return tokens_ >= 1;
+}
+
+TokenBucket::Clock::duration TokenBucket::time_until_available() const
+{
+    if (!limited() || tokens_ >= 1)
+    {
+        return Clock::duration::zero();
+    }
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((1 - tokens_) / limit_.rate));
+}
+
+void RateLimiter::configure(const RateLimits &limits, Clock::time_point now)
+{
+    connection_.configure(limits.connection, now);
+    enabled_ = connection_.limited();
+    for (size_t i = 0; i < per_type_.size(); ++i)
+    {
+        per_type_[i].configure(limits.per_type[i], now);
+        enabled_ = enabled_ || per_type_[i].limited();
+    }
+}
+
+bool RateLimiter::allow(MessageType type, Clock::time_point now)
+{
+    size_t index = static_cast<size_t>(type);
+    TokenBucket *type_bucket = index < per_type_.size() ? &per_type_[index] : nullptr;
+    if (!connection_.available(now) || (type_bucket && !type_bucket->available(now)))
+    {
+        return false;
+    }
+
+    if (connection_.limited())
+    {
+        connection_.take();
+    }
+    if (type_bucket && type_bucket->limited())
+    {
+        type_bucket->take();
+    }
+    return true;
+}
+
+RateLimiter::Clock::duration RateLimiter::time_until_allowed(MessageType type) const
+{
+    size_t index = static_cast<size_t>(type);
+    Clock::duration wait = connection_.time_until_available();
+    if (index < per_type_.size())
+    {
+        wait = std::max(wait, per_type_[index].time_until_available());
+    }
+    return wait;
+}
\ No newline at end of file
@@ -1,20 +1,37 @@
 #include "server/castle_server.hpp"
-#include "server/player_manager.hpp"
 #include "networking/client_connection.hpp"
-#include "networking/message_utils.hpp"
+#include "upgrades/upgrade_manager.hpp"
 #include <iostream>
 
-using namespace message_utils;
+namespace
+{
+    // Receive blocks cover every regular command; larger frames use per-connection overflow
+    constexpr size_t receive_block_size = 16 * 1024;
+    constexpr size_t receive_block_count = 256;
+
+    using reuse_port_option = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+}
 
-CastleServer::CastleServer(boost::asio::io_context &io_context, unsigned short port)
-    : io_context_(io_context), acceptor_(io_context, tcp::endpoint(tcp::v4(), port))
+CastleServer::CastleServer(boost::asio::io_context &io_context, boost::asio::io_context &room_context,
+                           unsigned short port, bool reuse_port)
+    : io_context_(io_context), port_(port), reuse_port_(reuse_port)
 {
-    game_state_ = std::make_unique<GameState>();
-    player_manager_ = std::make_unique<PlayerManager>();
-    map_ = std::make_unique<Map>(100, 100, 32); // Default 100x100 map with 32px tiles
-    resource_manager_ = std::make_unique<ResourceManager>();
-    chat_handler_ = std::make_unique<ChatHandler>();
-    timer_ = std::make_unique<Timer>();
+    acceptors_.push_back(open_acceptor(io_context));
+
+    room_manager_ = std::make_unique<RoomManager>(room_context);
+    receive_pool_ = std::make_shared<BufferPool>(receive_block_size, receive_block_count);
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    receive_pool_->register_blocks(io_context);
+#endif
+
+    // Built once; every room has the same tables, so every connection that negotiates interned
+    // names gets the same payload
+    UpgradeManager upgrade_manager;
+    ResourceManager resource_manager;
+    name_dictionary_ = Message::create_name_dictionary(upgrade_manager.get_upgrade_names(),
+                                                       upgrade_manager.get_technology_names(),
+                                                       resource_manager.get_resource_names())
+                           .serialize_shared();
 }
 
 CastleServer::~CastleServer()
@@ -22,12 +39,47 @@ CastleServer::~CastleServer()
     stop();
 }
 
+std::unique_ptr<tcp::acceptor> CastleServer::open_acceptor(boost::asio::io_context &io_context)
+{
+    tcp::endpoint endpoint(tcp::v4(), port_);
+    auto acceptor = std::make_unique<tcp::acceptor>(io_context);
+    acceptor->open(endpoint.protocol());
+    acceptor->set_option(tcp::acceptor::reuse_address(true));
+    if (reuse_port_)
+    {
+        acceptor->set_option(reuse_port_option(true));
+    }
+    acceptor->bind(endpoint);
+    acceptor->listen();
+    return acceptor;
+}
+
+void CastleServer::add_listener(boost::asio::io_context &io_context)
+{
+    if (!reuse_port_)
+    {
+        throw std::logic_error("add_listener requires a server created with reuse_port");
+    }
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    receive_pool_->register_blocks(io_context);
+#endif
+    acceptors_.push_back(open_acceptor(io_context));
+    if (running_)
+    {
+        accept_connections(*acceptors_.back());
+    }
+}
+
 void CastleServer::start()
 {
     if (!running_)
     {
         running_ = true;
-        accept_connections();
+        for (auto &acceptor : acceptors_)
+        {
+            accept_connections(*acceptor);
+        }
     }
 }
 
@@ -36,36 +88,43 @@ void CastleServer::stop()
     if (running_)
     {
         running_ = false;
-        acceptor_.close();
+        room_manager_->clear();
+        for (auto &acceptor : acceptors_)
+        {
+            boost::system::error_code ec;
+            acceptor->close(ec);
+        }
 
-        for (auto &client : clients_)
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        for (auto &client : connections_)
         {
             if (client)
             {
                 client->stop();
             }
         }
-        clients_.clear();
+        connections_.clear();
     }
 }
 
-void CastleServer::accept_connections()
+void CastleServer::accept_connections(tcp::acceptor &acceptor)
 {
-    acceptor_.async_accept(
-        [this](std::error_code ec, tcp::socket socket)
+    // Each connection gets its own strand, so its handlers never run concurrently even when
+    // several threads share one io_context. With one io_context per thread the strand is
+    // uncontended and the connection simply stays on the thread that accepted it.
+    boost::asio::any_io_executor executor = boost::asio::make_strand(acceptor.get_executor());
+    acceptor.async_accept(
+        executor,
+        [this, &acceptor](std::error_code ec, tcp::socket socket)
         {
             if (!ec)
             {
-                auto connection = handle_client(std::move(socket));
-                if (connection)
-                {
-                    clients_.push_back(connection);
-                }
+                handle_client(std::move(socket));
             }
 
             if (running_)
             {
-                accept_connections();
+                accept_connections(acceptor);
             }
         });
 }
@@ -74,9 +133,55 @@ std::shared_ptr<ClientConnection> CastleServer::handle_client(tcp::socket socket
 {
     try
     {
-        auto client = std::make_shared<ClientConnection>(
-            std::move(socket),
-            player_manager_->generate_next_player_id());
+        // Game traffic is small latency-sensitive frames; don't let Nagle hold them back
+        socket.set_option(tcp::no_delay(true));
+
+        // Reserve the slot first; its handle becomes the player id the connection is built with
+        PlayerID player_id;
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            player_id = connections_.insert(nullptr);
+        }
+        if (player_id == SlotMap<std::shared_ptr<ClientConnection>>::invalid_handle)
+        {
+            std::cerr << "Connection limit reached, refusing client" << std::endl;
+            return nullptr;
+        }
+
+        std::shared_ptr<ClientConnection> client;
+        try
+        {
+            client = std::make_shared<ClientConnection>(std::move(socket), player_id, receive_pool_);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            connections_.remove(player_id);
+            throw;
+        }
+
+        client->set_name_dictionary(name_dictionary_);
+        client->set_write_queue_limits(write_queue_limits_);
+        client->set_rate_limits(rate_limits_);
+        client->set_disconnect_handler([this](PlayerID closed_id)
+                                       {
+                                           // May run inside a fan-out that holds clients_mutex_
+                                           boost::asio::post(io_context_, [this, closed_id]()
+                                                             { remove_connection(closed_id); });
+                                       });
+
+        // The room's ticks send to the connection from here on, so it has to be set up first
+        if (!room_manager_->assign(client))
+        {
+            std::cerr << "Every room is full, refusing client" << std::endl;
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            connections_.remove(player_id);
+            return nullptr;
+        }
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            *connections_.get(player_id) = client;
+        }
         client->start();
         return client;
     }
@@ -87,65 +192,33 @@ std::shared_ptr<ClientConnection> CastleServer::handle_client(tcp::socket socket
     }
 }
 
-void CastleServer::handle_upgrade_request(PlayerID player_id, const Message &message)
-{
-    size_t offset = 0;
-    std::string upgrade_name = message_utils::read_string(message.data, offset);
-
-    auto &upgrade_manager = game_state_->get_upgrade_manager();
-    bool success = upgrade_manager.purchase_upgrade(player_id, upgrade_name);
-    int new_level = upgrade_manager.get_upgrade_level(player_id, upgrade_name);
-
-    send_upgrade_response(player_id, success, upgrade_name, new_level);
-}
-
-void CastleServer::handle_technology_request(PlayerID player_id, const Message &message)
-{
-    size_t offset = 0;
-    std::string tech_name = message_utils::read_string(message.data, offset);
-
-    auto &upgrade_manager = game_state_->get_upgrade_manager();
-    bool success = upgrade_manager.unlock_technology(player_id, tech_name);
-
-    send_technology_response(player_id, success, tech_name);
-}
-
-void CastleServer::handle_upgrade_list_request(PlayerID player_id)
+size_t CastleServer::get_connection_count()
 {
-    auto &upgrade_manager = game_state_->get_upgrade_manager();
-    auto available_upgrades = upgrade_manager.get_available_upgrades(player_id);
-    auto available_technologies = upgrade_manager.get_available_technologies(player_id);
-
-    Message response = Message::create_upgrade_list_response(
-        available_upgrades, available_technologies);
-
-    auto connection_it = connections_.find(player_id);
-    if (connection_it != connections_.end())
-    {
-        connection_it->second->send_message(response);
-    }
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    return connections_.size();
 }
 
-void CastleServer::send_upgrade_response(PlayerID player_id, bool success,
-                                         const std::string &upgrade_name, int new_level)
+void CastleServer::remove_connection(PlayerID player_id)
 {
-    Message response = Message::create_upgrade_response(success, upgrade_name, new_level);
-
-    auto connection_it = connections_.find(player_id);
-    if (connection_it != connections_.end())
     {
-        connection_it->second->send_message(response);
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        if (!connections_.remove(player_id))
+        {
+            return;
+        }
     }
+    room_manager_->remove_player(player_id);
 }
 
-void CastleServer::send_technology_response(PlayerID player_id, bool success,
-                                            const std::string &tech_name)
+void CastleServer::broadcast(const Message &message)
 {
-    Message response = Message::create_technology_response(success, tech_name);
-
-    auto connection_it = connections_.find(player_id);
-    if (connection_it != connections_.end())
+    SharedPayload payload = message.serialize_shared();
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (auto &client : connections_)
     {
-        connection_it->second->send_message(response);
+        if (client && client->is_connected())
+        {
+            client->send_payload(payload);
+        }
     }
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "server/chat_handler.hpp"
+#include "utils/memory_usage.hpp"
 #include <chrono>
 #include <algorithm>
 
@@ -66,4 +67,14 @@ void ChatHandler::unmute_player(PlayerID player_id)
     {
         muted_players_.erase(it);
     }
+}
+
+size_t ChatHandler::get_memory_usage() const
+{
+    size_t bytes = memory_usage::of(message_history_) + memory_usage::of(muted_players_);
+    for (const auto &message : message_history_)
+    {
+        bytes += memory_usage::of(message.message);
+    }
+    return bytes;
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "server/command_queue.hpp"
+#include <algorithm>
+
+namespace
+{
+    size_t round_up_to_power_of_two(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+}
+
+CommandQueue::CommandQueue(size_t capacity)
+    : slots_(round_up_to_power_of_two(std::max<size_t>(capacity, 2))),
+      mask_(slots_.size() - 1)
+{
+    for (size_t i = 0; i < slots_.size(); ++i)
+    {
+        slots_[i].ready.store(i, std::memory_order_relaxed);
+    }
+}
+
+size_t CommandQueue::get_size() const
+{
+    std::uint64_t enqueued = enqueue_position_.load(std::memory_order_relaxed);
+    std::uint64_t dequeued = dequeue_published_.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? static_cast<size_t>(enqueued - dequeued) : 0;
+}
+
+CommandQueueStats CommandQueue::get_stats() const
+{
+    CommandQueueStats stats;
+    stats.pushed = pushed_.load(std::memory_order_relaxed);
+    stats.rejected_full = rejected_full_.load(std::memory_order_relaxed);
+    stats.drains = drains_.load(std::memory_order_relaxed);
+    stats.drained = dequeue_published_.load(std::memory_order_relaxed);
+    stats.last_drain_count = last_drain_count_.load(std::memory_order_relaxed);
+    stats.max_drain_count = max_drain_count_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void CommandQueue::record_drain(size_t count)
+{
+    // Only the simulation thread writes these; readers on other threads just need whole values
+    dequeue_published_.store(dequeue_position_, std::memory_order_relaxed);
+    drains_.store(drains_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    last_drain_count_.store(count, std::memory_order_relaxed);
+    if (count > max_drain_count_.load(std::memory_order_relaxed))
+    {
+        max_drain_count_.store(count, std::memory_order_relaxed);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "server/game_loop.hpp"
+#include <algorithm>
+
+GameLoop::GameLoop(boost::asio::io_context &io_context, TickHandler on_tick)
+    : strand_(boost::asio::make_strand(io_context)), timer_(strand_), on_tick_(std::move(on_tick))
+{
+}
+
+void GameLoop::set_tick_rate(unsigned ticks_per_second)
+{
+    tick_rate_ = std::max(ticks_per_second, 1u);
+}
+
+void GameLoop::set_game_speed(float speed)
+{
+    game_speed_ = std::max(speed, 0.0f);
+}
+
+void GameLoopStats::merge(const GameLoopStats &other)
+{
+    ticks += other.ticks;
+    late_ticks += other.late_ticks;
+    skipped_ticks += other.skipped_ticks;
+    over_budget += other.over_budget;
+    total_tick_time += other.total_tick_time;
+    max_tick_time = std::max(max_tick_time, other.max_tick_time);
+}
+
+void GameLoop::start(float phase)
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+    auto delay = std::chrono::duration_cast<Clock::duration>(period() * std::clamp(phase, 0.0f, 1.0f));
+    boost::asio::dispatch(strand_, [self = shared_from_this(), delay]()
+                          {
+                              self->next_tick_ = Clock::now() + self->period() + delay;
+                              self->schedule();
+                          });
+}
+
+void GameLoop::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    boost::asio::dispatch(strand_, [self = shared_from_this()]()
+                          { self->timer_.cancel(); });
+}
+
+GameLoopStats GameLoop::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+GameLoop::Clock::duration GameLoop::period() const
+{
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / tick_rate_.load();
+}
+
+void GameLoop::schedule()
+{
+    timer_.expires_at(next_tick_);
+    timer_.async_wait([self = shared_from_this()](const boost::system::error_code &ec)
+                      { self->on_timer(ec); });
+}
+
+void GameLoop::on_timer(const boost::system::error_code &ec)
+{
+    if (ec == boost::asio::error::operation_aborted || !running_)
+    {
+        return;
+    }
+
+    // Every tick advances the game by the same step, however late it runs
+    Clock::duration step = period();
+    float delta_time = std::chrono::duration<float>(step).count() * game_speed_;
+    unsigned max_ticks = max_catch_up_ + 1;
+    unsigned ran = 0;
+    while (running_ && ran < max_ticks && next_tick_ <= Clock::now())
+    {
+        auto start_time = Clock::now();
+        on_tick_(delta_time);
+        auto tick_time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time);
+        next_tick_ += step;
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.ticks;
+        stats_.late_ticks += ran > 0 ? 1 : 0;
+        stats_.over_budget += tick_time > step ? 1 : 0;
+        stats_.total_tick_time += tick_time;
+        stats_.max_tick_time = std::max(stats_.max_tick_time, tick_time);
+        ++ran;
+    }
+
+    // Too far behind to catch up: drop the missed ticks and carry on from now
+    auto now = Clock::now();
+    if (next_tick_ <= now)
+    {
+        auto missed = (now - next_tick_) / step + 1;
+        next_tick_ += missed * step;
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.skipped_ticks += static_cast<std::uint64_t>(missed);
+    }
+
+    if (running_)
+    {
+        schedule();
+    }
+}
\ No newline at end of file
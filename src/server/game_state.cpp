@@ -1,6 +1,17 @@
 #include "server/game_state.hpp"
 #include "server/player_manager.hpp"
 #include "upgrades/upgrade_manager.hpp"
+#include "utils/memory_usage.hpp"
+
+namespace
+{
+    // One multiply-rotate round per field, as in xxHash
+    void mix(std::uint64_t &hash, std::uint32_t value)
+    {
+        hash ^= value * 0x9e3779b97f4a7c15ull;
+        hash = (hash << 31 | hash >> 33) * 0xc2b2ae3d27d4eb4full;
+    }
+}
 
 GameState::GameState()
     : player_manager_(std::make_unique<PlayerManager>()),
@@ -31,8 +42,96 @@ void GameState::update_player_score(PlayerID player_id, int score)
     player_scores_[player_id] = score;
 }
 
+UnitID GameState::spawn_unit(PlayerID owner, UnitType type, int x, int y, int health)
+{
+    UnitStore::Handle handle = units_.spawn(type, owner, x, y);
+    if (handle == UnitStore::invalid_handle)
+    {
+        return 0;
+    }
+    units_.get(handle).set_health(health);
+    UnitID id = next_unit_id_++;
+    unit_handles_[id] = handle;
+    return id;
+}
+
+bool GameState::restore_unit(const UnitState &unit)
+{
+    remove_unit(unit.id);
+    UnitStore::Handle handle = units_.spawn(unit.type, unit.owner, unit.x, unit.y);
+    if (handle == UnitStore::invalid_handle)
+    {
+        return false;
+    }
+    units_.get(handle).set_health(unit.health);
+    unit_handles_[unit.id] = handle;
+    return true;
+}
+
+void GameState::remove_unit(UnitID id)
+{
+    auto it = unit_handles_.find(id);
+    if (it != unit_handles_.end())
+    {
+        units_.remove(it->second);
+        unit_handles_.erase(it);
+    }
+}
+
+UnitRef GameState::get_unit(UnitID id)
+{
+    auto it = unit_handles_.find(id);
+    return units_.get(it != unit_handles_.end() ? it->second : UnitStore::invalid_handle);
+}
+
+bool GameState::get_unit_state(UnitID id, UnitState &unit) const
+{
+    auto it = unit_handles_.find(id);
+    if (it == unit_handles_.end())
+    {
+        return false;
+    }
+    unit = unit_state(id, units_.index_of(it->second));
+    return true;
+}
+
+UnitState GameState::unit_state(UnitID id, size_t index) const
+{
+    return UnitState{id, units_.get_owners()[index], units_.get_types()[index], units_.get_x()[index],
+                     units_.get_y()[index], units_.get_health()[index]};
+}
+
 int GameState::get_player_score(PlayerID player_id) const
 {
     auto it = player_scores_.find(player_id);
     return it != player_scores_.end() ? it->second : 0;
+}
+
+size_t GameState::get_memory_usage() const
+{
+    return units_.get_memory_usage() + memory_usage::of(unit_handles_) + memory_usage::of(player_scores_) + upgrade_manager_->get_memory_usage();
+}
+
+std::uint64_t GameState::checksum() const
+{
+    std::uint64_t hash = 0x27d4eb2f165667c5ull;
+    mix(hash, turn_);
+    mix(hash, next_unit_id_);
+    mix(hash, static_cast<std::uint32_t>(unit_handles_.size()));
+    for_each_unit([&hash](const UnitState &unit)
+                  {
+                      mix(hash, unit.id);
+                      mix(hash, unit.owner);
+                      mix(hash, static_cast<std::uint32_t>(unit.type));
+                      mix(hash, static_cast<std::uint32_t>(unit.x));
+                      mix(hash, static_cast<std::uint32_t>(unit.y));
+                      mix(hash, static_cast<std::uint32_t>(unit.health));
+                  });
+    mix(hash, static_cast<std::uint32_t>(player_scores_.size()));
+    for (const auto &[player_id, score] : player_scores_)
+    {
+        mix(hash, player_id);
+        mix(hash, static_cast<std::uint32_t>(score));
+    }
+    return hash ^ (hash >> 29);
 }
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "server/interest_grid.hpp"
+#include "utils/memory_usage.hpp"
+#include <algorithm>
+
+InterestGrid::InterestGrid(const Map &map, int cell_size, int vision_range)
+    : cell_size_(std::max(cell_size, 1)), vision_range_(std::max(vision_range, 0))
+{
+    columns_ = std::max((map.get_width() + cell_size_ - 1) / cell_size_, 1);
+    rows_ = std::max((map.get_height() + cell_size_ - 1) / cell_size_, 1);
+    cell_starts_.resize(static_cast<size_t>(columns_) * rows_ + 1);
+    cell_marks_.resize(static_cast<size_t>(columns_) * rows_);
+    cell_owners_.resize(static_cast<size_t>(columns_) * rows_);
+}
+
+void InterestGrid::rebuild(const std::vector<UnitState> &units)
+{
+    units_ = &units;
+    for (auto &[owner, cells] : owned_cells_)
+    {
+        cells.clear();
+    }
+
+    // Counting sort by cell; each cell keeps its units in id order
+    std::fill(cell_starts_.begin(), cell_starts_.end(), 0);
+    unit_cells_.resize(units.size());
+    for (size_t i = 0; i < units.size(); ++i)
+    {
+        const UnitState &unit = units[i];
+        unit_cells_[i] = static_cast<uint32_t>(row_of(unit.y) * columns_ + column_of(unit.x));
+        ++cell_starts_[unit_cells_[i] + 1];
+    }
+    for (size_t c = 1; c < cell_starts_.size(); ++c)
+    {
+        cell_starts_[c] += cell_starts_[c - 1];
+    }
+    cell_units_.resize(units.size());
+    unit_marks_.assign(units.size(), 0);
+    std::vector<uint32_t> &next = gathered_; // Scratch: next free position in each cell
+    next.assign(cell_starts_.begin(), cell_starts_.end() - 1);
+
+    // Vision is worked out per occupied cell rather than per unit, so a crowd costs one cell. A
+    // cell is listed again only when another owner's unit came between, which is harmless.
+    std::fill(cell_owners_.begin(), cell_owners_.end(), 0);
+    std::vector<uint32_t> *owner_cells = nullptr;
+    PlayerID owner = 0;
+    for (uint32_t i = 0; i < units.size(); ++i)
+    {
+        uint32_t cell = unit_cells_[i];
+        cell_units_[next[cell]++] = i;
+        if (cell_owners_[cell] == units[i].owner)
+        {
+            continue;
+        }
+        cell_owners_[cell] = units[i].owner;
+        if (!owner_cells || units[i].owner != owner)
+        {
+            owner = units[i].owner;
+            owner_cells = &owned_cells_[owner];
+        }
+        owner_cells->push_back(cell);
+    }
+
+    // Drop owners whose last unit is gone
+    for (auto it = owned_cells_.begin(); it != owned_cells_.end();)
+    {
+        it = it->second.empty() ? owned_cells_.erase(it) : std::next(it);
+    }
+}
+
+void InterestGrid::visible_units(PlayerID player_id, std::vector<UnitID> &visible)
+{
+    visible.clear();
+    if (!units_)
+    {
+        return;
+    }
+
+    if (++stamp_ == 0)
+    {
+        std::fill(cell_marks_.begin(), cell_marks_.end(), 0);
+        std::fill(unit_marks_.begin(), unit_marks_.end(), 0);
+        stamp_ = 1;
+    }
+    marked_cells_.clear();
+
+    // Everything within vision_range of any tile of a cell holding one of the client's units
+    auto owned = owned_cells_.find(player_id);
+    if (owned != owned_cells_.end())
+    {
+        for (uint32_t cell : owned->second)
+        {
+            int64_t x = static_cast<int64_t>(cell % columns_) * cell_size_;
+            int64_t y = static_cast<int64_t>(cell / columns_) * cell_size_;
+            mark_cells(x - vision_range_, y - vision_range_, x + cell_size_ - 1 + vision_range_,
+                       y + cell_size_ - 1 + vision_range_);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cameras_mutex_);
+        auto camera = cameras_.find(player_id);
+        if (camera != cameras_.end() && camera->second.width > 0 && camera->second.height > 0)
+        {
+            const CameraRect &rect = camera->second;
+            mark_cells(rect.x, rect.y, int64_t{rect.x} + rect.width - 1, int64_t{rect.y} + rect.height - 1);
+        }
+    }
+
+    // Units are ordered by id, so ordering indices orders ids. Sorting costs n log n in the units
+    // gathered; once they are a good part of the world one pass over per-unit marks is cheaper.
+    size_t gathered_count = 0;
+    for (uint32_t cell : marked_cells_)
+    {
+        gathered_count += cell_starts_[cell + 1] - cell_starts_[cell];
+    }
+    if (gathered_count * 8 < units_->size())
+    {
+        gathered_.clear();
+        for (uint32_t cell : marked_cells_)
+        {
+            gathered_.insert(gathered_.end(), cell_units_.begin() + cell_starts_[cell],
+                             cell_units_.begin() + cell_starts_[cell + 1]);
+        }
+        std::sort(gathered_.begin(), gathered_.end());
+        visible.reserve(gathered_.size());
+        for (uint32_t index : gathered_)
+        {
+            visible.push_back((*units_)[index].id);
+        }
+        return;
+    }
+
+    for (uint32_t cell : marked_cells_)
+    {
+        for (uint32_t k = cell_starts_[cell]; k < cell_starts_[cell + 1]; ++k)
+        {
+            unit_marks_[cell_units_[k]] = stamp_;
+        }
+    }
+    visible.reserve(gathered_count);
+    for (uint32_t index = 0; index < unit_marks_.size(); ++index)
+    {
+        if (unit_marks_[index] == stamp_)
+        {
+            visible.push_back((*units_)[index].id);
+        }
+    }
+}
+
+void InterestGrid::set_camera(PlayerID player_id, const CameraRect &camera)
+{
+    std::lock_guard<std::mutex> lock(cameras_mutex_);
+    cameras_[player_id] = camera;
+}
+
+bool InterestGrid::get_camera(PlayerID player_id, CameraRect &camera)
+{
+    std::lock_guard<std::mutex> lock(cameras_mutex_);
+    auto it = cameras_.find(player_id);
+    if (it == cameras_.end())
+    {
+        return false;
+    }
+    camera = it->second;
+    return true;
+}
+
+void InterestGrid::remove_client(PlayerID player_id)
+{
+    std::lock_guard<std::mutex> lock(cameras_mutex_);
+    cameras_.erase(player_id);
+}
+
+int InterestGrid::column_of(int64_t x) const
+{
+    return static_cast<int>(std::clamp<int64_t>(x / cell_size_, 0, columns_ - 1));
+}
+
+int InterestGrid::row_of(int64_t y) const
+{
+    return static_cast<int>(std::clamp<int64_t>(y / cell_size_, 0, rows_ - 1));
+}
+
+int InterestGrid::column_of(int x) const
+{
+    return std::clamp(x / cell_size_, 0, columns_ - 1);
+}
+
+int InterestGrid::row_of(int y) const
+{
+    return std::clamp(y / cell_size_, 0, rows_ - 1);
+}
+
+void InterestGrid::mark_cells(int64_t min_x, int64_t min_y, int64_t max_x, int64_t max_y)
+{
+    // Clamping keeps off-map positions on the edge cells, where rebuild put their units. Positions
+    // come from clients, hence 64-bit bounds.
+    for (int row = row_of(min_y); row <= row_of(max_y); ++row)
+    {
+        for (int column = column_of(min_x); column <= column_of(max_x); ++column)
+        {
+            uint32_t cell = static_cast<uint32_t>(row * columns_ + column);
+            if (cell_marks_[cell] != stamp_)
+            {
+                cell_marks_[cell] = stamp_;
+                marked_cells_.push_back(cell);
+            }
+        }
+    }
+}
+
+size_t InterestGrid::get_memory_usage()
+{
+    size_t bytes = memory_usage::of(cell_starts_) + memory_usage::of(cell_units_) + memory_usage::of(unit_cells_) +
+                   memory_usage::of(cell_owners_) + memory_usage::of(owned_cells_) + memory_usage::of(cell_marks_) +
+                   memory_usage::of(unit_marks_) + memory_usage::of(marked_cells_) + memory_usage::of(gathered_);
+    for (const auto &[player_id, cells] : owned_cells_)
+    {
+        bytes += memory_usage::of(cells);
+    }
+    std::lock_guard<std::mutex> lock(cameras_mutex_);
+    return bytes + memory_usage::of(cameras_);
+}
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "server/lockstep.hpp"
+#include "server/simulation.hpp"
+#include "server/snapshot.hpp"
+#include "networking/message_payloads.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    using TurnCommands = message_schema::PayloadSet<payload::Move, payload::Build, payload::Attack, payload::Harvest,
+                                                    payload::JoinGame>;
+
+    void to_command(const payload::Move &move, PlayerCommand &command)
+    {
+        command.kind = PlayerCommand::Kind::Move;
+        command.x = move.x;
+        command.y = move.y;
+        move.unit_ids.copy_to(command.unit_ids);
+    }
+
+    void to_command(const payload::Build &build, PlayerCommand &command)
+    {
+        command.kind = PlayerCommand::Kind::Build;
+        command.x = build.x;
+        command.y = build.y;
+        command.building_type = build.building_type;
+    }
+
+    void to_command(const payload::Attack &attack, PlayerCommand &command)
+    {
+        command.kind = PlayerCommand::Kind::Attack;
+        command.unit_id = attack.attacker_id;
+        command.target_id = attack.target_id;
+    }
+
+    void to_command(const payload::Harvest &harvest, PlayerCommand &command)
+    {
+        command.kind = PlayerCommand::Kind::Harvest;
+        command.unit_id = harvest.unit_id;
+        command.target_id = harvest.resource_id;
+    }
+
+    void to_command(const payload::JoinGame &join, PlayerCommand &command)
+    {
+        command.kind = PlayerCommand::Kind::Join;
+        command.x = join.x;
+        command.y = join.y;
+    }
+}
+
+namespace lockstep
+{
+    Message encode_command(const PlayerCommand &command)
+    {
+        switch (command.kind)
+        {
+        case PlayerCommand::Kind::Build:
+            return message_schema::encode(payload::Build{command.x, command.y, command.building_type});
+        case PlayerCommand::Kind::Attack:
+            return message_schema::encode(payload::Attack{command.unit_id, command.target_id});
+        case PlayerCommand::Kind::Harvest:
+            return message_schema::encode(payload::Harvest{command.unit_id, command.target_id});
+        case PlayerCommand::Kind::Join:
+            return message_schema::encode(payload::JoinGame{command.x, command.y});
+        default:
+            return message_schema::encode(payload::Move{command.x, command.y, command.unit_ids});
+        }
+    }
+
+    bool decode_command(const MessageView &message, PlayerCommand &command)
+    {
+        return TurnCommands::dispatch(message, [&command](const auto &payload)
+                                      { to_command(payload, command); }) == message_schema::DispatchResult::Handled;
+    }
+}
+
+void LockstepTurnBuilder::begin(uint32_t turn)
+{
+    data_.clear();
+    count_ = 0;
+    message_schema::encode_to(data_, payload::LockstepTurn{turn, 0});
+}
+
+void LockstepTurnBuilder::add(const PlayerCommand &command)
+{
+    body_.clear();
+    MessageType type;
+    switch (command.kind)
+    {
+    case PlayerCommand::Kind::Move:
+        type = MessageType::PlayerMove;
+        message_schema::encode_to(body_, payload::Move{command.x, command.y, command.unit_ids});
+        break;
+    case PlayerCommand::Kind::Build:
+        type = MessageType::PlayerBuild;
+        message_schema::encode_to(body_, payload::Build{command.x, command.y, command.building_type});
+        break;
+    case PlayerCommand::Kind::Attack:
+        type = MessageType::PlayerAttack;
+        message_schema::encode_to(body_, payload::Attack{command.unit_id, command.target_id});
+        break;
+    case PlayerCommand::Kind::Harvest:
+        type = MessageType::PlayerHarvest;
+        message_schema::encode_to(body_, payload::Harvest{command.unit_id, command.target_id});
+        break;
+    case PlayerCommand::Kind::Join:
+        type = MessageType::JoinGame;
+        message_schema::encode_to(body_, payload::JoinGame{command.x, command.y});
+        break;
+    default:
+        return;
+    }
+
+    std::string_view body(reinterpret_cast<const char *>(body_.data()), body_.size());
+    message_schema::encode_to(data_, payload::TurnCommand{command.player_id, type, body});
+    ++count_;
+}
+
+Message LockstepTurnBuilder::finish()
+{
+    // command_count follows the turn number in the header
+    std::memcpy(data_.data() + sizeof(uint32_t), &count_, sizeof(count_));
+    Message message;
+    message.type = MessageType::LockstepTurn;
+    message.data = data_;
+    return message;
+}
+
+void LockstepVerifier::record(uint32_t turn, uint64_t checksum)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A gap in the turns would break the offset lookup in report; start the history again
+    if (!history_.empty() && history_.back().first + 1 != turn)
+    {
+        history_.clear();
+    }
+    history_.emplace_back(turn, checksum);
+    if (history_.size() > max_history)
+    {
+        history_.pop_front();
+    }
+    ++stats_.turns;
+}
+
+LockstepCheck LockstepVerifier::report(PlayerID player_id, uint32_t turn, uint64_t checksum, uint64_t &expected)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Peer &peer = peers_[player_id];
+    if (peer.first_bad_turn != 0)
+    {
+        return LockstepCheck::AlreadyDiverged;
+    }
+    if (history_.empty() || turn < history_.front().first || turn > history_.back().first)
+    {
+        ++stats_.unverifiable;
+        return LockstepCheck::Unverifiable;
+    }
+
+    expected = history_[turn - history_.front().first].second;
+    ++stats_.hashes_checked;
+    if (checksum == expected)
+    {
+        peer.last_good_turn = std::max(peer.last_good_turn, turn);
+        return LockstepCheck::Match;
+    }
+
+    peer.first_bad_turn = turn;
+    ++stats_.desyncs;
+    if (stats_.first_divergent_turn == 0 || turn < stats_.first_divergent_turn)
+    {
+        stats_.first_divergent_turn = turn;
+    }
+    return LockstepCheck::Diverged;
+}
+
+bool LockstepVerifier::get_peer(PlayerID player_id, Peer &peer) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = peers_.find(player_id);
+    if (it == peers_.end())
+    {
+        return false;
+    }
+    peer = it->second;
+    return true;
+}
+
+void LockstepVerifier::remove_peer(PlayerID player_id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    peers_.erase(player_id);
+}
+
+LockstepStats LockstepVerifier::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+LockstepPeer::LockstepPeer()
+    : game_state_(std::make_unique<GameState>()), resource_manager_(std::make_unique<ResourceManager>())
+{
+}
+
+bool LockstepPeer::load(PlayerID player_id, const MessageView &keyframe, const NameTable *resource_names)
+{
+    SnapshotDecoder decoder(player_id, resource_names);
+    if (!decoder.apply(keyframe) || !decoder.latest())
+    {
+        return false;
+    }
+
+    auto game_state = std::make_unique<GameState>();
+    const WorldSnapshot &world = *decoder.latest();
+    for (const UnitState &unit : world.units)
+    {
+        if (!game_state->restore_unit(unit))
+        {
+            return false;
+        }
+    }
+    game_state->set_next_unit_id(world.next_unit_id);
+    for (const auto &[score_player, score] : world.scores)
+    {
+        game_state->update_player_score(score_player, score);
+    }
+
+    game_state_ = std::move(game_state);
+    resource_manager_ = std::make_unique<ResourceManager>();
+    for (const auto &[resource_player, resources] : world.resources)
+    {
+        for (const auto &[name, amount] : resources)
+        {
+            resource_manager_->add_resource(resource_player, name, amount);
+        }
+    }
+    loaded_ = true;
+    started_ = false;
+    return true;
+}
+
+bool LockstepPeer::apply(const MessageView &turn)
+{
+    const uint8_t *position = turn.data;
+    const uint8_t *end = turn.data + turn.size;
+    payload::LockstepTurn header;
+    if (!loaded_ || !message_schema::decode_from(position, end, header))
+    {
+        return false;
+    }
+    if (started_ ? header.turn != game_state_->get_turn() + 1 : header.turn == 0)
+    {
+        return false;
+    }
+
+    // Decode the whole turn before applying any of it
+    uint32_t count = header.command_count;
+    if (commands_.size() < count && count <= turn.size / sizeof(PlayerID))
+    {
+        commands_.resize(count);
+    }
+    if (commands_.size() < count)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        PlayerCommand &command = commands_[i];
+        payload::TurnCommand entry;
+        if (!message_schema::decode_from(position, end, entry))
+        {
+            return false;
+        }
+        command.player_id = entry.player_id;
+        MessageView embedded{entry.command_type, reinterpret_cast<const uint8_t *>(entry.body.data()),
+                             entry.body.size(), entry.player_id};
+        if (!lockstep::decode_command(embedded, command))
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        simulation::apply_command(*game_state_, *resource_manager_, commands_[i]);
+    }
+    // The first turn after a keyframe sets the count; the keyframe does not carry it
+    game_state_->set_turn(header.turn);
+    started_ = true;
+    return true;
+}
\ No newline at end of file
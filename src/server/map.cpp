@@ -1,4 +1,5 @@
 #include "server/map.hpp"
+#include "utils/memory_usage.hpp"
 #include <fstream>
 #include <stdexcept>
 #include <limits>
@@ -81,4 +82,9 @@ float Map::get_movement_cost(int x, int y) const
 bool Map::is_valid_position(int x, int y) const
 {
     return x >= 0 && x < width_ && y >= 0 && y < height_;
+}
+
+size_t Map::get_memory_usage() const
+{
+    return memory_usage::of(tiles_);
 }
\ No newline at end of file
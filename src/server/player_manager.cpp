@@ -55,4 +55,16 @@ std::vector<PlayerID> PlayerManager::get_players_in_team(TeamNumber team) const
 {
     auto it = team_assignments_.find(team);
     return it != team_assignments_.end() ? it->second : std::vector<PlayerID>();
+}
+
+std::vector<PlayerID> PlayerManager::get_teammates(PlayerID player_id) const
+{
+    for (const auto &[team, players] : team_assignments_)
+    {
+        if (std::find(players.begin(), players.end(), player_id) != players.end())
+        {
+            return players;
+        }
+    }
+    return {player_id};
 }
\ No newline at end of file
@@ -0,0 +1,401 @@
+#include "server/replay.hpp"
+#include "server/lockstep.hpp"
+#include "server/simulation.hpp"
+#include "server/snapshot.hpp"
+#include "networking/message_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace message_utils;
+
+namespace
+{
+    constexpr uint32_t replay_magic = 0x4c505243; // "CRPL"
+    constexpr uint16_t replay_version = 2;
+    constexpr size_t header_size = sizeof(uint32_t) + 4 * sizeof(uint16_t);
+}
+
+ReplayRecorder::ReplayRecorder(uint32_t keyframe_interval)
+    : keyframe_interval_(std::max(keyframe_interval, 1u))
+{
+}
+
+ReplayRecorder::~ReplayRecorder() = default;
+
+bool ReplayRecorder::open(const std::string &path, const ReplayHeader &header, const GameState &game_state,
+                          const ResourceManager &resource_manager)
+{
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_)
+    {
+        std::cerr << "Could not create replay " << path << std::endl;
+        return false;
+    }
+
+    layout_ = CompactLayout(header.map_width, header.map_height);
+    last_tick_ = 0;
+    record_.clear();
+    write_to_vector(record_, replay_magic);
+    write_to_vector(record_, replay_version);
+    write_to_vector(record_, header.map_width);
+    write_to_vector(record_, header.map_height);
+    write_to_vector(record_, header.tick_rate);
+    file_.write(reinterpret_cast<const char *>(record_.data()), record_.size());
+    stats_.bytes += record_.size();
+    write_keyframe(game_state, resource_manager);
+    return file_.good();
+}
+
+void ReplayRecorder::add(const PlayerCommand &command)
+{
+    if (!is_open())
+    {
+        return;
+    }
+    compact_codec::write_varint(tick_body_, command.player_id);
+    compact_codec::serialize(lockstep::encode_command(command), layout_, tick_body_);
+    ++stats_.commands;
+}
+
+void ReplayRecorder::end_tick(const GameState &game_state, const ResourceManager &resource_manager)
+{
+    if (!is_open())
+    {
+        return;
+    }
+    uint32_t tick = game_state.get_turn();
+    if (!tick_body_.empty())
+    {
+        write_record(replay_records::tick, tick, tick_body_);
+        tick_body_.clear();
+        ++stats_.ticks;
+    }
+    if (tick % keyframe_interval_ == 0)
+    {
+        write_keyframe(game_state, resource_manager);
+        // A crash loses at most the ticks since the last keyframe
+        file_.flush();
+    }
+    if (!file_)
+    {
+        std::cerr << "Replay write failed at tick " << tick << ", recording stopped" << std::endl;
+        file_.close();
+    }
+}
+
+void ReplayRecorder::close(const GameState &game_state)
+{
+    if (!is_open())
+    {
+        return;
+    }
+    std::vector<uint8_t> body;
+    write_to_vector(body, game_state.checksum());
+    write_record(replay_records::end, game_state.get_turn(), body);
+    file_.close();
+}
+
+void ReplayRecorder::write_keyframe(const GameState &game_state, const ResourceManager &resource_manager)
+{
+    // A fresh encoder has no baseline, so its snapshot for player 0 is a keyframe with every unit
+    // and score, and no player's resources
+    SnapshotEncoder encoder;
+    encoder.capture(game_state, resource_manager);
+    std::vector<uint8_t> body;
+    write_to_vector(body, game_state.checksum());
+    std::vector<uint8_t> keyframe = encoder.encode(0).serialize();
+    body.insert(body.end(), keyframe.begin(), keyframe.end());
+    write_record(replay_records::keyframe, game_state.get_turn(), body);
+    ++stats_.keyframes;
+}
+
+void ReplayRecorder::write_record(uint8_t kind, uint32_t tick, const std::vector<uint8_t> &body)
+{
+    record_.clear();
+    record_.push_back(kind);
+    compact_codec::write_varint(record_, tick - last_tick_);
+    compact_codec::write_varint(record_, body.size());
+    file_.write(reinterpret_cast<const char *>(record_.data()), record_.size());
+    file_.write(reinterpret_cast<const char *>(body.data()), body.size());
+    stats_.bytes += record_.size() + body.size();
+    last_tick_ = tick;
+}
+
+ReplayPlayer::ReplayPlayer()
+    : game_state_(std::make_unique<GameState>()), resource_manager_(std::make_unique<ResourceManager>())
+{
+}
+
+ReplayPlayer::~ReplayPlayer()
+{
+    close();
+}
+
+bool ReplayPlayer::open(const std::string &path)
+{
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    struct stat file_stat;
+    if (fd_ < 0 || fstat(fd_, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < header_size)
+    {
+        std::cerr << "Could not open replay " << path << std::endl;
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Could not map replay " << path << std::endl;
+        close();
+        return false;
+    }
+    data_ = static_cast<const uint8_t *>(mapping);
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+
+    uint32_t magic;
+    uint16_t version;
+    std::memcpy(&magic, data_, sizeof(magic));
+    std::memcpy(&version, data_ + sizeof(magic), sizeof(version));
+    std::memcpy(&header_.map_width, data_ + 6, sizeof(uint16_t));
+    std::memcpy(&header_.map_height, data_ + 8, sizeof(uint16_t));
+    std::memcpy(&header_.tick_rate, data_ + 10, sizeof(uint16_t));
+    if (magic != replay_magic || version != replay_version)
+    {
+        std::cerr << "Not a replay, or an unsupported version: " << path << std::endl;
+        close();
+        return false;
+    }
+    layout_ = CompactLayout(header_.map_width, header_.map_height);
+
+    // Index the keyframes; only record headers are read
+    size_t offset = header_size;
+    uint32_t tick = 0;
+    Record record;
+    while (read_record(offset, tick, record))
+    {
+        if (record.kind == replay_records::keyframe)
+        {
+            keyframes_.push_back(Keyframe{record.tick, offset});
+        }
+        complete_ = record.kind == replay_records::end;
+        tick = record.tick;
+        offset = record.next;
+    }
+    end_offset_ = offset;
+    end_tick_ = tick;
+    if (keyframes_.empty() || keyframes_.front().offset != header_size || !load_keyframe(keyframes_.front()))
+    {
+        std::cerr << "Replay " << path << " does not start with a keyframe" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void ReplayPlayer::close()
+{
+    if (data_)
+    {
+        munmap(const_cast<uint8_t *>(data_), size_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    keyframes_.clear();
+    end_offset_ = 0;
+    end_tick_ = 0;
+    complete_ = false;
+    cursor_ = 0;
+    cursor_tick_ = 0;
+    stats_ = ReplayStats{};
+}
+
+bool ReplayPlayer::seek(uint32_t tick)
+{
+    if (!data_)
+    {
+        return false;
+    }
+    auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), tick, [](uint32_t target, const Keyframe &keyframe)
+                               { return target < keyframe.tick; });
+    const Keyframe &keyframe = it == keyframes_.begin() ? keyframes_.front() : *(it - 1);
+    // Carry on from here when no keyframe lies between here and the target
+    if (tick < get_tick() || keyframe.tick > get_tick())
+    {
+        if (!load_keyframe(keyframe))
+        {
+            return false;
+        }
+    }
+    return play_to(tick);
+}
+
+bool ReplayPlayer::play_to(uint32_t tick)
+{
+    if (!data_)
+    {
+        return false;
+    }
+    Record record;
+    while (cursor_ < end_offset_)
+    {
+        if (!read_record(cursor_, cursor_tick_, record))
+        {
+            return false;
+        }
+        if (record.tick > tick)
+        {
+            break;
+        }
+        if (record.kind == replay_records::tick)
+        {
+            if (!apply_commands(record))
+            {
+                return false;
+            }
+            game_state_->set_turn(record.tick);
+        }
+        else
+        {
+            game_state_->set_turn(record.tick);
+            check(record);
+        }
+        cursor_ = record.next;
+        cursor_tick_ = record.tick;
+    }
+    // Nothing happens between records, so the world stands as it is until the target
+    game_state_->set_turn(std::max(get_tick(), std::min(tick, end_tick_)));
+    return true;
+}
+
+bool ReplayPlayer::read_record(size_t offset, uint32_t previous_tick, Record &record) const
+{
+    if (offset >= size_)
+    {
+        return false;
+    }
+    const uint8_t *position = data_ + offset;
+    const uint8_t *end = data_ + size_;
+    uint64_t tick_delta;
+    uint64_t body_size;
+    record.kind = *position++;
+    if (record.kind > replay_records::end || !compact_codec::read_varint(position, end, tick_delta) ||
+        !compact_codec::read_varint(position, end, body_size) || body_size > static_cast<uint64_t>(end - position))
+    {
+        return false;
+    }
+    record.tick = previous_tick + static_cast<uint32_t>(tick_delta);
+    record.body = position;
+    record.size = static_cast<size_t>(body_size);
+    record.next = static_cast<size_t>(position + body_size - data_);
+    return true;
+}
+
+bool ReplayPlayer::load_keyframe(const Keyframe &keyframe)
+{
+    Record record;
+    uint64_t checksum;
+    MessageView view;
+    // The previous tick only matters for the delta; the keyframe's own tick is indexed
+    if (!read_record(keyframe.offset, 0, record) || record.size < sizeof(checksum) ||
+        !Message::parse(record.body + sizeof(checksum), record.size - sizeof(checksum), view) ||
+        view.type != MessageType::ResourceUpdate)
+    {
+        return false;
+    }
+    std::memcpy(&checksum, record.body, sizeof(checksum));
+
+    SnapshotDecoder decoder(0);
+    if (!decoder.apply(view) || !decoder.latest())
+    {
+        return false;
+    }
+    auto game_state = std::make_unique<GameState>();
+    for (const UnitState &unit : decoder.latest()->units)
+    {
+        if (!game_state->restore_unit(unit))
+        {
+            return false;
+        }
+    }
+    game_state->set_next_unit_id(decoder.latest()->next_unit_id);
+    for (const auto &[player_id, score] : decoder.latest()->scores)
+    {
+        game_state->update_player_score(player_id, score);
+    }
+    game_state->set_turn(keyframe.tick);
+    if (game_state->checksum() != checksum)
+    {
+        return false;
+    }
+
+    game_state_ = std::move(game_state);
+    resource_manager_ = std::make_unique<ResourceManager>();
+    cursor_ = record.next;
+    cursor_tick_ = keyframe.tick;
+    ++stats_.keyframes_loaded;
+    return true;
+}
+
+bool ReplayPlayer::apply_commands(const Record &record)
+{
+    const uint8_t *position = record.body;
+    const uint8_t *end = record.body + record.size;
+    while (position < end)
+    {
+        uint64_t player_id;
+        MessageView view;
+        if (!compact_codec::read_varint(position, end, player_id) ||
+            !Message::parse(position, static_cast<size_t>(end - position), view))
+        {
+            return false;
+        }
+        position = view.data + view.size;
+        if (view.compact && compact_codec::has_compact_payload(view.type))
+        {
+            if (!compact_codec::expand(view, layout_, expanded_))
+            {
+                return false;
+            }
+            view.data = expanded_.data();
+            view.size = expanded_.size();
+        }
+        command_.player_id = static_cast<PlayerID>(player_id);
+        if (!lockstep::decode_command(view, command_))
+        {
+            return false;
+        }
+        simulation::apply_command(*game_state_, *resource_manager_, command_);
+        ++stats_.commands;
+    }
+    ++stats_.records;
+    return true;
+}
+
+void ReplayPlayer::check(const Record &record)
+{
+    uint64_t checksum;
+    if (record.size < sizeof(checksum))
+    {
+        return;
+    }
+    std::memcpy(&checksum, record.body, sizeof(checksum));
+    ++stats_.checksums_checked;
+    if (game_state_->checksum() != checksum)
+    {
+        if (stats_.mismatches++ == 0)
+        {
+            stats_.first_mismatch_tick = record.tick;
+        }
+    }
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "server/resource_manager.hpp"
+#include "utils/memory_usage.hpp"
 #include <algorithm>
 
 ResourceManager::ResourceManager()
@@ -9,6 +10,13 @@ ResourceManager::ResourceManager()
         {2, "Wood", 500, true, 0.1f},
         {3, "Stone", 300, true, 0.05f},
         {4, "Food", 200, true, 0.2f}};
+
+    std::vector<std::string> names;
+    for (const auto &resource : available_resources_)
+    {
+        names.push_back(resource.name);
+    }
+    resource_names_ = NameTable(std::move(names));
 }
 
 ResourceManager::~ResourceManager() = default;
@@ -75,4 +83,14 @@ void ResourceManager::update(float delta_time)
                                            static_cast<float>(node.resource.initial_amount));
         }
     }
+}
+
+size_t ResourceManager::get_memory_usage() const
+{
+    size_t bytes = memory_usage::of(player_resources_) + memory_usage::of(resource_nodes_);
+    for (const auto &[player_id, resources] : player_resources_)
+    {
+        bytes += memory_usage::of(resources);
+    }
+    return bytes;
 }
\ No newline at end of file
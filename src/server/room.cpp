@@ -0,0 +1,529 @@
+#include "server/room.hpp"
+#include "server/simulation.hpp"
+#include "networking/message_payloads.hpp"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+
+Room::Room(RoomID id, boost::asio::io_context &io_context, const RoomSettings &settings)
+    : id_(id), io_context_(io_context), settings_(settings)
+{
+    if (settings_.lockstep)
+    {
+        // Peers simulate the whole world, so the keyframe carries all of it
+        settings_.interest = false;
+        settings_.snapshot_budget = 0;
+    }
+    game_state_ = std::make_unique<GameState>();
+    player_manager_ = std::make_unique<PlayerManager>();
+    map_ = std::make_unique<Map>(settings_.map_width, settings_.map_height, settings_.tile_size);
+    resource_manager_ = std::make_unique<ResourceManager>();
+    chat_handler_ = std::make_unique<ChatHandler>();
+    timer_ = std::make_unique<Timer>();
+    snapshot_encoder_ = std::make_unique<SnapshotEncoder>();
+    interest_grid_ = std::make_unique<InterestGrid>(*map_);
+    if (settings_.interest)
+    {
+        snapshot_encoder_->set_interest(interest_grid_.get());
+    }
+    command_queue_ = std::make_unique<CommandQueue>(settings_.max_players * settings_.commands_per_player);
+    turn_builder_ = std::make_unique<LockstepTurnBuilder>();
+    lockstep_verifier_ = std::make_unique<LockstepVerifier>();
+    register_handlers();
+}
+
+Room::~Room()
+{
+    stop();
+    if (replay_recorder_)
+    {
+        replay_recorder_->close(*game_state_);
+    }
+}
+
+void Room::register_handlers()
+{
+    // Connect and Disconnect are handled by the connection itself
+    dispatcher_.on<payload::Chat, &Room::handle_chat_message>(this);
+    dispatcher_.on<payload::Move, &Room::handle_move_command>(this);
+    dispatcher_.on<payload::Build, &Room::handle_build_command>(this);
+    dispatcher_.on<payload::Attack, &Room::handle_attack_command>(this);
+    dispatcher_.on<payload::Harvest, &Room::handle_harvest_command>(this);
+    dispatcher_.on<payload::SnapshotAck, &Room::handle_snapshot_ack>(this);
+    dispatcher_.on<payload::CameraUpdate, &Room::handle_camera_update>(this);
+    dispatcher_.on<payload::UpgradeRequest, &Room::handle_upgrade_request>(this);
+    dispatcher_.on<payload::TechnologyRequest, &Room::handle_technology_request>(this);
+    dispatcher_.on<payload::UpgradeListRequest, &Room::handle_upgrade_list_request>(this);
+    dispatcher_.on_interned<payload::InternedUpgradeRequest, &Room::handle_interned_upgrade_request>(this);
+    dispatcher_.on_interned<payload::InternedTechnologyRequest, &Room::handle_interned_technology_request>(this);
+    if (settings_.lockstep)
+    {
+        dispatcher_.on<payload::StateHash, &Room::handle_state_hash>(this);
+    }
+}
+
+void Room::start(float phase)
+{
+    if (game_loop_)
+    {
+        return;
+    }
+
+    // A tick that finds the room gone does nothing; one in progress keeps it alive
+    std::weak_ptr<Room> room = weak_from_this();
+    game_loop_ = std::make_shared<GameLoop>(io_context_, [room](float delta_time)
+                                            {
+                                                if (auto self = room.lock())
+                                                {
+                                                    self->tick(delta_time);
+                                                }
+                                            });
+    if (!settings_.replay_directory.empty())
+    {
+        // Before the first tick, so the recording starts from the empty world
+        ReplayHeader header{static_cast<uint16_t>(settings_.map_width), static_cast<uint16_t>(settings_.map_height),
+                            static_cast<uint16_t>(settings_.tick_rate)};
+        std::string path = settings_.replay_directory + "/room-" + std::to_string(std::time(nullptr)) + "-" +
+                           std::to_string(id_) + ".replay";
+        replay_recorder_ = std::make_unique<ReplayRecorder>();
+        replay_recorder_->open(path, header, *game_state_, *resource_manager_);
+    }
+    game_loop_->set_tick_rate(settings_.tick_rate);
+    game_loop_->set_game_speed(settings_.game_speed);
+    game_loop_->start(phase);
+}
+
+void Room::stop()
+{
+    if (game_loop_)
+    {
+        game_loop_->stop();
+    }
+}
+
+bool Room::add_member(const std::shared_ptr<ClientConnection> &connection)
+{
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    if (members_.size() >= settings_.max_players)
+    {
+        return false;
+    }
+    connection->set_compact_layout(CompactLayout(static_cast<uint16_t>(settings_.map_width),
+                                                 static_cast<uint16_t>(settings_.map_height)));
+    connection->set_dispatcher(std::shared_ptr<const MessageDispatcher>(shared_from_this(), &dispatcher_));
+
+    // Members start with a few units in their own part of the map. The spawn is queued as a
+    // command, so lockstep peers and replays see it in the turn it happens.
+    int slot = static_cast<int>(members_.size());
+    int rows = static_cast<int>((settings_.max_players + 3) / 4);
+    int home_x = (slot % 4 * 2 + 1) * settings_.map_width / 8;
+    int home_y = (slot / 4 * 2 + 1) * settings_.map_height / (rows * 2);
+    command_queue_->push(PlayerCommand::Kind::Join, connection->get_player_id(), [&](PlayerCommand &command)
+                         {
+                             command.x = home_x;
+                             command.y = home_y;
+                         });
+    members_.push_back(connection);
+    if (settings_.lockstep)
+    {
+        joining_.push_back(connection->get_player_id());
+    }
+    return true;
+}
+
+bool Room::remove_member(PlayerID player_id)
+{
+    {
+        std::lock_guard<std::mutex> lock(members_mutex_);
+        auto it = std::find_if(members_.begin(), members_.end(), [player_id](const auto &member)
+                               { return member->get_player_id() == player_id; });
+        if (it == members_.end())
+        {
+            return false;
+        }
+        *it = std::move(members_.back());
+        members_.pop_back();
+        joining_.erase(std::remove(joining_.begin(), joining_.end(), player_id), joining_.end());
+    }
+    snapshot_encoder_->remove_client(player_id);
+    interest_grid_->remove_client(player_id);
+    lockstep_verifier_->remove_peer(player_id);
+    return true;
+}
+
+std::vector<PlayerID> Room::get_member_ids() const
+{
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    std::vector<PlayerID> ids;
+    ids.reserve(members_.size());
+    for (const auto &member : members_)
+    {
+        ids.push_back(member->get_player_id());
+    }
+    return ids;
+}
+
+size_t Room::get_member_count() const
+{
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    return members_.size();
+}
+
+void Room::close()
+{
+    // Members hold the room through its dispatcher; dropping them here breaks the cycle
+    std::vector<std::shared_ptr<ClientConnection>> members;
+    {
+        std::lock_guard<std::mutex> lock(members_mutex_);
+        members.swap(members_);
+        joining_.clear();
+    }
+    for (auto &member : members)
+    {
+        member->stop();
+    }
+}
+
+RoomInfo Room::get_info() const
+{
+    RoomInfo info;
+    info.id = id_;
+    info.members = get_member_count();
+    {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        info.memory = memory_;
+    }
+    if (game_loop_)
+    {
+        info.ticks = game_loop_->get_stats();
+    }
+    info.lockstep = lockstep_verifier_->get_stats();
+    return info;
+}
+
+void Room::start_game()
+{
+    game_state_->set_game_started(true);
+
+    Message message;
+    message.type = MessageType::GameStart;
+    broadcast(message);
+}
+
+void Room::broadcast(const Message &message)
+{
+    SharedPayload payload = message.serialize_shared();
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    for (auto &member : members_)
+    {
+        if (member->is_connected())
+        {
+            member->send_payload(payload);
+        }
+    }
+}
+
+void Room::broadcast(const Message &message, const std::vector<PlayerID> &recipients)
+{
+    SharedPayload payload = message.serialize_shared();
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    for (auto &member : members_)
+    {
+        if (member->is_connected() &&
+            std::find(recipients.begin(), recipients.end(), member->get_player_id()) != recipients.end())
+        {
+            member->send_payload(payload);
+        }
+    }
+}
+
+void Room::handle_chat_message(ClientConnection &connection, const payload::Chat &chat)
+{
+    PlayerID player_id = connection.get_player_id();
+    std::vector<PlayerID> teammates;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        if (chat_handler_->is_player_muted(player_id))
+        {
+            return;
+        }
+        chat_handler_->broadcast_message(player_id, std::string(chat.text), chat.team_only);
+        if (chat.team_only)
+        {
+            teammates = player_manager_->get_teammates(player_id);
+        }
+    }
+
+    Message relay = message_schema::encode(payload::ChatBroadcast{player_id, chat.team_only, chat.text});
+    if (!chat.team_only)
+    {
+        broadcast(relay);
+        return;
+    }
+
+    broadcast(relay, teammates);
+}
+
+void Room::handle_move_command(ClientConnection &connection, const payload::Move &move)
+{
+    command_queue_->push(PlayerCommand::Kind::Move, connection.get_player_id(), [&](PlayerCommand &command)
+                         {
+                             command.x = move.x;
+                             command.y = move.y;
+                             move.unit_ids.copy_to(command.unit_ids);
+                         });
+}
+
+void Room::handle_build_command(ClientConnection &connection, const payload::Build &build)
+{
+    command_queue_->push(PlayerCommand::Kind::Build, connection.get_player_id(), [&](PlayerCommand &command)
+                         {
+                             command.x = build.x;
+                             command.y = build.y;
+                             command.building_type = build.building_type;
+                         });
+}
+
+void Room::handle_attack_command(ClientConnection &connection, const payload::Attack &attack)
+{
+    command_queue_->push(PlayerCommand::Kind::Attack, connection.get_player_id(), [&](PlayerCommand &command)
+                         {
+                             command.unit_id = attack.attacker_id;
+                             command.target_id = attack.target_id;
+                         });
+}
+
+void Room::handle_harvest_command(ClientConnection &connection, const payload::Harvest &harvest)
+{
+    command_queue_->push(PlayerCommand::Kind::Harvest, connection.get_player_id(), [&](PlayerCommand &command)
+                         {
+                             command.unit_id = harvest.unit_id;
+                             command.target_id = harvest.resource_id;
+                         });
+}
+
+void Room::tick(float delta_time)
+{
+    run_turn();
+    timer_->update(delta_time);
+    resource_manager_->update(delta_time);
+    if (settings_.lockstep)
+    {
+        send_turn();
+    }
+    else
+    {
+        send_snapshots();
+    }
+    measure_memory();
+}
+
+size_t Room::run_turn()
+{
+    // The turn is whatever arrived since the last tick; the server does not wait for inputs
+    turn_builder_->begin(game_state_->get_turn() + 1);
+    size_t applied = command_queue_->drain([this](const PlayerCommand &command)
+                                           {
+                                               simulation::apply_command(*game_state_, *resource_manager_, command);
+                                               if (settings_.lockstep)
+                                               {
+                                                   turn_builder_->add(command);
+                                                   if (command.kind == PlayerCommand::Kind::Join)
+                                                   {
+                                                       joined_.push_back(command.player_id);
+                                                   }
+                                               }
+                                               if (replay_recorder_)
+                                               {
+                                                   replay_recorder_->add(command);
+                                               }
+                                           });
+    game_state_->advance_turn();
+    if (settings_.lockstep)
+    {
+        lockstep_verifier_->record(game_state_->get_turn(), game_state_->checksum());
+    }
+    if (replay_recorder_)
+    {
+        replay_recorder_->end_tick(*game_state_, *resource_manager_);
+    }
+    return applied;
+}
+
+void Room::send_turn()
+{
+    SharedPayload turn = turn_builder_->finish().serialize_shared();
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    // Joining members get the world as of the turn that applied their Join, whenever the drain
+    // picked it up, and pick up from the next turn; until then they are sent nothing
+    if (!joined_.empty())
+    {
+        snapshot_encoder_->capture(*game_state_, *resource_manager_);
+    }
+    for (auto &member : members_)
+    {
+        if (!member->is_connected())
+        {
+            continue;
+        }
+        PlayerID player_id = member->get_player_id();
+        auto joining = std::find(joining_.begin(), joining_.end(), player_id);
+        if (joining == joining_.end())
+        {
+            member->send_payload(turn);
+            continue;
+        }
+        if (std::find(joined_.begin(), joined_.end(), player_id) == joined_.end())
+        {
+            continue;
+        }
+        const NameTable *resource_names = member->get_capabilities() & capabilities::interned_names
+                                              ? &resource_manager_->get_resource_names()
+                                              : nullptr;
+        member->send_message(snapshot_encoder_->encode(player_id, resource_names));
+        snapshot_encoder_->remove_client(player_id);
+        joining_.erase(joining);
+    }
+    joined_.clear();
+}
+
+void Room::send_snapshots()
+{
+    snapshot_encoder_->capture(*game_state_, *resource_manager_);
+
+    std::lock_guard<std::mutex> lock(members_mutex_);
+    for (auto &member : members_)
+    {
+        if (member->is_connected())
+        {
+            const NameTable *resource_names = member->get_capabilities() & capabilities::interned_names
+                                                  ? &resource_manager_->get_resource_names()
+                                                  : nullptr;
+            member->send_message(snapshot_encoder_->encode(member->get_player_id(), resource_names,
+                                                           settings_.snapshot_budget));
+        }
+    }
+}
+
+void Room::measure_memory()
+{
+    RoomMemory memory;
+    memory.world = map_->get_memory_usage() + resource_manager_->get_memory_usage();
+    memory.snapshots = snapshot_encoder_->get_memory_usage() + interest_grid_->get_memory_usage();
+    memory.commands = command_queue_->get_memory_usage();
+    memory.timers = timer_->get_memory_usage();
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        memory.world += game_state_->get_memory_usage();
+        memory.chat = chat_handler_->get_memory_usage();
+    }
+
+    std::lock_guard<std::mutex> lock(memory_mutex_);
+    memory_ = memory;
+}
+
+void Room::handle_snapshot_ack(ClientConnection &connection, const payload::SnapshotAck &ack)
+{
+    snapshot_encoder_->acknowledge(connection.get_player_id(), ack.sequence);
+}
+
+void Room::handle_camera_update(ClientConnection &connection, const payload::CameraUpdate &camera)
+{
+    interest_grid_->set_camera(connection.get_player_id(), CameraRect{camera.x, camera.y, camera.width, camera.height});
+}
+
+void Room::handle_state_hash(ClientConnection &connection, const payload::StateHash &hash)
+{
+    PlayerID player_id = connection.get_player_id();
+    uint64_t expected = 0;
+    if (lockstep_verifier_->report(player_id, hash.turn, hash.checksum, expected) != LockstepCheck::Diverged)
+    {
+        return;
+    }
+
+    LockstepVerifier::Peer peer;
+    lockstep_verifier_->get_peer(player_id, peer);
+    std::cerr << "Room " << id_ << ": player " << player_id << " desynced at turn " << peer.first_bad_turn
+              << " (last matching turn " << peer.last_good_turn << ")" << std::endl;
+    connection.send_message(message_schema::encode(payload::LockstepDesync{peer.first_bad_turn, peer.last_good_turn,
+                                                                           expected}));
+}
+
+void Room::handle_upgrade_request(ClientConnection &connection, const payload::UpgradeRequest &request)
+{
+    auto &upgrade_manager = game_state_->get_upgrade_manager();
+    PlayerID player_id = connection.get_player_id();
+    std::string upgrade_name(request.upgrade_name);
+    bool success;
+    int new_level;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        success = upgrade_manager.purchase_upgrade(player_id, upgrade_name);
+        new_level = upgrade_manager.get_upgrade_level(player_id, upgrade_name);
+    }
+
+    connection.send_message(Message::create_upgrade_response(success, upgrade_name, new_level));
+}
+
+void Room::handle_interned_upgrade_request(ClientConnection &connection,
+                                           const payload::InternedUpgradeRequest &request)
+{
+    // The id indexes the player's upgrades directly; no name lookup on this path
+    auto &upgrade_manager = game_state_->get_upgrade_manager();
+    PlayerID player_id = connection.get_player_id();
+    bool success;
+    int new_level;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        success = upgrade_manager.purchase_upgrade(player_id, request.upgrade_id);
+        new_level = upgrade_manager.get_upgrade_level(player_id, request.upgrade_id);
+    }
+    connection.send_message(Message::create_upgrade_response(success, request.upgrade_id, new_level));
+}
+
+void Room::handle_technology_request(ClientConnection &connection, const payload::TechnologyRequest &request)
+{
+    auto &upgrade_manager = game_state_->get_upgrade_manager();
+    std::string tech_name(request.tech_name);
+    bool success;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        success = upgrade_manager.unlock_technology(connection.get_player_id(), tech_name);
+    }
+
+    connection.send_message(Message::create_technology_response(success, tech_name));
+}
+
+void Room::handle_interned_technology_request(ClientConnection &connection,
+                                              const payload::InternedTechnologyRequest &request)
+{
+    auto &upgrade_manager = game_state_->get_upgrade_manager();
+    bool success;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        success = upgrade_manager.unlock_technology(connection.get_player_id(), request.tech_id);
+    }
+    connection.send_message(Message::create_technology_response(success, request.tech_id));
+}
+
+void Room::handle_upgrade_list_request(ClientConnection &connection, const payload::UpgradeListRequest &)
+{
+    auto &upgrade_manager = game_state_->get_upgrade_manager();
+    PlayerID player_id = connection.get_player_id();
+    std::unique_lock<std::mutex> lock(requests_mutex_);
+    if (connection.get_capabilities() & capabilities::interned_names)
+    {
+        auto upgrade_ids = upgrade_manager.get_available_upgrade_ids(player_id);
+        auto technology_ids = upgrade_manager.get_available_technology_ids(player_id);
+        lock.unlock();
+        connection.send_message(Message::create_upgrade_list_response(upgrade_ids, technology_ids));
+        return;
+    }
+
+    auto available_upgrades = upgrade_manager.get_available_upgrades(player_id);
+    auto available_technologies = upgrade_manager.get_available_technologies(player_id);
+    lock.unlock();
+
+    connection.send_message(Message::create_upgrade_list_response(
+        available_upgrades, available_technologies));
+}
\ No newline at end of file
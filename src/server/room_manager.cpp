@@ -0,0 +1,200 @@
+#include "server/room_manager.hpp"
+#include <cmath>
+
+namespace
+{
+    constexpr float golden_ratio_fraction = 0.618034f;
+}
+
+RoomManager::RoomManager(boost::asio::io_context &io_context, size_t max_rooms)
+    : io_context_(io_context), max_rooms_(max_rooms)
+{
+}
+
+RoomManager::~RoomManager()
+{
+    clear();
+}
+
+void RoomManager::set_settings(const RoomSettings &settings)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+}
+
+RoomSettings RoomManager::get_settings() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+std::shared_ptr<Room> RoomManager::assign(const std::shared_ptr<ClientConnection> &connection)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Filling the oldest rooms first keeps matches full and the room count down
+    std::shared_ptr<Room> room;
+    for (auto &[room_id, candidate] : rooms_)
+    {
+        if (!candidate->is_full())
+        {
+            room = candidate;
+            break;
+        }
+    }
+    if (!room)
+    {
+        room = create_room_locked();
+    }
+    if (!room || !room->add_member(connection))
+    {
+        return nullptr;
+    }
+    player_rooms_[connection->get_player_id()] = room->get_id();
+    return room;
+}
+
+std::shared_ptr<Room> RoomManager::create_room()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return create_room_locked();
+}
+
+std::shared_ptr<Room> RoomManager::create_room_locked()
+{
+    if (rooms_.size() >= max_rooms_)
+    {
+        return nullptr;
+    }
+    auto room = std::make_shared<Room>(next_room_id_++, io_context_, settings_);
+    room->start(next_phase_);
+    next_phase_ = std::fmod(next_phase_ + golden_ratio_fraction, 1.0f);
+    rooms_.emplace(room->get_id(), room);
+    return room;
+}
+
+bool RoomManager::destroy_room(RoomID room_id)
+{
+    std::shared_ptr<Room> room;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = rooms_.find(room_id);
+        if (it == rooms_.end())
+        {
+            return false;
+        }
+        room = std::move(it->second);
+        rooms_.erase(it);
+        for (PlayerID player_id : room->get_member_ids())
+        {
+            player_rooms_.erase(player_id);
+        }
+    }
+    retire(room);
+    return true;
+}
+
+void RoomManager::remove_player(PlayerID player_id)
+{
+    std::shared_ptr<Room> room;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = player_rooms_.find(player_id);
+        if (it == player_rooms_.end())
+        {
+            return;
+        }
+        auto room_it = rooms_.find(it->second);
+        player_rooms_.erase(it);
+        if (room_it == rooms_.end())
+        {
+            return;
+        }
+        room_it->second->remove_member(player_id);
+        if (room_it->second->get_member_count() != 0)
+        {
+            return;
+        }
+        room = std::move(room_it->second);
+        rooms_.erase(room_it);
+    }
+    retire(room);
+}
+
+void RoomManager::clear()
+{
+    std::map<RoomID, std::shared_ptr<Room>> rooms;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rooms.swap(rooms_);
+        player_rooms_.clear();
+    }
+    for (auto &[room_id, room] : rooms)
+    {
+        retire(room);
+    }
+}
+
+void RoomManager::retire(const std::shared_ptr<Room> &room)
+{
+    room->stop();
+    room->close();
+    GameLoopStats stats = room->get_info().ticks;
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_stats_.merge(stats);
+}
+
+std::shared_ptr<Room> RoomManager::find_room(RoomID room_id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = rooms_.find(room_id);
+    return it != rooms_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<Room> RoomManager::find_player_room(PlayerID player_id) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = player_rooms_.find(player_id);
+    if (it == player_rooms_.end())
+    {
+        return nullptr;
+    }
+    auto room_it = rooms_.find(it->second);
+    return room_it != rooms_.end() ? room_it->second : nullptr;
+}
+
+size_t RoomManager::get_room_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rooms_.size();
+}
+
+std::vector<RoomInfo> RoomManager::get_room_info() const
+{
+    std::vector<std::shared_ptr<Room>> rooms;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &[room_id, room] : rooms_)
+        {
+            rooms.push_back(room);
+        }
+    }
+    std::vector<RoomInfo> info;
+    info.reserve(rooms.size());
+    for (const auto &room : rooms)
+    {
+        info.push_back(room->get_info());
+    }
+    return info;
+}
+
+GameLoopStats RoomManager::get_tick_stats() const
+{
+    GameLoopStats stats;
+    for (const auto &room : get_room_info())
+    {
+        stats.merge(room.ticks);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.merge(retired_stats_);
+    return stats;
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "server/server_runtime.hpp"
+#include <thread>
+
+ServerRuntime::ServerRuntime(NetworkMode mode, unsigned short port, size_t thread_count, size_t room_thread_count)
+    : mode_(mode), thread_count_(std::max<size_t>(1, thread_count)),
+      room_thread_count_(std::max<size_t>(1, room_thread_count)),
+      room_context_(static_cast<int>(room_thread_count_))
+{
+    // Rooms come and go; the pool waits for them rather than finishing when none are left
+    room_work_ = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
+        room_context_.get_executor());
+
+    if (mode_ == NetworkMode::Sharded)
+    {
+        // A concurrency hint of 1 lets each shard's io_context skip internal locking
+        for (size_t i = 0; i < thread_count_; ++i)
+        {
+            io_contexts_.push_back(std::make_unique<boost::asio::io_context>(1));
+        }
+
+        server_ = std::make_unique<CastleServer>(*io_contexts_.front(), room_context_, port, true);
+        for (size_t i = 1; i < io_contexts_.size(); ++i)
+        {
+            server_->add_listener(*io_contexts_[i]);
+        }
+    }
+    else
+    {
+        io_contexts_.push_back(std::make_unique<boost::asio::io_context>(static_cast<int>(thread_count_)));
+        server_ = std::make_unique<CastleServer>(*io_contexts_.front(), room_context_, port);
+    }
+}
+
+ServerRuntime::~ServerRuntime()
+{
+    // Connections and acceptors must go before the io_contexts they are bound to
+    server_.reset();
+}
+
+const char *ServerRuntime::get_backend_name()
+{
+#if defined(BOOST_ASIO_HAS_IO_URING)
+    return "io_uring";
+#else
+    return "epoll";
+#endif
+}
+
+void ServerRuntime::run()
+{
+    server_->start();
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < room_thread_count_; ++i)
+    {
+        threads.emplace_back([this]()
+                             { room_context_.run(); });
+    }
+    for (size_t i = 1; i < thread_count_; ++i)
+    {
+        auto &io_context = mode_ == NetworkMode::Sharded ? *io_contexts_[i] : *io_contexts_.front();
+        threads.emplace_back([&io_context]()
+                             { io_context.run(); });
+    }
+
+    // Calling thread runs the first io_context
+    io_contexts_.front()->run();
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void ServerRuntime::stop()
+{
+    room_work_.reset();
+    room_context_.stop();
+    for (auto &io_context : io_contexts_)
+    {
+        io_context->stop();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "server/simulation.hpp"
+#include "units/unit_store.hpp"
+#include <limits>
+
+namespace simulation
+{
+    void apply_command(GameState &game_state, ResourceManager &resource_manager, const PlayerCommand &command)
+    {
+        switch (command.kind)
+        {
+        case PlayerCommand::Kind::Move:
+            for (UnitID unit_id : command.unit_ids)
+            {
+                UnitRef unit = game_state.get_unit(unit_id);
+                if (unit.is_valid() && unit.get_owner_id() == command.player_id)
+                {
+                    unit.set_position(command.x, command.y);
+                }
+            }
+            break;
+        case PlayerCommand::Kind::Build:
+            // The world state has no buildings yet; the command is ordered with the rest and dropped
+            break;
+        case PlayerCommand::Kind::Attack:
+        {
+            UnitRef attacker = game_state.get_unit(command.unit_id);
+            UnitRef target = game_state.get_unit(command.target_id);
+            if (!attacker.is_valid() || !target.is_valid() || attacker.get_owner_id() != command.player_id ||
+                target.get_owner_id() == command.player_id)
+            {
+                break;
+            }
+            target.set_health(target.get_health() - attack_damage);
+            if (target.get_health() <= 0)
+            {
+                game_state.remove_unit(command.target_id);
+            }
+            break;
+        }
+        case PlayerCommand::Kind::Harvest:
+        {
+            // Ids past NameID's range would wrap onto a real resource
+            if (command.target_id > std::numeric_limits<NameID>::max())
+            {
+                break;
+            }
+            UnitRef harvester = game_state.get_unit(command.unit_id);
+            const std::string *resource_name =
+                resource_manager.get_resource_names().get_name(static_cast<NameID>(command.target_id));
+            if (harvester.is_valid() && harvester.get_owner_id() == command.player_id && resource_name)
+            {
+                resource_manager.add_resource(command.player_id, *resource_name, harvest_amount);
+            }
+            break;
+        }
+        case PlayerCommand::Kind::Join:
+        {
+            int column = 0;
+            int row = 0;
+            for (UnitType type : starting_units)
+            {
+                game_state.spawn_unit(command.player_id, type, command.x + column, command.y + row,
+                                      UnitStore::type_info(type).base_stats.max_health);
+                if (++column == 3)
+                {
+                    column = 0;
+                    ++row;
+                }
+            }
+            break;
+        }
+        }
+    }
+}
\ No newline at end of file
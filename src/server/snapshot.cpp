@@ -0,0 +1,788 @@
+#include "server/snapshot.hpp"
+#include "networking/message_utils.hpp"
+#include "utils/memory_usage.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+using namespace message_utils;
+
+namespace
+{
+    const std::map<std::string, int> no_resources;
+
+    const std::map<std::string, int> &resources_of(const WorldSnapshot &snapshot, PlayerID player_id)
+    {
+        auto it = snapshot.resources.find(player_id);
+        return it != snapshot.resources.end() ? it->second : no_resources;
+    }
+
+    template <typename T>
+    void patch_count(std::vector<uint8_t> &vec, size_t position, T count)
+    {
+        std::memcpy(vec.data() + position, &count, sizeof(T));
+    }
+
+    void write_unit(std::vector<uint8_t> &vec, const UnitState &unit, uint8_t fields)
+    {
+        write_to_vector(vec, unit.id);
+        write_to_vector(vec, fields);
+        if (fields & snapshot_fields::spawn)
+        {
+            write_to_vector(vec, unit.owner);
+            write_to_vector(vec, static_cast<uint8_t>(unit.type));
+        }
+        if (fields & snapshot_fields::position)
+        {
+            write_to_vector(vec, unit.x);
+            write_to_vector(vec, unit.y);
+        }
+        if (fields & snapshot_fields::health)
+        {
+            write_to_vector(vec, unit.health);
+        }
+    }
+
+    size_t unit_record_size(uint8_t fields)
+    {
+        size_t size = sizeof(UnitID) + sizeof(uint8_t);
+        if (fields & snapshot_fields::spawn)
+            size += sizeof(PlayerID) + sizeof(uint8_t);
+        if (fields & snapshot_fields::position)
+            size += 2 * sizeof(int);
+        if (fields & snapshot_fields::health)
+            size += sizeof(int);
+        return size;
+    }
+
+    // Writes the changed and removed unit lists; both inputs are ordered by id, so one merge pass
+    // finds changed, new and removed units
+    void write_unit_changes(std::vector<uint8_t> &section, const std::vector<UnitState> &current,
+                            const std::vector<UnitState> &previous)
+    {
+        std::vector<UnitID> removed;
+        size_t count_position = section.size();
+        uint32_t changed_count = 0;
+        write_to_vector(section, changed_count);
+        size_t i = 0;
+        size_t j = 0;
+        while (i < current.size() || j < previous.size())
+        {
+            if (j == previous.size() || (i < current.size() && current[i].id < previous[j].id))
+            {
+                write_unit(section, current[i++], snapshot_fields::all);
+                ++changed_count;
+            }
+            else if (i == current.size() || previous[j].id < current[i].id)
+            {
+                removed.push_back(previous[j++].id);
+            }
+            else
+            {
+                const UnitState &unit = current[i++];
+                const UnitState &old = previous[j++];
+                uint8_t fields = 0;
+                if (unit.owner != old.owner || unit.type != old.type)
+                    fields |= snapshot_fields::spawn;
+                if (unit.x != old.x || unit.y != old.y)
+                    fields |= snapshot_fields::position;
+                if (unit.health != old.health)
+                    fields |= snapshot_fields::health;
+                if (fields)
+                {
+                    write_unit(section, unit, fields);
+                    ++changed_count;
+                }
+            }
+        }
+        patch_count(section, count_position, changed_count);
+
+        write_to_vector(section, static_cast<uint32_t>(removed.size()));
+        for (UnitID id : removed)
+        {
+            write_to_vector(section, id);
+        }
+    }
+
+    void write_scores(std::vector<uint8_t> &section, const WorldSnapshot &snapshot, const WorldSnapshot *baseline)
+    {
+        size_t count_position = section.size();
+        uint16_t score_count = 0;
+        write_to_vector(section, score_count);
+        for (const auto &[player_id, score] : snapshot.scores)
+        {
+            if (baseline)
+            {
+                auto old = baseline->scores.find(player_id);
+                if (old != baseline->scores.end() && old->second == score)
+                {
+                    continue;
+                }
+            }
+            write_to_vector(section, player_id);
+            write_to_vector(section, score);
+            ++score_count;
+        }
+        patch_count(section, count_position, score_count);
+    }
+
+    bool contains_unit(const std::vector<UnitState> &units, UnitID id)
+    {
+        auto it = std::lower_bound(units.begin(), units.end(), id,
+                                   [](const UnitState &unit, UnitID value)
+                                   { return unit.id < value; });
+        return it != units.end() && it->id == id;
+    }
+
+    // The units whose ids are listed; both lists are ordered by id. Each search gallops forward
+    // from the last match, so the cost follows the ids listed rather than the size of the world.
+    void select_units(const std::vector<UnitState> &units, const std::vector<UnitID> &ids,
+                      std::vector<UnitState> &selected)
+    {
+        auto by_id = [](const UnitState &unit, UnitID value)
+        { return unit.id < value; };
+        selected.clear();
+        size_t position = 0;
+        for (UnitID id : ids)
+        {
+            size_t step = 1;
+            while (position + step < units.size() && units[position + step].id < id)
+            {
+                step *= 2;
+            }
+            auto first = units.begin() + position + step / 2;
+            auto last = units.begin() + std::min(position + step + 1, units.size());
+            auto it = std::lower_bound(first, last, id, by_id);
+            position = static_cast<size_t>(it - units.begin());
+            if (it != units.end() && it->id == id)
+            {
+                selected.push_back(*it);
+            }
+        }
+    }
+
+    struct UnitChange
+    {
+        UnitState unit;
+        uint8_t fields;
+    };
+
+    bool read_unit(const MessageView &message, size_t &offset, UnitChange &change)
+    {
+        if (!read_from_view(message, offset, change.unit.id) || !read_from_view(message, offset, change.fields))
+        {
+            return false;
+        }
+        if (change.fields & snapshot_fields::spawn)
+        {
+            uint8_t type = 0;
+            if (!read_from_view(message, offset, change.unit.owner) || !read_from_view(message, offset, type))
+            {
+                return false;
+            }
+            change.unit.type = static_cast<UnitType>(type);
+        }
+        if (change.fields & snapshot_fields::position)
+        {
+            if (!read_from_view(message, offset, change.unit.x) || !read_from_view(message, offset, change.unit.y))
+            {
+                return false;
+            }
+        }
+        if (change.fields & snapshot_fields::health)
+        {
+            if (!read_from_view(message, offset, change.unit.health))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+const WorldSnapshot &SnapshotEncoder::capture(const GameState &game_state, const ResourceManager &resource_manager)
+{
+    // Recycle the oldest snapshot's storage once the history is full
+    WorldSnapshot snapshot;
+    if (history_.size() >= max_history)
+    {
+        snapshot = std::move(history_.front());
+        history_.pop_front();
+        snapshot.units.clear();
+    }
+
+    snapshot.sequence = next_sequence_++;
+    snapshot.units.reserve(game_state.get_unit_count());
+    game_state.for_each_unit([&snapshot](const UnitState &unit)
+                             { snapshot.units.push_back(unit); });
+    snapshot.next_unit_id = game_state.get_next_unit_id();
+    snapshot.scores = game_state.get_player_scores();
+    snapshot.resources = resource_manager.get_player_resources();
+
+    history_.push_back(std::move(snapshot));
+    world_sections_.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(acks_mutex_);
+        for (PlayerID player_id : departed_)
+        {
+            views_.erase(player_id);
+        }
+        departed_.clear();
+    }
+    if (interest_)
+    {
+        interest_->rebuild(history_.back().units);
+    }
+    return history_.back();
+}
+
+void SnapshotEncoder::set_interest(InterestGrid *interest)
+{
+    // Clients hold snapshots filtered the old way; they get keyframes until they acknowledge a new one
+    interest_ = interest;
+    views_.clear();
+    first_baseline_ = next_sequence_;
+    if (interest_ && !history_.empty())
+    {
+        interest_->rebuild(history_.back().units);
+    }
+}
+
+Message SnapshotEncoder::encode(PlayerID player_id, const NameTable *resource_names, size_t byte_budget)
+{
+    const WorldSnapshot &snapshot = history_.back();
+
+    uint32_t acked_sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(acks_mutex_);
+        auto it = acked_.find(player_id);
+        if (it != acked_.end())
+        {
+            acked_sequence = it->second;
+        }
+    }
+    const WorldSnapshot *baseline = acked_sequence >= first_baseline_ ? find(acked_sequence) : nullptr;
+
+    // Once a client has been sent a filtered or budgeted snapshot, its baselines are no longer
+    // the shared world, so it stays on the per-client path
+    ClientView *view = nullptr;
+    const SentView *baseline_view = nullptr;
+    auto found = views_.find(player_id);
+    if (interest_ || byte_budget || found != views_.end())
+    {
+        view = found != views_.end() ? &found->second : &views_[player_id];
+        // Acks only move forward, so views older than the acknowledged one are never needed again
+        auto &sent = view->sent;
+        while (!sent.empty() && (sent.front().sequence < acked_sequence || sent.size() >= max_history))
+        {
+            sent.pop_front();
+        }
+        if (baseline && !sent.empty() && sent.front().sequence == baseline->sequence)
+        {
+            baseline_view = &sent.front();
+        }
+        else
+        {
+            baseline = nullptr;
+        }
+    }
+
+    Message message;
+    message.type = MessageType::ResourceUpdate;
+    message.player_id = player_id;
+    write_to_vector(message.data, snapshot.sequence);
+    write_to_vector(message.data, baseline ? baseline->sequence : uint32_t{0});
+    if (!baseline)
+    {
+        write_to_vector(message.data, snapshot.next_unit_id);
+    }
+
+    // Scores and resources follow the units, but are written first so the units know what is
+    // left of the budget. Resources are private to each player, so this is always per client.
+    tail_.clear();
+    if (view)
+    {
+        write_scores(tail_, snapshot, baseline);
+    }
+    const auto &current = resources_of(snapshot, player_id);
+    const auto &previous = baseline ? resources_of(*baseline, player_id) : no_resources;
+    size_t count_position = tail_.size();
+    uint16_t resource_count = 0;
+    write_to_vector(tail_, resource_count);
+    for (const auto &[name, amount] : current)
+    {
+        auto it = previous.find(name);
+        if (it != previous.end() && it->second == amount)
+        {
+            continue;
+        }
+        if (resource_names)
+        {
+            NameID id = resource_names->find(name);
+            if (id == NameTable::invalid_id)
+            {
+                continue;
+            }
+            write_to_vector(tail_, id);
+        }
+        else
+        {
+            write_string(tail_, name);
+        }
+        write_to_vector(tail_, amount);
+        ++resource_count;
+    }
+    patch_count(tail_, count_position, resource_count);
+
+    if (view)
+    {
+        size_t used = message.data.size() + tail_.size();
+        size_t unit_budget = !byte_budget ? SIZE_MAX : byte_budget > used ? byte_budget - used : 0;
+        write_client_units(message.data, player_id, *view, baseline, baseline_view, unit_budget);
+    }
+    else
+    {
+        const auto &section = world_section(baseline);
+        message.data.insert(message.data.end(), section.begin(), section.end());
+    }
+    message.data.insert(message.data.end(), tail_.begin(), tail_.end());
+
+    ++(baseline ? stats_.deltas : stats_.keyframes);
+    stats_.bytes += message.data.size();
+    return message;
+}
+
+void SnapshotEncoder::acknowledge(PlayerID player_id, uint32_t sequence)
+{
+    // Acks can arrive out of order; only ever move forward
+    std::lock_guard<std::mutex> lock(acks_mutex_);
+    auto &acked = acked_[player_id];
+    acked = std::max(acked, sequence);
+}
+
+void SnapshotEncoder::remove_client(PlayerID player_id)
+{
+    std::lock_guard<std::mutex> lock(acks_mutex_);
+    acked_.erase(player_id);
+    departed_.push_back(player_id);
+}
+
+size_t SnapshotEncoder::get_memory_usage()
+{
+    size_t bytes = memory_usage::of(history_) + memory_usage::of(world_sections_) + memory_usage::of(views_);
+    for (const auto &snapshot : history_)
+    {
+        bytes += memory_usage::of(snapshot.units) + memory_usage::of(snapshot.scores) +
+                 memory_usage::of(snapshot.resources);
+        for (const auto &[player_id, resources] : snapshot.resources)
+        {
+            bytes += memory_usage::of(resources);
+        }
+    }
+    for (const auto &[sequence, section] : world_sections_)
+    {
+        bytes += memory_usage::of(section);
+    }
+    for (const auto &[player_id, view] : views_)
+    {
+        bytes += memory_usage::of(view.sent) + memory_usage::of(view.priorities);
+        for (const auto &sent : view.sent)
+        {
+            bytes += memory_usage::of(sent.visible) + memory_usage::of(sent.stale);
+        }
+    }
+    bytes += memory_usage::of(visible_) + memory_usage::of(visible_units_) + memory_usage::of(baseline_units_) +
+             memory_usage::of(changes_) + memory_usage::of(by_priority_) + memory_usage::of(removed_) +
+             memory_usage::of(held_back_) + memory_usage::of(tail_);
+
+    std::lock_guard<std::mutex> lock(acks_mutex_);
+    return bytes + memory_usage::of(acked_) + memory_usage::of(departed_);
+}
+
+const WorldSnapshot *SnapshotEncoder::find(uint32_t sequence) const
+{
+    if (history_.empty() || sequence < history_.front().sequence || sequence > history_.back().sequence)
+    {
+        return nullptr;
+    }
+    return &history_[sequence - history_.front().sequence];
+}
+
+const std::vector<uint8_t> &SnapshotEncoder::world_section(const WorldSnapshot *baseline)
+{
+    auto [it, inserted] = world_sections_.try_emplace(baseline ? baseline->sequence : 0);
+    std::vector<uint8_t> &section = it->second;
+    if (!inserted)
+    {
+        return section;
+    }
+
+    const WorldSnapshot &snapshot = history_.back();
+    static const std::vector<UnitState> no_units;
+    write_unit_changes(section, snapshot.units, baseline ? baseline->units : no_units);
+    write_scores(section, snapshot, baseline);
+    return section;
+}
+
+void SnapshotEncoder::write_client_units(std::vector<uint8_t> &data, PlayerID player_id, ClientView &view,
+                                         const WorldSnapshot *baseline, const SentView *baseline_view,
+                                         size_t unit_budget)
+{
+    const WorldSnapshot &snapshot = history_.back();
+    if (interest_)
+    {
+        interest_->visible_units(player_id, visible_);
+    }
+    else
+    {
+        visible_.clear();
+        for (const UnitState &unit : snapshot.units)
+        {
+            visible_.push_back(unit.id);
+        }
+    }
+    select_units(snapshot.units, visible_, visible_units_);
+
+    // What the client holds at the baseline: the units it could see then, with the state it was
+    // last sent for any whose update was held back
+    baseline_units_.clear();
+    if (baseline)
+    {
+        select_units(baseline->units, baseline_view->visible, baseline_units_);
+        auto stale = baseline_view->stale.begin();
+        for (UnitState &unit : baseline_units_)
+        {
+            while (stale != baseline_view->stale.end() && stale->id < unit.id)
+            {
+                ++stale;
+            }
+            if (stale != baseline_view->stale.end() && stale->id == unit.id)
+            {
+                unit = *stale;
+            }
+        }
+    }
+
+    // Merge the two id-ordered lists into candidate updates and removals
+    changes_.clear();
+    removed_.clear();
+    size_t change_bytes = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < visible_units_.size() || j < baseline_units_.size())
+    {
+        if (j == baseline_units_.size() || (i < visible_units_.size() && visible_units_[i].id < baseline_units_[j].id))
+        {
+            changes_.push_back({static_cast<uint32_t>(i++), no_baseline, snapshot_fields::all});
+        }
+        else if (i == visible_units_.size() || baseline_units_[j].id < visible_units_[i].id)
+        {
+            removed_.push_back(baseline_units_[j++].id);
+        }
+        else
+        {
+            const UnitState &unit = visible_units_[i];
+            const UnitState &old = baseline_units_[j];
+            uint8_t fields = 0;
+            if (unit.owner != old.owner || unit.type != old.type)
+                fields |= snapshot_fields::spawn;
+            if (unit.x != old.x || unit.y != old.y)
+                fields |= snapshot_fields::position;
+            if (unit.health != old.health)
+                fields |= snapshot_fields::health;
+            if (fields)
+            {
+                changes_.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(j), fields});
+            }
+            ++i;
+            ++j;
+        }
+    }
+    for (Change &change : changes_)
+    {
+        change.size = unit_record_size(change.fields);
+        change_bytes += change.size;
+    }
+
+    // Removals are always sent; they are small and only shrink what the client holds
+    size_t removed_bytes = 2 * sizeof(uint32_t) + removed_.size() * sizeof(UnitID);
+    bool over_budget = change_bytes + removed_bytes > unit_budget;
+    if (over_budget)
+    {
+        prioritise(player_id, view);
+        size_t left = unit_budget > removed_bytes ? unit_budget - removed_bytes : 0;
+        for (uint32_t index : by_priority_)
+        {
+            Change &change = changes_[index];
+            if (change.size <= left)
+            {
+                change.send = true;
+                left -= change.size;
+            }
+        }
+    }
+
+    SentView next;
+    next.sequence = snapshot.sequence;
+    std::vector<std::pair<UnitID, float>> priorities;
+    size_t count_position = data.size();
+    uint32_t changed_count = 0;
+    write_to_vector(data, changed_count);
+    for (const Change &change : changes_)
+    {
+        const UnitState &unit = visible_units_[change.index];
+        if (!over_budget || change.send)
+        {
+            write_unit(data, unit, change.fields);
+            ++changed_count;
+            if (interest_ && change.baseline == no_baseline && baseline && contains_unit(baseline->units, unit.id))
+            {
+                ++stats_.interest_enters;
+            }
+            continue;
+        }
+
+        // Held back: the client keeps what it had, or still lacks the unit if it is new to it
+        priorities.emplace_back(unit.id, change.priority);
+        if (change.baseline == no_baseline)
+        {
+            held_back_.push_back(unit.id);
+        }
+        else
+        {
+            next.stale.push_back(baseline_units_[change.baseline]);
+        }
+        ++stats_.units_deferred;
+    }
+    patch_count(data, count_position, changed_count);
+
+    write_to_vector(data, static_cast<uint32_t>(removed_.size()));
+    for (UnitID id : removed_)
+    {
+        write_to_vector(data, id);
+        stats_.interest_leaves += interest_ && contains_unit(snapshot.units, id);
+    }
+
+    if (held_back_.empty())
+    {
+        next.visible = visible_;
+    }
+    else
+    {
+        std::set_difference(visible_.begin(), visible_.end(), held_back_.begin(), held_back_.end(),
+                            std::back_inserter(next.visible));
+        held_back_.clear();
+    }
+    view.priorities = std::move(priorities);
+    view.sent.push_back(std::move(next));
+}
+
+void SnapshotEncoder::prioritise(PlayerID player_id, const ClientView &view)
+{
+    // Units near the middle of the camera matter most; without one, distance is left out
+    CameraRect camera;
+    bool has_camera = interest_ && interest_->get_camera(player_id, camera);
+    int64_t focus_x = int64_t{camera.x} + camera.width / 2;
+    int64_t focus_y = int64_t{camera.y} + camera.height / 2;
+
+    // Each held-back unit carries the priority it built up; both lists are in id order
+    auto accumulated = view.priorities.begin();
+    by_priority_.clear();
+    for (uint32_t k = 0; k < changes_.size(); ++k)
+    {
+        Change &change = changes_[k];
+        const UnitState &unit = visible_units_[change.index];
+        float weight = unit.owner == player_id ? 2.0f : 1.0f;
+        if (change.baseline != no_baseline)
+        {
+            int damage = baseline_units_[change.baseline].health - unit.health;
+            weight *= 1.0f + std::max(damage, 0) / 20.0f;
+        }
+        if (has_camera)
+        {
+            int64_t distance = std::max(std::abs(unit.x - focus_x), std::abs(unit.y - focus_y));
+            weight *= 32.0f / (32.0f + static_cast<float>(distance));
+        }
+
+        while (accumulated != view.priorities.end() && accumulated->first < unit.id)
+        {
+            ++accumulated;
+        }
+        change.priority = weight;
+        if (accumulated != view.priorities.end() && accumulated->first == unit.id)
+        {
+            change.priority += accumulated->second;
+        }
+        by_priority_.push_back(k);
+    }
+    std::sort(by_priority_.begin(), by_priority_.end(), [this](uint32_t a, uint32_t b)
+              { return changes_[a].priority > changes_[b].priority; });
+}
+
+bool SnapshotDecoder::apply(const MessageView &message)
+{
+    size_t offset = 0;
+    uint32_t sequence = 0;
+    uint32_t baseline_sequence = 0;
+    UnitID next_unit_id = 0;
+    if (!read_from_view(message, offset, sequence) || !read_from_view(message, offset, baseline_sequence) ||
+        (baseline_sequence == 0 && !read_from_view(message, offset, next_unit_id)))
+    {
+        return false;
+    }
+
+    const WorldSnapshot *baseline = nullptr;
+    if (baseline_sequence != 0)
+    {
+        auto it = std::find_if(received_.rbegin(), received_.rend(),
+                               [baseline_sequence](const WorldSnapshot &snapshot)
+                               { return snapshot.sequence == baseline_sequence; });
+        if (it == received_.rend())
+        {
+            return false;
+        }
+        baseline = &*it;
+    }
+
+    uint32_t changed_count = 0;
+    if (!read_from_view(message, offset, changed_count))
+    {
+        return false;
+    }
+    std::vector<UnitChange> changes(std::min<size_t>(changed_count, message.size / sizeof(UnitID)));
+    if (changes.size() != changed_count)
+    {
+        return false;
+    }
+    for (auto &change : changes)
+    {
+        if (!read_unit(message, offset, change))
+        {
+            return false;
+        }
+    }
+
+    uint32_t removed_count = 0;
+    if (!read_from_view(message, offset, removed_count) || (message.size - offset) / sizeof(UnitID) < removed_count)
+    {
+        return false;
+    }
+    std::vector<UnitID> removed(removed_count);
+    for (auto &id : removed)
+    {
+        read_from_view(message, offset, id);
+    }
+
+    WorldSnapshot snapshot;
+    snapshot.sequence = sequence;
+    snapshot.next_unit_id = next_unit_id;
+    if (baseline)
+    {
+        snapshot.scores = baseline->scores;
+        snapshot.resources = baseline->resources;
+    }
+
+    // Merge the id-ordered changes into the baseline's id-ordered units
+    static const std::vector<UnitState> no_units;
+    const auto &previous = baseline ? baseline->units : no_units;
+    snapshot.units.reserve(previous.size() + changes.size());
+    size_t i = 0;
+    size_t j = 0;
+    while (i < previous.size() || j < changes.size())
+    {
+        if (j == changes.size() || (i < previous.size() && previous[i].id < changes[j].unit.id))
+        {
+            const UnitState &unit = previous[i++];
+            if (!std::binary_search(removed.begin(), removed.end(), unit.id))
+            {
+                snapshot.units.push_back(unit);
+            }
+        }
+        else if (i == previous.size() || changes[j].unit.id < previous[i].id)
+        {
+            // A unit the client has not seen must arrive whole
+            if (changes[j].fields != snapshot_fields::all)
+            {
+                return false;
+            }
+            snapshot.units.push_back(changes[j++].unit);
+        }
+        else
+        {
+            UnitState unit = previous[i++];
+            const UnitChange &change = changes[j++];
+            if (change.fields & snapshot_fields::spawn)
+            {
+                unit.owner = change.unit.owner;
+                unit.type = change.unit.type;
+            }
+            if (change.fields & snapshot_fields::position)
+            {
+                unit.x = change.unit.x;
+                unit.y = change.unit.y;
+            }
+            if (change.fields & snapshot_fields::health)
+            {
+                unit.health = change.unit.health;
+            }
+            snapshot.units.push_back(unit);
+        }
+    }
+
+    uint16_t score_count = 0;
+    if (!read_from_view(message, offset, score_count))
+    {
+        return false;
+    }
+    for (uint16_t k = 0; k < score_count; ++k)
+    {
+        PlayerID player_id = 0;
+        int score = 0;
+        if (!read_from_view(message, offset, player_id) || !read_from_view(message, offset, score))
+        {
+            return false;
+        }
+        snapshot.scores[player_id] = score;
+    }
+
+    uint16_t resource_count = 0;
+    if (!read_from_view(message, offset, resource_count))
+    {
+        return false;
+    }
+    auto &resources = snapshot.resources[player_id_];
+    for (uint16_t k = 0; k < resource_count; ++k)
+    {
+        std::string name;
+        int amount = 0;
+        if (resource_names_)
+        {
+            NameID id = 0;
+            const std::string *interned = nullptr;
+            if (!read_from_view(message, offset, id) || !(interned = resource_names_->get_name(id)))
+            {
+                return false;
+            }
+            name = *interned;
+        }
+        else if (!read_string(message, offset, name))
+        {
+            return false;
+        }
+        if (!read_from_view(message, offset, amount))
+        {
+            return false;
+        }
+        resources[name] = amount;
+    }
+
+    received_.push_back(std::move(snapshot));
+    if (received_.size() > SnapshotEncoder::max_history)
+    {
+        received_.pop_front();
+    }
+    return true;
+}
\ No newline at end of file
@@ -1,38 +1,37 @@
 #include "server/timer.hpp"
+#include "utils/memory_usage.hpp"
+#include <algorithm>
 
-Timer::Timer() : last_update_(std::chrono::steady_clock::now()) {}
+Timer::Timer() : origin_(Clock::now()), last_update_(origin_)
+{
+    links_.resize(first_timer_link);
+    for (uint32_t head = 0; head < first_timer_link; ++head)
+    {
+        links_[head] = {head, head};
+    }
+}
 
 Timer::~Timer() = default;
 
 TimerID Timer::set_timeout(float seconds, TimerCallback callback)
 {
-    TimerID id = generate_timer_id();
-    auto now = std::chrono::steady_clock::now();
-    TimerData timer_data{
-        now + std::chrono::microseconds(static_cast<int64_t>(seconds * 1000000)),
-        seconds,
-        std::move(callback),
-        false};
-    timers_[id] = std::move(timer_data);
-    return id;
+    return add_timer(seconds, std::move(callback), false);
 }
 
 TimerID Timer::set_interval(float seconds, TimerCallback callback)
 {
-    TimerID id = generate_timer_id();
-    auto now = std::chrono::steady_clock::now();
-    TimerData timer_data{
-        now + std::chrono::microseconds(static_cast<int64_t>(seconds * 1000000)),
-        seconds,
-        std::move(callback),
-        true};
-    timers_[id] = std::move(timer_data);
-    return id;
+    return add_timer(seconds, std::move(callback), true);
 }
 
 void Timer::clear_timer(TimerID timer_id)
 {
-    timers_.erase(timer_id);
+    uint32_t index = static_cast<uint32_t>(timer_id);
+    if (index >= timers_.size() || !timers_[index].active || timers_[index].generation != timer_id >> 32)
+    {
+        return;
+    }
+    unlink(first_timer_link + index);
+    release(index);
 }
 
 void Timer::update()
@@ -42,37 +41,24 @@ void Timer::update()
         return;
     }
 
-    auto now = std::chrono::steady_clock::now();
+    auto now = Clock::now();
     std::chrono::duration<float> elapsed = now - last_update_;
     elapsed_time_ += elapsed.count();
     last_update_ = now;
+    advance_to(now);
+}
 
-    std::vector<TimerID> completed_timers;
-
-    for (auto &[id, timer] : timers_)
+void Timer::update(float delta_time)
+{
+    game_time_ = true;
+    if (is_paused_)
     {
-        if (now >= timer.next_trigger)
-        {
-            timer.callback();
-
-            if (timer.is_repeating)
-            {
-                // Schedule next trigger
-                timer.next_trigger += std::chrono::microseconds(
-                    static_cast<int64_t>(timer.interval * 1000000));
-            }
-            else
-            {
-                completed_timers.push_back(id);
-            }
-        }
+        return;
     }
 
-    // Remove completed non-repeating timers
-    for (auto id : completed_timers)
-    {
-        timers_.erase(id);
-    }
+    elapsed_time_ += delta_time;
+    last_update_ += std::chrono::microseconds(static_cast<int64_t>(delta_time * 1000000));
+    advance_to(last_update_);
 }
 
 void Timer::pause()
@@ -88,7 +74,11 @@ void Timer::resume()
     if (is_paused_)
     {
         is_paused_ = false;
-        last_update_ = std::chrono::steady_clock::now();
+        // Game time stood still while paused; wall time has to skip the gap
+        if (!game_time_)
+        {
+            last_update_ = Clock::now();
+        }
     }
 }
 
@@ -97,7 +87,171 @@ float Timer::get_elapsed_time() const
     return elapsed_time_;
 }
 
-TimerID Timer::generate_timer_id()
+TimerID Timer::add_timer(float seconds, TimerCallback callback, bool is_repeating)
+{
+    uint32_t index;
+    if (!free_timers_.empty())
+    {
+        index = free_timers_.back();
+        free_timers_.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(timers_.size());
+        timers_.emplace_back();
+        links_.push_back({first_timer_link + index, first_timer_link + index});
+    }
+
+    TimerData &timer = timers_[index];
+    timer.callback = std::move(callback);
+    timer.interval = std::chrono::microseconds(static_cast<int64_t>(seconds * 1000000));
+    timer.next_trigger = now() + timer.interval;
+    timer.is_repeating = is_repeating;
+    timer.active = true;
+    ++active_count_;
+    place(index);
+    return (static_cast<TimerID>(timer.generation) << 32) | index;
+}
+
+Timer::Clock::time_point Timer::now() const
+{
+    return game_time_ ? last_update_ : Clock::now();
+}
+
+void Timer::advance_to(Clock::time_point now)
+{
+    if (now < origin_)
+    {
+        return;
+    }
+    uint64_t target = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - origin_).count());
+    while (current_tick_ <= target)
+    {
+        if (active_count_ == 0)
+        {
+            current_tick_ = target + 1;
+            break;
+        }
+        run_tick();
+    }
+}
+
+void Timer::run_tick()
+{
+    uint64_t tick = current_tick_;
+    uint32_t slot = static_cast<uint32_t>(tick & (slots_per_level - 1));
+
+    // When a level's slot index wraps, the next slot up comes within range of the level below
+    for (uint32_t level = 1; slot == 0 && level < level_count; ++level)
+    {
+        uint32_t index = static_cast<uint32_t>((tick >> (level_bits * level)) & (slots_per_level - 1));
+        cascade(level, index);
+        if (index != 0)
+        {
+            break;
+        }
+    }
+
+    // Take the slot's timers off it before firing, so callbacks can add and clear timers freely;
+    // anything added now goes in a later tick
+    while (links_[slot].next != slot)
+    {
+        uint32_t link_index = links_[slot].next;
+        unlink(link_index);
+        link(firing_head, link_index);
+    }
+    current_tick_ = tick + 1;
+
+    while (links_[firing_head].next != firing_head)
+    {
+        uint32_t index = links_[firing_head].next - first_timer_link;
+        unlink(first_timer_link + index);
+
+        TimerCallback callback = std::move(timers_[index].callback);
+        uint32_t generation = timers_[index].generation;
+        callback();
+
+        // The callback may have cleared this timer, or added others and moved timers_
+        TimerData &timer = timers_[index];
+        if (!timer.active || timer.generation != generation)
+        {
+            continue;
+        }
+        if (timer.is_repeating)
+        {
+            timer.callback = std::move(callback);
+            timer.next_trigger += timer.interval;
+            place(index);
+        }
+        else
+        {
+            release(index);
+        }
+    }
+}
+
+void Timer::cascade(uint32_t level, uint32_t slot)
+{
+    uint32_t head = level * slots_per_level + slot;
+    while (links_[head].next != head)
+    {
+        uint32_t link_index = links_[head].next;
+        unlink(link_index);
+        place(link_index - first_timer_link);
+    }
+}
+
+void Timer::place(uint32_t index)
+{
+    TimerData &timer = timers_[index];
+
+    // Rounded up, so a timer never fires early
+    auto offset = std::chrono::ceil<std::chrono::milliseconds>(timer.next_trigger - origin_);
+    uint64_t due = offset.count() > 0 ? static_cast<uint64_t>(offset.count()) : 0;
+    timer.due_tick = std::max(due, current_tick_);
+
+    uint64_t delta = timer.due_tick - current_tick_;
+    uint32_t level = 0;
+    while (level + 1 < level_count && delta >> (level_bits * (level + 1)))
+    {
+        ++level;
+    }
+    // Past the top level's reach, park in its furthest slot and place again when it cascades
+    uint64_t slot_tick = std::min(timer.due_tick, current_tick_ + (uint64_t{1} << (level_bits * level_count)) - 1);
+    uint32_t slot = static_cast<uint32_t>((slot_tick >> (level_bits * level)) & (slots_per_level - 1));
+    link(level * slots_per_level + slot, first_timer_link + index);
+}
+
+void Timer::link(uint32_t head, uint32_t index)
+{
+    uint32_t tail = links_[head].prev;
+    links_[index] = {tail, head};
+    links_[tail].next = index;
+    links_[head].prev = index;
+}
+
+void Timer::unlink(uint32_t index)
+{
+    Link &entry = links_[index];
+    links_[entry.prev].next = entry.next;
+    links_[entry.next].prev = entry.prev;
+    entry = {index, index};
+}
+
+void Timer::release(uint32_t index)
+{
+    TimerData &timer = timers_[index];
+    timer.callback.reset();
+    timer.active = false;
+    if (++timer.generation == 0)
+    {
+        timer.generation = 1;
+    }
+    free_timers_.push_back(index);
+    --active_count_;
+}
+
+size_t Timer::get_memory_usage() const
 {
-    return next_timer_id_++;
+    return memory_usage::of(timers_) + memory_usage::of(links_) + memory_usage::of(free_timers_);
 }
\ No newline at end of file
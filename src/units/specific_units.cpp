@@ -50,7 +50,6 @@ void Healer::heal_target(Unit *target)
 {
     if (target && target->get_health() < target->get_max_health())
     {
-        int heal_amount = 20;              // Base healing amount
         target->take_damage(-heal_amount); // Negative damage = healing
     }
 }
@@ -0,0 +1,300 @@
+#include "units/unit_store.hpp"
+#include "units/specific_units.hpp"
+#include "utils/memory_usage.hpp"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    constexpr size_t unit_type_count = static_cast<size_t>(UnitType::Scout) + 1;
+
+    // Read from the unit classes, so each type's numbers live in one place
+    template <typename UnitClass>
+    void add_type(std::array<UnitTypeInfo, unit_type_count> &table, UnitType type)
+    {
+        UnitTypeInfo &info = table[static_cast<size_t>(type)];
+        info.base_stats = UnitClass::get_base_stats();
+        info.trainable = true;
+        info.can_attack = UnitClass::attacks;
+        info.can_harvest = UnitClass::harvests;
+        info.heal_amount = UnitClass::heal_amount;
+    }
+
+    std::array<UnitTypeInfo, unit_type_count> make_type_table()
+    {
+        std::array<UnitTypeInfo, unit_type_count> table;
+        add_type<Peasant>(table, UnitType::Peasant);
+        add_type<Soldier>(table, UnitType::Soldier);
+        add_type<Archer>(table, UnitType::Archer);
+        add_type<Knight>(table, UnitType::Knight);
+        add_type<Healer>(table, UnitType::Healer);
+        add_type<Scout>(table, UnitType::Scout);
+        return table;
+    }
+
+    template <typename T>
+    void swap_remove(std::vector<T> &values, size_t index)
+    {
+        values[index] = values.back();
+        values.pop_back();
+    }
+}
+
+const UnitTypeInfo &UnitStore::type_info(UnitType type)
+{
+    static const std::array<UnitTypeInfo, unit_type_count> table = make_type_table();
+    static const UnitTypeInfo unknown;
+    size_t index = static_cast<size_t>(type);
+    return index < table.size() ? table[index] : unknown;
+}
+
+UnitStore::Handle UnitStore::spawn(UnitType type, PlayerID owner, int x, int y)
+{
+    return spawn(type, owner, x, y, type_info(type).base_stats);
+}
+
+UnitStore::Handle UnitStore::spawn(UnitType type, PlayerID owner, int x, int y, const UnitStats &stats)
+{
+    if (!type_info(type).trainable)
+    {
+        return invalid_handle;
+    }
+
+    Handle handle = slots_.allocate();
+    if (handle == invalid_handle)
+    {
+        return invalid_handle;
+    }
+
+    size_t index = type_.size();
+    type_.push_back(type);
+    owner_.push_back(owner);
+    x_.push_back(x);
+    y_.push_back(y);
+    destination_x_.push_back(x);
+    destination_y_.push_back(y);
+    health_.push_back(stats.max_health);
+    max_health_.push_back(0);
+    attack_.push_back(0);
+    armor_.push_back(0);
+    speed_.push_back(0);
+    set_stats(index, stats);
+    return handle;
+}
+
+bool UnitStore::remove(Handle handle)
+{
+    size_t index = slots_.remove(handle);
+    if (index == no_index)
+    {
+        return false;
+    }
+
+    swap_remove(type_, index);
+    swap_remove(owner_, index);
+    swap_remove(x_, index);
+    swap_remove(y_, index);
+    swap_remove(destination_x_, index);
+    swap_remove(destination_y_, index);
+    swap_remove(health_, index);
+    swap_remove(max_health_, index);
+    swap_remove(attack_, index);
+    swap_remove(armor_, index);
+    swap_remove(speed_, index);
+    return true;
+}
+
+void UnitStore::clear()
+{
+    slots_.clear();
+    type_.clear();
+    owner_.clear();
+    x_.clear();
+    y_.clear();
+    destination_x_.clear();
+    destination_y_.clear();
+    health_.clear();
+    max_health_.clear();
+    attack_.clear();
+    armor_.clear();
+    speed_.clear();
+}
+
+void UnitStore::update()
+{
+    // Plain loops over int arrays; the compiler vectorises them
+    const size_t count = x_.size();
+    int *x = x_.data();
+    int *y = y_.data();
+    const int *destination_x = destination_x_.data();
+    const int *destination_y = destination_y_.data();
+    const int *speed = speed_.data();
+    for (size_t i = 0; i < count; ++i)
+    {
+        x[i] += std::clamp(destination_x[i] - x[i], -speed[i], speed[i]);
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        y[i] += std::clamp(destination_y[i] - y[i], -speed[i], speed[i]);
+    }
+}
+
+void UnitStore::set_destination(Handle handle, int x, int y)
+{
+    size_t index = index_of(handle);
+    if (index != no_index)
+    {
+        destination_x_[index] = x;
+        destination_y_[index] = y;
+    }
+}
+
+void UnitStore::take_damage(Handle handle, int damage)
+{
+    size_t index = index_of(handle);
+    if (index != no_index)
+    {
+        apply_damage(index, damage);
+    }
+}
+
+bool UnitStore::attack(Handle attacker, Handle target)
+{
+    size_t attacker_index = index_of(attacker);
+    size_t target_index = index_of(target);
+    if (attacker_index == no_index || target_index == no_index || !type_info(type_[attacker_index]).can_attack)
+    {
+        return false;
+    }
+    apply_damage(target_index, attack_[attacker_index]);
+    return true;
+}
+
+bool UnitStore::heal(Handle healer, Handle target)
+{
+    size_t healer_index = index_of(healer);
+    size_t target_index = index_of(target);
+    if (healer_index == no_index || target_index == no_index)
+    {
+        return false;
+    }
+    int heal_amount = type_info(type_[healer_index]).heal_amount;
+    if (heal_amount <= 0 || health_[target_index] >= max_health_[target_index])
+    {
+        return false;
+    }
+    apply_damage(target_index, -heal_amount);
+    return true;
+}
+
+size_t UnitStore::remove_dead()
+{
+    size_t removed = 0;
+    for (size_t i = 0; i < health_.size();)
+    {
+        if (health_[i] > 0)
+        {
+            ++i;
+            continue;
+        }
+        // The last unit moves into i, so look at i again
+        remove(handle_at(i));
+        ++removed;
+    }
+    return removed;
+}
+
+UnitRef UnitStore::get(Handle handle)
+{
+    return UnitRef(*this, handle);
+}
+
+size_t UnitStore::get_memory_usage() const
+{
+    return slots_.get_memory_usage() + memory_usage::of(type_) + memory_usage::of(owner_) + memory_usage::of(x_) +
+           memory_usage::of(y_) + memory_usage::of(destination_x_) + memory_usage::of(destination_y_) +
+           memory_usage::of(health_) + memory_usage::of(max_health_) + memory_usage::of(attack_) +
+           memory_usage::of(armor_) + memory_usage::of(speed_);
+}
+
+void UnitStore::set_stats(size_t index, const UnitStats &stats)
+{
+    max_health_[index] = stats.max_health;
+    attack_[index] = stats.attack;
+    armor_[index] = stats.armor;
+    speed_[index] = stats.speed;
+    health_[index] = std::min(health_[index], stats.max_health);
+}
+
+void UnitStore::apply_damage(size_t index, int damage)
+{
+    if (damage > 0)
+    {
+        health_[index] = std::max(0, health_[index] - std::max(1, damage - armor_[index]));
+    }
+    else
+    {
+        health_[index] = std::min(max_health_[index], health_[index] - damage);
+    }
+}
+
+void UnitRef::move(int dx, int dy)
+{
+    size_t index = store_->index_of(handle_);
+    if (index != UnitStore::no_index)
+    {
+        store_->x_[index] += dx * store_->speed_[index];
+        store_->y_[index] += dy * store_->speed_[index];
+        store_->destination_x_[index] = store_->x_[index];
+        store_->destination_y_[index] = store_->y_[index];
+    }
+}
+
+UnitStats UnitRef::get_stats() const
+{
+    size_t index = store_->index_of(handle_);
+    if (index == UnitStore::no_index)
+    {
+        return UnitStats(0, 0, 0, 0, 0, 0);
+    }
+    const UnitStats &base = UnitStore::type_info(store_->type_[index]).base_stats;
+    return UnitStats(store_->max_health_[index], store_->attack_[index], store_->armor_[index],
+                     store_->speed_[index], base.cost_gold, base.cost_lumber);
+}
+
+void UnitRef::modify_stats(const UnitStats &new_stats)
+{
+    size_t index = store_->index_of(handle_);
+    if (index != UnitStore::no_index)
+    {
+        store_->set_stats(index, new_stats);
+    }
+}
+
+void UnitRef::set_position(int new_x, int new_y)
+{
+    size_t index = store_->index_of(handle_);
+    if (index != UnitStore::no_index)
+    {
+        store_->x_[index] = new_x;
+        store_->y_[index] = new_y;
+        store_->destination_x_[index] = new_x;
+        store_->destination_y_[index] = new_y;
+    }
+}
+
+void UnitRef::set_health(int health)
+{
+    size_t index = store_->index_of(handle_);
+    if (index != UnitStore::no_index)
+    {
+        store_->health_[index] = health;
+    }
+}
+
+void UnitRef::get_position(int &out_x, int &out_y) const
+{
+    size_t index = store_->index_of(handle_);
+    out_x = index != UnitStore::no_index ? store_->x_[index] : 0;
+    out_y = index != UnitStore::no_index ? store_->y_[index] : 0;
+}
\ No newline at end of file
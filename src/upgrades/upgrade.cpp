@@ -1,5 +1,6 @@
 #include "upgrades/upgrade.hpp"
 #include "server/game_state.hpp"
+#include "utils/memory_usage.hpp"
 #include <cmath>
 
 Upgrade::Upgrade(const std::string &name, const std::string &description)
@@ -101,4 +102,19 @@ float Upgrade::get_total_modifier(const std::string &attribute) const
     }
 
     return total_modifier;
+}
+
+size_t Upgrade::get_memory_usage() const
+{
+    size_t bytes = sizeof(*this) + memory_usage::of(name_) + memory_usage::of(description_) +
+                   memory_usage::of(requirements_) + memory_usage::of(base_effects_);
+    for (const auto &requirement : requirements_)
+    {
+        bytes += memory_usage::of(requirement.technology_name) + memory_usage::of(requirement.resource_costs);
+    }
+    for (const auto &effect : base_effects_)
+    {
+        bytes += memory_usage::of(effect.attribute);
+    }
+    return bytes;
 }
\ No newline at end of file
@@ -1,7 +1,30 @@
 #include "upgrades/upgrade_manager.hpp"
+#include "utils/memory_usage.hpp"
 #include <algorithm>
 
-UpgradeManager::UpgradeManager() {}
+namespace
+{
+    std::vector<std::string> to_names(const std::vector<NameID> &ids, const NameTable &table)
+    {
+        std::vector<std::string> names;
+        names.reserve(ids.size());
+        for (NameID id : ids)
+        {
+            names.push_back(*table.get_name(id));
+        }
+        return names;
+    }
+}
+
+UpgradeManager::UpgradeManager()
+    : upgrade_names_({"weapon", "armor", "training", "resource", "defense"}),
+      technology_names_({"Basic Smithing",
+                         "Basic Armory",
+                         "Military Tactics",
+                         "Economic Development",
+                         "Construction Mastery"})
+{
+}
 
 void UpgradeManager::initialize_player_upgrades(PlayerID player_id)
 {
@@ -12,11 +35,11 @@ void UpgradeManager::initialize_player_upgrades(PlayerID player_id)
 
     PlayerUpgrades upgrades;
     // Initialize with all available upgrade types
-    upgrades.upgrades["weapon"] = std::make_unique<WeaponUpgrade>();
-    upgrades.upgrades["armor"] = std::make_unique<ArmorUpgrade>();
-    upgrades.upgrades["training"] = std::make_unique<TrainingUpgrade>();
-    upgrades.upgrades["resource"] = std::make_unique<ResourceUpgrade>();
-    upgrades.upgrades["defense"] = std::make_unique<DefenseUpgrade>();
+    for (const auto &name : upgrade_names_.get_names())
+    {
+        upgrades.upgrades.push_back(create_upgrade(name));
+    }
+    upgrades.completed_technologies.resize(technology_names_.size(), false);
 
     player_upgrades_[player_id] = std::move(upgrades);
 }
@@ -36,136 +59,151 @@ std::unique_ptr<Upgrade> UpgradeManager::create_upgrade(const std::string &upgra
     return nullptr;
 }
 
-bool UpgradeManager::purchase_upgrade(PlayerID player_id, const std::string &upgrade_name)
+const Upgrade *UpgradeManager::find_upgrade(PlayerID player_id, NameID upgrade_id) const
 {
-    initialize_player_upgrades(player_id);
-    auto &player_data = player_upgrades_[player_id];
-
-    auto upgrade_it = player_data.upgrades.find(upgrade_name);
-    if (upgrade_it == player_data.upgrades.end())
+    auto player_it = player_upgrades_.find(player_id);
+    if (player_it == player_upgrades_.end() || upgrade_id >= player_it->second.upgrades.size())
     {
-        return false;
+        return nullptr;
     }
-
-    return upgrade_it->second->apply_upgrade(player_id);
+    return player_it->second.upgrades[upgrade_id].get();
 }
 
-bool UpgradeManager::can_purchase_upgrade(PlayerID player_id, const std::string &upgrade_name) const
+bool UpgradeManager::purchase_upgrade(PlayerID player_id, NameID upgrade_id)
 {
-    auto player_it = player_upgrades_.find(player_id);
-    if (player_it == player_upgrades_.end())
+    if (upgrade_id >= upgrade_names_.size())
     {
         return false;
     }
 
-    auto upgrade_it = player_it->second.upgrades.find(upgrade_name);
-    if (upgrade_it == player_it->second.upgrades.end())
-    {
-        return false;
-    }
+    initialize_player_upgrades(player_id);
+    return player_upgrades_[player_id].upgrades[upgrade_id]->apply_upgrade(player_id);
+}
 
-    return upgrade_it->second->can_upgrade(player_id);
+bool UpgradeManager::purchase_upgrade(PlayerID player_id, const std::string &upgrade_name)
+{
+    return purchase_upgrade(player_id, upgrade_names_.find(upgrade_name));
 }
 
-float UpgradeManager::get_modifier(PlayerID player_id, const std::string &upgrade_name, const std::string &attribute) const
+bool UpgradeManager::can_purchase_upgrade(PlayerID player_id, NameID upgrade_id) const
 {
-    auto player_it = player_upgrades_.find(player_id);
-    if (player_it == player_upgrades_.end())
-    {
-        return 1.0f;
-    }
+    const Upgrade *upgrade = find_upgrade(player_id, upgrade_id);
+    return upgrade && upgrade->can_upgrade(player_id);
+}
 
-    auto upgrade_it = player_it->second.upgrades.find(upgrade_name);
-    if (upgrade_it == player_it->second.upgrades.end())
+bool UpgradeManager::can_purchase_upgrade(PlayerID player_id, const std::string &upgrade_name) const
+{
+    return can_purchase_upgrade(player_id, upgrade_names_.find(upgrade_name));
+}
+
+float UpgradeManager::get_modifier(PlayerID player_id, const std::string &upgrade_name, const std::string &attribute) const
+{
+    const Upgrade *upgrade = find_upgrade(player_id, upgrade_names_.find(upgrade_name));
+    if (!upgrade)
     {
         return 1.0f;
     }
 
-    return upgrade_it->second->get_total_modifier(attribute);
+    return upgrade->get_total_modifier(attribute);
 }
 
-bool UpgradeManager::unlock_technology(PlayerID player_id, const std::string &tech_name)
+bool UpgradeManager::unlock_technology(PlayerID player_id, NameID tech_id)
 {
+    if (tech_id >= technology_names_.size())
+    {
+        return false;
+    }
+
     initialize_player_upgrades(player_id);
     auto &technologies = player_upgrades_[player_id].completed_technologies;
-
-    if (std::find(technologies.begin(), technologies.end(), tech_name) != technologies.end())
+    if (technologies[tech_id])
     {
         return false; // Already unlocked
     }
 
-    technologies.push_back(tech_name);
+    technologies[tech_id] = true;
     return true;
 }
 
-bool UpgradeManager::has_technology(PlayerID player_id, const std::string &tech_name) const
+bool UpgradeManager::unlock_technology(PlayerID player_id, const std::string &tech_name)
+{
+    return unlock_technology(player_id, technology_names_.find(tech_name));
+}
+
+bool UpgradeManager::has_technology(PlayerID player_id, NameID tech_id) const
 {
     auto player_it = player_upgrades_.find(player_id);
-    if (player_it == player_upgrades_.end())
+    if (player_it == player_upgrades_.end() || tech_id >= technology_names_.size())
     {
         return false;
     }
 
-    const auto &technologies = player_it->second.completed_technologies;
-    return std::find(technologies.begin(), technologies.end(), tech_name) != technologies.end();
+    return player_it->second.completed_technologies[tech_id];
 }
 
-std::vector<std::string> UpgradeManager::get_available_technologies(PlayerID player_id) const
+bool UpgradeManager::has_technology(PlayerID player_id, const std::string &tech_name) const
 {
-    std::vector<std::string> available = {
-        "Basic Smithing",
-        "Basic Armory",
-        "Military Tactics",
-        "Economic Development",
-        "Construction Mastery"};
+    return has_technology(player_id, technology_names_.find(tech_name));
+}
 
-    // Filter out already completed technologies
-    auto player_it = player_upgrades_.find(player_id);
-    if (player_it != player_upgrades_.end())
+std::vector<NameID> UpgradeManager::get_available_technology_ids(PlayerID player_id) const
+{
+    // Every technology not yet completed
+    std::vector<NameID> available;
+    for (NameID id = 0; id < technology_names_.size(); ++id)
     {
-        const auto &completed = player_it->second.completed_technologies;
-        available.erase(
-            std::remove_if(available.begin(), available.end(),
-                           [&completed](const std::string &tech)
-                           {
-                               return std::find(completed.begin(), completed.end(), tech) != completed.end();
-                           }),
-            available.end());
+        if (!has_technology(player_id, id))
+        {
+            available.push_back(id);
+        }
     }
-
     return available;
 }
 
-std::vector<std::string> UpgradeManager::get_available_upgrades(PlayerID player_id) const
+std::vector<std::string> UpgradeManager::get_available_technologies(PlayerID player_id) const
 {
-    std::vector<std::string> available;
-    auto player_it = player_upgrades_.find(player_id);
-    if (player_it != player_upgrades_.end())
+    return to_names(get_available_technology_ids(player_id), technology_names_);
+}
+
+std::vector<NameID> UpgradeManager::get_available_upgrade_ids(PlayerID player_id) const
+{
+    std::vector<NameID> available;
+    for (NameID id = 0; id < upgrade_names_.size(); ++id)
     {
-        for (const auto &[name, upgrade] : player_it->second.upgrades)
+        if (can_purchase_upgrade(player_id, id))
         {
-            if (upgrade->can_upgrade(player_id))
-            {
-                available.push_back(name);
-            }
+            available.push_back(id);
         }
     }
     return available;
 }
 
+std::vector<std::string> UpgradeManager::get_available_upgrades(PlayerID player_id) const
+{
+    return to_names(get_available_upgrade_ids(player_id), upgrade_names_);
+}
+
+int UpgradeManager::get_upgrade_level(PlayerID player_id, NameID upgrade_id) const
+{
+    const Upgrade *upgrade = find_upgrade(player_id, upgrade_id);
+    return upgrade ? upgrade->get_level() : 0;
+}
+
 int UpgradeManager::get_upgrade_level(PlayerID player_id, const std::string &upgrade_name) const
 {
-    auto player_it = player_upgrades_.find(player_id);
-    if (player_it == player_upgrades_.end())
-    {
-        return 0;
-    }
+    return get_upgrade_level(player_id, upgrade_names_.find(upgrade_name));
+}
 
-    auto upgrade_it = player_it->second.upgrades.find(upgrade_name);
-    if (upgrade_it == player_it->second.upgrades.end())
+size_t UpgradeManager::get_memory_usage() const
+{
+    size_t bytes = memory_usage::of(player_upgrades_);
+    for (const auto &[player_id, upgrades] : player_upgrades_)
     {
-        return 0;
+        bytes += memory_usage::of(upgrades.upgrades) + upgrades.completed_technologies.capacity() / 8;
+        for (const auto &upgrade : upgrades.upgrades)
+        {
+            bytes += upgrade ? upgrade->get_memory_usage() : 0;
+        }
     }
-
-    return upgrade_it->second->get_level();
+    return bytes;
 }
\ No newline at end of file
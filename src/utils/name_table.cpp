@@ -0,0 +1,16 @@
+#include "utils/name_table.hpp"
+
+NameTable::NameTable(std::vector<std::string> names)
+    : names_(std::move(names))
+{
+    for (size_t i = 0; i < names_.size(); ++i)
+    {
+        ids_.emplace(names_[i], static_cast<NameID>(i));
+    }
+}
+
+NameID NameTable::find(const std::string &name) const
+{
+    auto it = ids_.find(name);
+    return it != ids_.end() ? it->second : invalid_id;
+}
\ No newline at end of file
@@ -0,0 +1,667 @@
+// Opens many loopback client connections, drives them with scripted bot traffic and reports
+// round-trip latency per message type and the sustained message rate.
+// Usage: castle-loadgen [--port N] [--clients N] [--threads N] [--duration S]
+//                       [--move-rate R] [--attack-rate R] [--upgrade-rate R] [--chat-rate R]
+//                       [--embedded] [--server-threads N] [--room-threads N] [--room-size N] [--lockstep]
+//                       [--record-replays DIR]
+//   Rates are per bot per second; 0 disables that behaviour. Upgrade traffic rotates through
+//   upgrade, technology and upgrade list requests.
+//   --embedded runs the server in this process, so one command measures a build end to end, and
+//   reports its rooms at their peak count: how many, and the memory each held.
+//   Moves and attacks get no reply; they are counted but have no latency.
+//   --lockstep expects lockstep rooms (and makes embedded ones so): each bot keeps a lockstep peer
+//   and reports its checksum after every turn. Its moves and attacks name units from the peer's
+//   world.
+//   --record-replays has embedded rooms record their matches; play them with castle-replay.
+
+#include "server/server_runtime.hpp"
+#include "server/lockstep.hpp"
+#include "networking/message_payloads.hpp"
+#include "networking/message_utils.hpp"
+#include "upgrades/upgrade_manager.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <sys/resource.h>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Request types whose reply the bot can match to the request
+    enum class Probe
+    {
+        Connect,
+        Upgrade,
+        Technology,
+        UpgradeList,
+        Chat,
+        Count
+    };
+    constexpr size_t probe_count = static_cast<size_t>(Probe::Count);
+    constexpr const char *probe_names[probe_count] = {"connect", "upgrade", "technology", "upgrade list", "chat"};
+
+    enum class Action
+    {
+        Move,
+        Attack,
+        Upgrade,
+        Chat,
+        Count
+    };
+    constexpr size_t action_count = static_cast<size_t>(Action::Count);
+
+    // Replies still outstanding this long after the run are counted as unanswered
+    constexpr auto drain_grace = std::chrono::milliseconds(500);
+    constexpr size_t read_buffer_size = 64 * 1024;
+
+    struct Settings
+    {
+        tcp::endpoint endpoint;
+        std::array<double, action_count> rates{10.0, 2.0, 1.0, 0.05};
+        Clock::time_point end_time;
+        std::vector<std::string> upgrade_names;
+        std::vector<std::string> technology_names;
+        bool lockstep{false};
+    };
+
+    // Per loadgen thread; merged once every thread is done
+    struct LoadStats
+    {
+        std::array<std::vector<double>, probe_count> latencies_us;
+        std::array<std::uint64_t, action_count> actions{};
+        std::uint64_t messages_sent{0};
+        std::uint64_t messages_received{0};
+        std::uint64_t connect_failures{0};
+        std::uint64_t disconnects{0};
+        std::uint64_t unanswered{0};
+        std::uint64_t lockstep_turns{0};
+        std::uint64_t lockstep_rejected{0}; // Turns a peer could not apply
+        std::uint64_t desync_notices{0};
+
+        void merge(const LoadStats &other)
+        {
+            for (size_t i = 0; i < probe_count; ++i)
+            {
+                latencies_us[i].insert(latencies_us[i].end(), other.latencies_us[i].begin(), other.latencies_us[i].end());
+            }
+            for (size_t i = 0; i < action_count; ++i)
+            {
+                actions[i] += other.actions[i];
+            }
+            messages_sent += other.messages_sent;
+            messages_received += other.messages_received;
+            connect_failures += other.connect_failures;
+            disconnects += other.disconnects;
+            unanswered += other.unanswered;
+            lockstep_turns += other.lockstep_turns;
+            lockstep_rejected += other.lockstep_rejected;
+            desync_notices += other.desync_notices;
+        }
+    };
+
+    class Bot : public std::enable_shared_from_this<Bot>
+    {
+    public:
+        Bot(boost::asio::io_context &io_context, size_t index, const Settings &settings, LoadStats &stats)
+            : socket_(io_context), timer_(io_context), index_(index), settings_(settings), stats_(stats),
+              random_(static_cast<std::mt19937::result_type>(index)), read_buffer_(read_buffer_size),
+              chat_tag_("bot" + std::to_string(index) + ":")
+        {
+            if (settings_.lockstep)
+            {
+                lockstep_peer_ = std::make_unique<LockstepPeer>();
+            }
+        }
+
+        void start()
+        {
+            auto self = shared_from_this();
+            socket_.async_connect(settings_.endpoint, [this, self](const boost::system::error_code &ec)
+                                  {
+                                      if (ec)
+                                      {
+                                          ++stats_.connect_failures;
+                                          return;
+                                      }
+                                      socket_.set_option(tcp::no_delay(true));
+                                      // Gives up at the end of the run if the handshake never completes
+                                      wait_for_next_action();
+                                      send(Message::create_connect("bot" + std::to_string(index_)), Probe::Connect);
+                                      read(); });
+        }
+
+    private:
+        void send(const Message &message)
+        {
+            message_utils::write_frame(pending_writes_, message);
+            ++stats_.messages_sent;
+            if (!writing_)
+            {
+                flush();
+            }
+        }
+
+        void send(const Message &message, Probe probe)
+        {
+            outstanding_[static_cast<size_t>(probe)].push_back(Clock::now());
+            send(message);
+        }
+
+        void flush()
+        {
+            writing_ = true;
+            in_flight_.swap(pending_writes_);
+            pending_writes_.clear();
+            auto self = shared_from_this();
+            boost::asio::async_write(socket_, boost::asio::buffer(in_flight_),
+                                     [this, self](const boost::system::error_code &ec, size_t)
+                                     {
+                                         writing_ = false;
+                                         if (!ec && !pending_writes_.empty() && socket_.is_open())
+                                         {
+                                             flush();
+                                         }
+                                     });
+        }
+
+        void read()
+        {
+            auto self = shared_from_this();
+            socket_.async_read_some(boost::asio::buffer(read_buffer_.data() + read_used_, read_buffer_.size() - read_used_),
+                                    [this, self](const boost::system::error_code &ec, size_t bytes)
+                                    {
+                                        if (ec)
+                                        {
+                                            if (!finished_)
+                                            {
+                                                ++stats_.disconnects;
+                                                finish();
+                                            }
+                                            return;
+                                        }
+                                        read_used_ += bytes;
+                                        consume_replies();
+                                        read();
+                                    });
+        }
+
+        // Server messages are serialized Messages back to back: [type u8][u32 size][data]
+        void consume_replies()
+        {
+            const size_t header_size = sizeof(MessageType) + sizeof(uint32_t);
+            size_t offset = 0;
+            while (read_used_ - offset >= header_size)
+            {
+                uint32_t size;
+                std::memcpy(&size, read_buffer_.data() + offset + sizeof(MessageType), sizeof(size));
+                if (header_size + size > read_buffer_.size())
+                {
+                    std::cerr << "Reply larger than the read buffer\n";
+                    finish();
+                    return;
+                }
+                if (read_used_ - offset < header_size + size)
+                {
+                    break;
+                }
+                MessageView view;
+                if (Message::parse(read_buffer_.data() + offset, header_size + size, view))
+                {
+                    handle_reply(view);
+                }
+                offset += header_size + size;
+            }
+            std::memmove(read_buffer_.data(), read_buffer_.data() + offset, read_used_ - offset);
+            read_used_ -= offset;
+        }
+
+        void handle_reply(const MessageView &view)
+        {
+            ++stats_.messages_received;
+            switch (view.type)
+            {
+            case MessageType::ConnectResponse:
+                record(Probe::Connect);
+                schedule_actions();
+                break;
+            case MessageType::UpgradeResponse:
+                record(Probe::Upgrade);
+                break;
+            case MessageType::TechnologyResponse:
+                record(Probe::Technology);
+                break;
+            case MessageType::UpgradeListResponse:
+                record(Probe::UpgradeList);
+                break;
+            case MessageType::ChatMessage:
+            {
+                // Relays of every bot's chat arrive here; only our own close a round trip
+                payload::ChatBroadcast chat;
+                if (message_schema::decode(view, chat) && chat.text.compare(0, chat_tag_.size(), chat_tag_) == 0)
+                {
+                    record(Probe::Chat);
+                }
+                break;
+            }
+            case MessageType::ResourceUpdate:
+                // A lockstep room's only snapshot is the keyframe. Bots never harvest, so their
+                // own resources, the only ones it carries, do not matter and the id can be 0.
+                if (lockstep_peer_ && !lockstep_peer_->is_loaded())
+                {
+                    lockstep_peer_->load(0, view);
+                }
+                break;
+            case MessageType::LockstepTurn:
+                if (!lockstep_peer_ || !lockstep_peer_->apply(view))
+                {
+                    ++stats_.lockstep_rejected;
+                    break;
+                }
+                ++stats_.lockstep_turns;
+                send(lockstep_peer_->create_state_hash());
+                break;
+            case MessageType::LockstepDesync:
+                ++stats_.desync_notices;
+                break;
+            default:
+                break;
+            }
+        }
+
+        void record(Probe probe)
+        {
+            auto &outstanding = outstanding_[static_cast<size_t>(probe)];
+            if (outstanding.empty())
+            {
+                return;
+            }
+            stats_.latencies_us[static_cast<size_t>(probe)].push_back(
+                std::chrono::duration<double, std::micro>(Clock::now() - outstanding.front()).count());
+            outstanding.pop_front();
+        }
+
+        Clock::duration next_interval(Action action)
+        {
+            // Exponential gaps, so thousands of bots don't fire in lockstep
+            std::exponential_distribution<double> gap(settings_.rates[static_cast<size_t>(action)]);
+            return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(random_)));
+        }
+
+        void schedule_actions()
+        {
+            if (scheduled_)
+            {
+                return;
+            }
+            scheduled_ = true;
+            Clock::time_point now = Clock::now();
+            for (size_t i = 0; i < action_count; ++i)
+            {
+                next_due_[i] = settings_.rates[i] > 0 ? now + next_interval(static_cast<Action>(i)) : Clock::time_point::max();
+            }
+            wait_for_next_action();
+        }
+
+        void wait_for_next_action()
+        {
+            Clock::time_point due = *std::min_element(next_due_.begin(), next_due_.end());
+            bool done = due >= settings_.end_time;
+            timer_.expires_at(done ? settings_.end_time + drain_grace : due);
+            auto self = shared_from_this();
+            timer_.async_wait([this, self, done](const boost::system::error_code &ec)
+                              {
+                                  if (ec || finished_)
+                                  {
+                                      return;
+                                  }
+                                  if (done)
+                                  {
+                                      finish();
+                                      return;
+                                  }
+                                  run_due_actions();
+                                  wait_for_next_action(); });
+        }
+
+        void run_due_actions()
+        {
+            Clock::time_point now = Clock::now();
+            for (size_t i = 0; i < action_count; ++i)
+            {
+                if (next_due_[i] > now)
+                {
+                    continue;
+                }
+                perform(static_cast<Action>(i));
+                ++stats_.actions[i];
+                next_due_[i] += next_interval(static_cast<Action>(i));
+            }
+        }
+
+        // Bots with a lockstep peer know the world, so they name units in it; the room obeys the
+        // orders that happen to be for the bot's own units. Other bots guess ids.
+        uint32_t pick_unit()
+        {
+            if (lockstep_peer_ && lockstep_peer_->is_loaded())
+            {
+                const auto &units = lockstep_peer_->get_game_state().get_unit_handles();
+                if (!units.empty())
+                {
+                    return std::next(units.begin(), static_cast<long>(random_() % units.size()))->first;
+                }
+            }
+            return static_cast<uint32_t>(random_() % 1000);
+        }
+
+        void perform(Action action)
+        {
+            std::uniform_int_distribution<int> coordinate(0, 99);
+            switch (action)
+            {
+            case Action::Move:
+            {
+                std::vector<uint32_t> unit_ids(1 + random_() % 8);
+                for (auto &unit_id : unit_ids)
+                {
+                    unit_id = pick_unit();
+                }
+                send(Message::create_move(coordinate(random_), coordinate(random_), std::move(unit_ids)));
+                break;
+            }
+            case Action::Attack:
+                send(Message::create_attack(pick_unit(), pick_unit()));
+                break;
+            case Action::Upgrade:
+                switch (upgrade_turn_++ % 3)
+                {
+                case 0:
+                    send(Message::create_upgrade_request(pick(settings_.upgrade_names)), Probe::Upgrade);
+                    break;
+                case 1:
+                    send(Message::create_technology_request(pick(settings_.technology_names)), Probe::Technology);
+                    break;
+                default:
+                    send(Message::create_upgrade_list_request(), Probe::UpgradeList);
+                    break;
+                }
+                break;
+            case Action::Chat:
+                send(Message::create_chat(chat_tag_ + std::to_string(chat_sequence_++), false), Probe::Chat);
+                break;
+            case Action::Count:
+                break;
+            }
+        }
+
+        const std::string &pick(const std::vector<std::string> &names)
+        {
+            return names[random_() % names.size()];
+        }
+
+        void finish()
+        {
+            if (finished_)
+            {
+                return;
+            }
+            finished_ = true;
+            for (const auto &outstanding : outstanding_)
+            {
+                stats_.unanswered += outstanding.size();
+            }
+            boost::system::error_code ec;
+            timer_.cancel();
+            socket_.close(ec);
+        }
+
+        tcp::socket socket_;
+        boost::asio::steady_timer timer_;
+        size_t index_;
+        const Settings &settings_;
+        LoadStats &stats_;
+        std::mt19937 random_;
+
+        std::vector<uint8_t> read_buffer_;
+        size_t read_used_{0};
+        std::vector<uint8_t> pending_writes_;
+        std::vector<uint8_t> in_flight_;
+        bool writing_{false};
+        bool finished_{false};
+        bool scheduled_{false};
+
+        std::array<std::deque<Clock::time_point>, probe_count> outstanding_;
+        std::array<Clock::time_point, action_count> next_due_{Clock::time_point::max(), Clock::time_point::max(),
+                                                              Clock::time_point::max(), Clock::time_point::max()};
+        std::unique_ptr<LockstepPeer> lockstep_peer_;
+        std::string chat_tag_;
+        std::uint64_t chat_sequence_{0};
+        size_t upgrade_turn_{0};
+    };
+
+    double percentile(const std::vector<double> &sorted, double fraction)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned short port = 12345;
+    size_t client_count = 1000;
+    size_t thread_count = 1;
+    double duration_seconds = 10;
+    bool embedded = false;
+    size_t server_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t room_threads = server_threads;
+    RoomSettings room_settings;
+    Settings settings;
+    bool bad_arguments = false;
+    for (int i = 1; i < argc && !bad_arguments; ++i)
+    {
+        auto next = [&]()
+        {
+            if (i + 1 >= argc)
+            {
+                bad_arguments = true;
+                return 0.0;
+            }
+            try
+            {
+                return std::stod(argv[++i]);
+            }
+            catch (const std::exception &)
+            {
+                bad_arguments = true;
+                return 0.0;
+            }
+        };
+        if (std::strcmp(argv[i], "--port") == 0)
+            port = static_cast<unsigned short>(next());
+        else if (std::strcmp(argv[i], "--clients") == 0)
+            client_count = static_cast<size_t>(next());
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            thread_count = std::max<size_t>(1, static_cast<size_t>(next()));
+        else if (std::strcmp(argv[i], "--duration") == 0)
+            duration_seconds = next();
+        else if (std::strcmp(argv[i], "--move-rate") == 0)
+            settings.rates[static_cast<size_t>(Action::Move)] = next();
+        else if (std::strcmp(argv[i], "--attack-rate") == 0)
+            settings.rates[static_cast<size_t>(Action::Attack)] = next();
+        else if (std::strcmp(argv[i], "--upgrade-rate") == 0)
+            settings.rates[static_cast<size_t>(Action::Upgrade)] = next();
+        else if (std::strcmp(argv[i], "--chat-rate") == 0)
+            settings.rates[static_cast<size_t>(Action::Chat)] = next();
+        else if (std::strcmp(argv[i], "--embedded") == 0)
+            embedded = true;
+        else if (std::strcmp(argv[i], "--server-threads") == 0)
+            server_threads = static_cast<size_t>(next());
+        else if (std::strcmp(argv[i], "--room-threads") == 0)
+            room_threads = static_cast<size_t>(next());
+        else if (std::strcmp(argv[i], "--room-size") == 0)
+            room_settings.max_players = std::max<size_t>(1, static_cast<size_t>(next()));
+        else if (std::strcmp(argv[i], "--lockstep") == 0)
+            settings.lockstep = room_settings.lockstep = true;
+        else if (std::strcmp(argv[i], "--record-replays") == 0 && i + 1 < argc)
+            room_settings.replay_directory = argv[++i];
+        else
+            bad_arguments = true;
+    }
+    if (bad_arguments)
+    {
+        std::cerr << "Usage: castle-loadgen [--port N] [--clients N] [--threads N] [--duration S]\n"
+                  << "                      [--move-rate R] [--attack-rate R] [--upgrade-rate R] [--chat-rate R]\n"
+                  << "                      [--embedded] [--server-threads N] [--room-threads N] [--room-size N]\n"
+                  << "                      [--lockstep] [--record-replays DIR]" << std::endl;
+        return 1;
+    }
+
+    // Both ends of every connection may live in this process
+    rlimit file_limit;
+    if (getrlimit(RLIMIT_NOFILE, &file_limit) == 0 && file_limit.rlim_cur < file_limit.rlim_max)
+    {
+        file_limit.rlim_cur = file_limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &file_limit);
+    }
+
+    // Request names the server will recognise
+    UpgradeManager upgrade_manager;
+    settings.upgrade_names = upgrade_manager.get_upgrade_names().get_names();
+    settings.technology_names = upgrade_manager.get_technology_names().get_names();
+    if (settings.upgrade_names.empty() || settings.technology_names.empty())
+    {
+        settings.rates[static_cast<size_t>(Action::Upgrade)] = 0;
+    }
+    settings.endpoint = tcp::endpoint(boost::asio::ip::address_v4::loopback(), port);
+
+    std::unique_ptr<ServerRuntime> runtime;
+    std::thread server_thread;
+    if (embedded)
+    {
+        runtime = std::make_unique<ServerRuntime>(NetworkMode::Shared, port, server_threads, room_threads);
+        runtime->get_server().set_room_settings(room_settings);
+        server_thread = std::thread([&runtime]()
+                                    { runtime->run(); });
+    }
+
+    auto start_time = Clock::now();
+    settings.end_time = start_time + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration_seconds));
+    std::vector<LoadStats> thread_stats(thread_count);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t)
+    {
+        threads.emplace_back([&, t]()
+                             {
+                                 boost::asio::io_context io_context;
+                                 for (size_t index = t; index < client_count; index += thread_count)
+                                 {
+                                     std::make_shared<Bot>(io_context, index, settings, thread_stats[t])->start();
+                                 }
+                                 io_context.run(); });
+    }
+
+    // Rooms go as their last bot leaves, so they are sampled while the run is going
+    std::vector<RoomInfo> peak_rooms;
+    if (runtime)
+    {
+        while (Clock::now() + std::chrono::milliseconds(500) < settings.end_time)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            auto rooms = runtime->get_server().get_room_manager().get_room_info();
+            if (rooms.size() >= peak_rooms.size())
+            {
+                peak_rooms = std::move(rooms);
+            }
+        }
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(settings.end_time - start_time).count();
+
+    GameLoopStats tick_stats;
+    if (runtime)
+    {
+        runtime->stop();
+        server_thread.join();
+        tick_stats = runtime->get_server().get_tick_stats();
+    }
+
+    LoadStats stats;
+    for (const auto &partial : thread_stats)
+    {
+        stats.merge(partial);
+    }
+
+    std::cout << "backend:              " << ServerRuntime::get_backend_name() << (embedded ? "" : " (loadgen side)") << "\n"
+              << "clients:              " << client_count << " (" << stats.connect_failures << " failed to connect, "
+              << stats.disconnects << " dropped)\n"
+              << "duration (s):         " << elapsed << "\n"
+              << "messages sent/sec:    " << static_cast<size_t>(stats.messages_sent / elapsed) << "\n"
+              << "messages recv/sec:    " << static_cast<size_t>(stats.messages_received / elapsed) << "\n"
+              << "moves, attacks sent:  " << stats.actions[static_cast<size_t>(Action::Move)] << ", "
+              << stats.actions[static_cast<size_t>(Action::Attack)] << "\n"
+              << "unanswered requests:  " << stats.unanswered << "\n";
+    if (settings.lockstep)
+    {
+        std::cout << "lockstep turns:       " << stats.lockstep_turns << " applied by bots, " << stats.lockstep_rejected
+                  << " rejected, " << stats.desync_notices << " desync notices\n";
+    }
+    if (!peak_rooms.empty())
+    {
+        size_t total_memory = 0;
+        size_t max_memory = 0;
+        LockstepStats lockstep;
+        for (const auto &room : peak_rooms)
+        {
+            total_memory += room.memory.total();
+            max_memory = std::max(max_memory, room.memory.total());
+            lockstep.hashes_checked += room.lockstep.hashes_checked;
+            lockstep.unverifiable += room.lockstep.unverifiable;
+            lockstep.desyncs += room.lockstep.desyncs;
+        }
+        std::cout << "rooms at peak:        " << peak_rooms.size() << " (" << room_threads << " room threads), "
+                  << total_memory / 1024 << " KB, per room mean " << total_memory / peak_rooms.size() / 1024
+                  << " KB, max " << max_memory / 1024 << " KB\n";
+        if (settings.lockstep)
+        {
+            std::cout << "checksums at peak:    " << lockstep.hashes_checked << " checked, " << lockstep.unverifiable
+                      << " unverifiable, " << lockstep.desyncs << " desyncs\n";
+        }
+    }
+    if (runtime && tick_stats.ticks)
+    {
+        std::cout << "server ticks:         " << tick_stats.ticks << " (" << tick_stats.late_ticks << " late, "
+                  << tick_stats.skipped_ticks << " skipped, " << tick_stats.over_budget << " over budget)\n"
+                  << "tick time (us):       mean " << tick_stats.total_tick_time.count() / 1000 / tick_stats.ticks
+                  << ", max " << tick_stats.max_tick_time.count() / 1000 << "\n";
+    }
+    std::cout << "round trip (us)       count\tp50\tp99\tp999\tmax\n";
+    for (size_t i = 0; i < probe_count; ++i)
+    {
+        auto &samples = stats.latencies_us[i];
+        if (samples.empty())
+        {
+            continue;
+        }
+        std::sort(samples.begin(), samples.end());
+        std::string name = probe_names[i];
+        name.resize(22, ' ');
+        std::cout << name << samples.size() << "\t" << percentile(samples, 0.5) << "\t" << percentile(samples, 0.99)
+                  << "\t" << percentile(samples, 0.999) << "\t" << samples.back() << "\n";
+    }
+    return stats.connect_failures != 0;
+}
\ No newline at end of file